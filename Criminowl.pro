@@ -7,7 +7,7 @@ MOC_DIR = moc
 UI_DIR = ui
 
 QT += opengl core gui
-CONFIG += console c++14
+CONFIG += console c++14 thread
 CONFIG -= app_bundle
 
 
@@ -39,6 +39,23 @@ HEADERS += \
     include/Scene.h \
     include/DemoScene.h \
     include/ShaderLib.h \
+    include/UniformBuffer.h \
+    include/MaterialParams.h \
+    include/FrameConstants.h \
+    include/ShaderPreprocessor.h \
+    include/HashUtils.h \
+    include/TextureFile.h \
+    include/TextureIO.h \
+    include/ThreadPool.h \
+    include/SphericalHarmonics.h \
+    include/FramebufferPool.h \
+    include/ImageMetrics.h \
+    include/HalfFloat.h \
+    include/BrdfLut.h \
+    include/HdrImage.h \
+    include/BrickVolume.h \
+    include/BlockCompression.h \
+    include/OwlNoise.h \
     include/MeshVBO.h \
     include/TriMesh.h \
     include/Edge.h
@@ -54,6 +71,20 @@ SOURCES += \
     src/Scene.cpp \
     src/DemoScene.cpp \
     src/ShaderLib.cpp \
+    src/UniformBuffer.cpp \
+    src/ShaderPreprocessor.cpp \
+    src/TextureFile.cpp \
+    src/TextureIO.cpp \
+    src/ThreadPool.cpp \
+    src/SphericalHarmonics.cpp \
+    src/FramebufferPool.cpp \
+    src/ImageMetrics.cpp \
+    src/BrdfLut.cpp \
+    src/HalfFloat.cpp \
+    src/HdrImage.cpp \
+    src/BrickVolume.cpp \
+    src/BlockCompression.cpp \
+    src/OwlNoise.cpp \
     src/MeshVBO.cpp \
     src/TriMesh.cpp
 
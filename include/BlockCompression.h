@@ -0,0 +1,101 @@
+#ifndef BLOCKCOMPRESSION_H
+#define BLOCKCOMPRESSION_H
+
+#include "TextureFile.h"
+#include "ImageMetrics.h"
+
+class ThreadPool;
+
+//-------------------------------------------------------------------------------------------------------
+/// @brief A CPU encoder for BC6H, the block compressed HDR format, so baked textures can be stored and
+/// sampled at a sixth of the size of RGB16F. Each 4x4 block gets a pair of endpoints and a 4 bit index
+/// per texel, using whichever of the one region modes fits best. Compressed TextureFiles have no pixel
+/// format or type, and their bytes per pixel is the size of a block.
+//-------------------------------------------------------------------------------------------------------
+namespace BlockCompression
+{
+//-------------------------------------------------------------------------------------------------------
+/// @brief The number of texels along each side of a block.
+//-------------------------------------------------------------------------------------------------------
+constexpr uint32_t k_blockDim = 4;
+//-------------------------------------------------------------------------------------------------------
+/// @brief The size of a compressed block in bytes.
+//-------------------------------------------------------------------------------------------------------
+constexpr uint32_t k_blockBytes = 16;
+//-------------------------------------------------------------------------------------------------------
+/// @brief GL_COMPRESSED_RGB_BPTC_UNSIGNED_FLOAT, by value as TextureFile is independent of GL.
+//-------------------------------------------------------------------------------------------------------
+constexpr uint32_t k_glBC6H = 0x8E8F;
+//-------------------------------------------------------------------------------------------------------
+/// @brief Maps the values stored in a normalized texture back to the originals, value * scale + bias.
+//-------------------------------------------------------------------------------------------------------
+struct Range
+{
+  float m_scale[3] = {1.0f, 1.0f, 1.0f};
+  float m_bias[3] = {0.0f, 0.0f, 0.0f};
+  //-----------------------------------------------------------------------------------------------------
+  /// @brief Used to store the range alongside it's texture, as a two texel RGB32F texture.
+  //-----------------------------------------------------------------------------------------------------
+  TextureFile toFile() const;
+  //-----------------------------------------------------------------------------------------------------
+  /// @brief Used to read back a range written by toFile.
+  /// @return false if the file doesn't hold a range, which is then left unchanged.
+  //-----------------------------------------------------------------------------------------------------
+  bool fromFile(const TextureFile &_file);
+};
+//-------------------------------------------------------------------------------------------------------
+/// @brief Encodes one block.
+/// @param [in] _texels are the half float RGB values of the block, in rows. Negative values are clamped
+/// to zero.
+/// @param [out] o_block receives the compressed block.
+//-------------------------------------------------------------------------------------------------------
+void encodeBlock(const uint16_t _texels[16][3], unsigned char o_block[16]) noexcept;
+//-------------------------------------------------------------------------------------------------------
+/// @brief Decodes one block.
+/// @param [in] _block is the compressed block.
+/// @param [out] o_texels receives the half float RGB values of the block.
+/// @return false if the block uses a mode with two regions, which we never write, in which case the
+/// texels are zero.
+//-------------------------------------------------------------------------------------------------------
+bool decodeBlock(const unsigned char _block[16], uint16_t o_texels[16][3]) noexcept;
+//-------------------------------------------------------------------------------------------------------
+/// @brief Compresses every level, face and slice of an HDR colour texture. Slices of 3D textures are
+/// compressed separately, as the GPU expects.
+/// @param [in] _texture has three or four half float channels, alpha is discarded.
+/// @param [io] io_pool is used to encode rows of blocks in parallel.
+/// @return the compressed texture, ready to upload or save.
+//-------------------------------------------------------------------------------------------------------
+TextureFile encode(const TextureFile &_texture, ThreadPool &io_pool);
+//-------------------------------------------------------------------------------------------------------
+/// @brief Compresses a texture of signed or non colour data. Each channel is first fitted to [1, 2),
+/// where BC6H is linear and evenly precise, so the texture must be read through the returned range.
+/// @param [in] _texture has three or four half float channels, alpha is discarded.
+/// @param [out] o_range receives the mapping back to the original values.
+/// @param [io] io_pool is used to encode rows of blocks in parallel.
+/// @return the compressed texture, ready to upload or save.
+//-------------------------------------------------------------------------------------------------------
+TextureFile encode(const TextureFile &_texture, Range &o_range, ThreadPool &io_pool);
+//-------------------------------------------------------------------------------------------------------
+/// @brief Decompresses a texture returned by encode, without applying any range.
+/// @param [in] _texture is the compressed texture.
+/// @param [io] io_pool is used to decode rows of blocks in parallel.
+/// @return an RGB16F texture.
+//-------------------------------------------------------------------------------------------------------
+TextureFile decode(const TextureFile &_texture, ThreadPool &io_pool);
+//-------------------------------------------------------------------------------------------------------
+/// @brief Measures the loss of compression, over the RGB channels of every level and face.
+/// @param [in] _compressed is the texture returned by encode.
+/// @param [in] _source is the texture that was encoded.
+/// @param [in] _range is the range the texture was normalized to, if any.
+/// @param [io] io_pool is used to decode in parallel.
+/// @return the error of the compressed texture, with the largest source magnitude as the peak.
+//-------------------------------------------------------------------------------------------------------
+ImageMetrics::Error measure(
+    const TextureFile &_compressed,
+    const TextureFile &_source,
+    const Range &_range,
+    ThreadPool &io_pool
+    );
+}
+
+#endif // BLOCKCOMPRESSION_H
@@ -0,0 +1,29 @@
+#ifndef BRDFLUT_H
+#define BRDFLUT_H
+
+#include "TextureFile.h"
+
+class ThreadPool;
+
+//-------------------------------------------------------------------------------------------------------
+/// @brief CPU generation of the split sum BRDF lookup table. The table only depends on the BRDF, so it
+/// is generated offline, shipped with the application and loaded directly. This is a port of
+/// hdr_cubemap_brdf_frag.glsl, which remains as a GPU fallback.
+//-------------------------------------------------------------------------------------------------------
+namespace BrdfLut
+{
+//-------------------------------------------------------------------------------------------------------
+/// @brief The shipped table.
+//-------------------------------------------------------------------------------------------------------
+constexpr const char* k_assetPath = "images/brdf_lut.tex";
+//-------------------------------------------------------------------------------------------------------
+/// @brief Integrates the scale and bias applied to F0, for every view angle and roughness.
+/// @param [in] _dim is the width and height of the table, x is N.V and y is roughness.
+/// @param [in] _samples is the number of GGX importance samples per texel.
+/// @param [io] io_pool is used to generate rows in parallel.
+/// @return an RG16F texture with a single level, which can be saved or uploaded with TextureIO.
+//-------------------------------------------------------------------------------------------------------
+TextureFile generate(const int _dim, const unsigned _samples, ThreadPool &io_pool);
+}
+
+#endif // BRDFLUT_H
@@ -0,0 +1,124 @@
+#ifndef BRICKVOLUME_H
+#define BRICKVOLUME_H
+
+#include <vector>
+#include <cstdint>
+#include "vec3.hpp"
+
+//-------------------------------------------------------------------------------------------------------
+/// @brief One mip level of a sparse volume. Each level only covers the box that the surface's band passes
+/// through, so it's texels are offset from those of the whole volume at the same resolution.
+//-------------------------------------------------------------------------------------------------------
+struct BrickLevel
+{
+  //-----------------------------------------------------------------------------------------------------
+  /// @brief The size of the whole volume at this level, in texels along each axis.
+  //-----------------------------------------------------------------------------------------------------
+  int m_dim = 0;
+  //-----------------------------------------------------------------------------------------------------
+  /// @brief The texel of the whole volume that the first texel of this level maps to.
+  //-----------------------------------------------------------------------------------------------------
+  glm::ivec3 m_origin {0};
+  //-----------------------------------------------------------------------------------------------------
+  /// @brief The number of bricks along each axis of this level.
+  //-----------------------------------------------------------------------------------------------------
+  glm::ivec3 m_bricks {0};
+  //-----------------------------------------------------------------------------------------------------
+  /// @brief The first slice of the indirection that holds this level.
+  //-----------------------------------------------------------------------------------------------------
+  int m_indirectionSlice = 0;
+  //-----------------------------------------------------------------------------------------------------
+  /// @brief The range of this level's bricks, in pool order.
+  //-----------------------------------------------------------------------------------------------------
+  int m_firstBrick = 0;
+  int m_numBricks = 0;
+};
+
+//-------------------------------------------------------------------------------------------------------
+/// @brief Describes which bricks of a sparse, mipmapped volume are stored, and where. Each level is split
+/// in to bricks of k_brickDim texels, and only bricks within a band around a surface are kept. Each stored
+/// brick is padded with a one texel apron, so that filtering never needs to read a neighbouring brick.
+//-------------------------------------------------------------------------------------------------------
+struct BrickLayout
+{
+  //-----------------------------------------------------------------------------------------------------
+  /// @brief The size of the whole volume at the finest level, in texels along each axis.
+  //-----------------------------------------------------------------------------------------------------
+  int m_dim = 0;
+  //-----------------------------------------------------------------------------------------------------
+  /// @brief The levels from finest to coarsest, the last level is a single brick.
+  //-----------------------------------------------------------------------------------------------------
+  std::vector<BrickLevel> m_levels;
+  //-----------------------------------------------------------------------------------------------------
+  /// @brief The number of padded bricks along each axis of the pool texture.
+  //-----------------------------------------------------------------------------------------------------
+  glm::ivec3 m_poolBricks {0};
+  //-----------------------------------------------------------------------------------------------------
+  /// @brief The size of the indirection texture, which stacks the levels along z.
+  //-----------------------------------------------------------------------------------------------------
+  glm::ivec3 m_indirectionSize {0};
+  //-----------------------------------------------------------------------------------------------------
+  /// @brief One RGBA8UI texel per brick of each level, xyz is the brick's position in the pool and w is
+  /// 255 if the brick is stored, or zero if it isn't.
+  //-----------------------------------------------------------------------------------------------------
+  std::vector<uint8_t> m_indirection;
+  //-----------------------------------------------------------------------------------------------------
+  /// @brief The brick coordinate of every stored brick in pool order, packed as
+  /// x | y << 8 | z << 16 | level << 24. The levels are stored in order, finest first.
+  //-----------------------------------------------------------------------------------------------------
+  std::vector<uint32_t> m_bricks;
+};
+
+//-------------------------------------------------------------------------------------------------------
+/// @brief Narrow band brick storage for the owl's solid textures. The material only samples them on the
+/// displaced surface of the mesh, so the layout is computed from the mesh on the CPU, and the bake and
+/// material programs go through the indirection in shaders/include/brick_volume.h.
+//-------------------------------------------------------------------------------------------------------
+namespace BrickVolume
+{
+//-------------------------------------------------------------------------------------------------------
+/// @brief The number of texels along each side of a brick, this must match brick_volume.h.
+//-------------------------------------------------------------------------------------------------------
+constexpr int k_brickDim = 8;
+//-------------------------------------------------------------------------------------------------------
+/// @brief The number of texels along each side of a stored brick, including the apron.
+//-------------------------------------------------------------------------------------------------------
+constexpr int k_paddedDim = k_brickDim + 2;
+//-------------------------------------------------------------------------------------------------------
+/// @brief The most levels a layout can have, this must match brick_volume.h.
+//-------------------------------------------------------------------------------------------------------
+constexpr int k_maxLevels = 10;
+//-------------------------------------------------------------------------------------------------------
+/// @brief Finds every brick that a displaced surface passes through, at every level from _dim down to a
+/// single brick. Each triangle is swept along it's vertex normals between the displacement bounds, and
+/// split until the bounds of every piece are about a brick across, so the band stays tight around curved
+/// and diagonal surfaces. Each level is fitted to the bounds of the swept surface.
+/// @param [in] _vertices are the surface positions, in the space the material samples in.
+/// @param [in] _normals are the per vertex normals that displacement moves along.
+/// @param [in] _indices are the triangle indices.
+/// @param [in] _scale and _offset map positions to volume coordinates, as in owl_pbr_frag.glsl.
+/// @param [in] _minDisp and _maxDisp bound the displacement along the normals.
+/// @param [in] _dim is the size of the whole volume at the finest level, which must be a power of two.
+/// @param [in] _maxPoolDim is the largest texture size the pool can use along each axis.
+/// @return the layout, which is empty if the pool or the indirection wouldn't fit.
+//-------------------------------------------------------------------------------------------------------
+BrickLayout build(
+    const std::vector<glm::vec3> &_vertices,
+    const std::vector<glm::vec3> &_normals,
+    const std::vector<uint16_t> &_indices,
+    const float _scale,
+    const glm::vec3 &_offset,
+    const float _minDisp,
+    const float _maxDisp,
+    const int _dim,
+    const int _maxPoolDim
+    );
+//-------------------------------------------------------------------------------------------------------
+/// @brief Used to get the size of a pool texture, in bytes.
+/// @param [in] _layout is the layout of the pool.
+/// @param [in] _bytesPerTexel is the size of one texel of the pool's format.
+//-------------------------------------------------------------------------------------------------------
+size_t poolBytes(const BrickLayout &_layout, const size_t _bytesPerTexel) noexcept;
+}
+
+#endif // BRICKVOLUME_H
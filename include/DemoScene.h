@@ -4,6 +4,8 @@
 #include "Scene.h"
 #include "MaterialPBR.h"
 #include "ShaderLib.h"
+#include <QOpenGLTimerQuery>
+#include <array>
 
 
 class DemoScene : public Scene
@@ -179,11 +181,27 @@ public slots:
   //-----------------------------------------------------------------------------------------------------
   void tessMaskCapUpdate(const double _cap);
   //-----------------------------------------------------------------------------------------------------
+  /// @brief Used to link a Qt button to the scene, to pick which of the owl's colours is edited.
+  /// @param [in] _layer is zero for the base colour, or one of the noise layers after it.
+  //-----------------------------------------------------------------------------------------------------
+  void paletteLayerUpdate(const int _layer);
+  //-----------------------------------------------------------------------------------------------------
+  /// @brief Used to link a Qt button to the scene, opens a colour dialog for the picked layer.
+  //-----------------------------------------------------------------------------------------------------
+  void paletteColourUpdate();
+  //-----------------------------------------------------------------------------------------------------
   /// @brief Used to link a Qt button to the scene, to allow switching between meshes in the scene, this
   /// calls loadMesh.
   //-----------------------------------------------------------------------------------------------------
   void generateNewGeometry();
 
+signals:
+  //-----------------------------------------------------------------------------------------------------
+  /// @brief Emitted every k_drawSamples timed frames, with the average GPU time of the owl's draw.
+  /// @param [in] _ms is the average time in milliseconds.
+  //-----------------------------------------------------------------------------------------------------
+  void drawTimeMeasured(const double _ms);
+
 private:
   //-----------------------------------------------------------------------------------------------------
   /// @brief Used to write our mesh data into the vbo.
@@ -223,6 +241,20 @@ private:
   /// @brief The materials used in this scene.
   //-----------------------------------------------------------------------------------------------------
   std::unique_ptr<MaterialPBR> m_material;
+  //-----------------------------------------------------------------------------------------------------
+  /// @brief The colour that the palette dialog edits.
+  //-----------------------------------------------------------------------------------------------------
+  size_t m_paletteLayer = 0;
+  //-----------------------------------------------------------------------------------------------------
+  /// @brief Times the owl's draw on the GPU, the timings are summed over k_drawSamples before reporting.
+  /// Two timers alternate between frames, so that one can be read while the other is in flight.
+  //-----------------------------------------------------------------------------------------------------
+  static constexpr int k_drawSamples = 120;
+  std::array<QOpenGLTimerQuery, 2> m_drawTimers;
+  std::array<bool, 2> m_drawTimerPending {{false, false}};
+  size_t m_drawTimerIndex = 0;
+  double m_drawTime = 0.0;
+  int m_drawSamples = 0;
 
 
 };
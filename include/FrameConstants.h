@@ -0,0 +1,26 @@
+#ifndef FRAMECONSTANTS_H
+#define FRAMECONSTANTS_H
+
+#include <mat4x4.hpp>
+#include "vec3.hpp"
+
+//-------------------------------------------------------------------------------------------------------
+/// @brief CPU side mirror of the std140 FrameConstants uniform block declared in
+/// shaders/include/frame_constants.h. glm and GLSL are both column major, so the matrices are copied
+/// straight into the buffer without any conversion.
+//-------------------------------------------------------------------------------------------------------
+struct FrameConstants
+{
+  glm::mat4 M   = glm::mat4(1.0f);
+  glm::mat4 V   = glm::mat4(1.0f);
+  glm::mat4 P   = glm::mat4(1.0f);
+  glm::mat4 MVP = glm::mat4(1.0f);
+  glm::mat4 N   = glm::mat4(1.0f);
+  glm::vec3 camPos {0.0f, 0.0f, 0.0f};
+  // Pad the vec3 out to a vec4
+  float padding = 0.0f;
+};
+
+static_assert(sizeof(FrameConstants) % 16 == 0, "FrameConstants must be padded to a multiple of 16 bytes");
+
+#endif // FRAMECONSTANTS_H
@@ -0,0 +1,74 @@
+#ifndef FRAMEBUFFERPOOL_H
+#define FRAMEBUFFERPOOL_H
+
+#include <QOpenGLContext>
+#include <vector>
+
+//-------------------------------------------------------------------------------------------------------
+/// @brief Hands out framebuffer objects for our offscreen bakes. Each framebuffer is created once and
+/// kept after release, so repeated bakes only change attachments and never allocate. Targets are color
+/// only because none of our bakes need a depth test.
+//-------------------------------------------------------------------------------------------------------
+class FramebufferPool
+{
+public:
+  //-----------------------------------------------------------------------------------------------------
+  /// @brief Sets the context used to create and bind framebuffers, this must be current for every call.
+  /// @param [io] io_context is the GL context.
+  //-----------------------------------------------------------------------------------------------------
+  void init(QOpenGLContext* io_context);
+  //-----------------------------------------------------------------------------------------------------
+  /// @brief Deletes every framebuffer in the pool, none may be bound.
+  //-----------------------------------------------------------------------------------------------------
+  void reset();
+  //-----------------------------------------------------------------------------------------------------
+  /// @brief Binds a free framebuffer with one level of a texture as it's color attachment, and sets the
+  /// viewport to match. Cube maps, 3D textures and arrays are attached with all of their layers, so a
+  /// single draw can write every face by setting gl_Layer, unless one layer is asked for.
+  /// @param [in] _texture is the texture to render to.
+  /// @param [in] _level is the mip level to render to.
+  /// @param [in] _width is the width of the level.
+  /// @param [in] _height is the height of the level.
+  /// @param [in] _layer is the single layer to attach, or -1 for a layered attachment.
+  //-----------------------------------------------------------------------------------------------------
+  void bindTarget(
+      const GLuint _texture,
+      const GLint _level,
+      const int _width,
+      const int _height,
+      const GLint _layer = -1
+      );
+  //-----------------------------------------------------------------------------------------------------
+  /// @brief Returns the most recently bound target to the pool, and rebinds the target it replaced,
+  /// or the default framebuffer.
+  //-----------------------------------------------------------------------------------------------------
+  void releaseTarget();
+  //-----------------------------------------------------------------------------------------------------
+  /// @brief Used to get the number of framebuffers that have been created.
+  //-----------------------------------------------------------------------------------------------------
+  size_t size() const noexcept;
+
+private:
+  QOpenGLContext* m_context = nullptr;
+  //-----------------------------------------------------------------------------------------------------
+  /// @brief Every framebuffer that we own, and those not currently bound.
+  //-----------------------------------------------------------------------------------------------------
+  std::vector<GLuint> m_framebuffers;
+  std::vector<GLuint> m_free;
+  //-----------------------------------------------------------------------------------------------------
+  /// @brief Bound targets, so that nested bakes restore their caller's target and viewport.
+  //-----------------------------------------------------------------------------------------------------
+  struct Binding
+  {
+    GLuint m_fbo;
+    int m_width;
+    int m_height;
+  };
+  std::vector<Binding> m_bound;
+  //-----------------------------------------------------------------------------------------------------
+  /// @brief The viewport that was set before the first target was bound.
+  //-----------------------------------------------------------------------------------------------------
+  GLint m_savedViewport[4] = {0, 0, 0, 0};
+};
+
+#endif // FRAMEBUFFERPOOL_H
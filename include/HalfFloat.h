@@ -0,0 +1,103 @@
+#ifndef HALFFLOAT_H
+#define HALFFLOAT_H
+
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+
+//-------------------------------------------------------------------------------------------------------
+/// @brief Conversions between 32 bit floats and IEEE 754 half floats, for writing GL_HALF_FLOAT data
+/// on the CPU.
+//-------------------------------------------------------------------------------------------------------
+namespace HalfFloat
+{
+//-------------------------------------------------------------------------------------------------------
+/// @brief Converts a float to a half, rounding to nearest even. Values that are too large become
+/// infinity, and NaNs stay NaN.
+//-------------------------------------------------------------------------------------------------------
+inline uint16_t fromFloat(const float _value) noexcept
+{
+  uint32_t bits;
+  std::memcpy(&bits, &_value, sizeof(bits));
+  const auto sign = static_cast<uint16_t>((bits >> 16) & 0x8000u);
+  const uint32_t absBits = bits & 0x7fffffffu;
+
+  // NaN and infinity
+  if (absBits >= 0x7f800000u)
+    return sign | 0x7c00u | (absBits > 0x7f800000u ? 0x200u : 0u);
+  // Overflows to infinity, 65520 is the first value that rounds past the largest half
+  if (absBits >= 0x477ff000u)
+    return sign | 0x7c00u;
+  // Normal halfs
+  if (absBits >= 0x38800000u)
+  {
+    const uint32_t rounded = absBits + 0xfffu + ((absBits >> 13) & 1u);
+    return sign | static_cast<uint16_t>((rounded - 0x38000000u) >> 13);
+  }
+  // Denormal halfs, shift the implicit bit down and round
+  if (absBits >= 0x33000000u)
+  {
+    const uint32_t shift = 126u - (absBits >> 23);
+    const uint32_t mantissa = (absBits & 0x7fffffu) | 0x800000u;
+    const uint32_t halfway = 1u << (shift - 1);
+    uint32_t result = mantissa >> shift;
+    const uint32_t remainder = mantissa & ((1u << shift) - 1u);
+    if (remainder > halfway || (remainder == halfway && (result & 1u)))
+      ++result;
+    return sign | static_cast<uint16_t>(result);
+  }
+  return sign;
+}
+//-------------------------------------------------------------------------------------------------------
+/// @brief Converts a half to a float, this is exact.
+//-------------------------------------------------------------------------------------------------------
+inline float toFloat(const uint16_t _half) noexcept
+{
+  const uint32_t sign = static_cast<uint32_t>(_half & 0x8000u) << 16;
+  const uint32_t exponent = (_half >> 10) & 0x1fu;
+  uint32_t mantissa = _half & 0x3ffu;
+  uint32_t bits;
+  if (exponent == 0x1fu)
+  {
+    bits = sign | 0x7f800000u | (mantissa << 13);
+  }
+  else if (exponent)
+  {
+    bits = sign | ((exponent + 112u) << 23) | (mantissa << 13);
+  }
+  else if (mantissa)
+  {
+    // Renormalise the denormal
+    uint32_t e = 113u;
+    while (!(mantissa & 0x400u))
+    {
+      mantissa <<= 1;
+      --e;
+    }
+    bits = sign | (e << 23) | ((mantissa & 0x3ffu) << 13);
+  }
+  else
+  {
+    bits = sign;
+  }
+  float value;
+  std::memcpy(&value, &bits, sizeof(value));
+  return value;
+}
+//-------------------------------------------------------------------------------------------------------
+/// @brief Converts an array of floats to halfs, using F16C instructions when the CPU supports them.
+/// @param [in] _src is the floats to convert.
+/// @param [out] o_dst receives the halfs, which may not overlap the source.
+/// @param [in] _count is the number of values.
+//-------------------------------------------------------------------------------------------------------
+void fromFloats(const float* _src, uint16_t* o_dst, const size_t _count) noexcept;
+//-------------------------------------------------------------------------------------------------------
+/// @brief Converts an array of halfs to floats, using F16C instructions when the CPU supports them.
+/// @param [in] _src is the halfs to convert.
+/// @param [out] o_dst receives the floats, which may not overlap the source.
+/// @param [in] _count is the number of values.
+//-------------------------------------------------------------------------------------------------------
+void toFloats(const uint16_t* _src, float* o_dst, const size_t _count) noexcept;
+}
+
+#endif // HALFFLOAT_H
@@ -0,0 +1,76 @@
+#ifndef HASHUTILS_H
+#define HASHUTILS_H
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <fstream>
+
+//-------------------------------------------------------------------------------------------------------
+/// @brief Small content hashing helpers, used to key the on disk caches.
+//-------------------------------------------------------------------------------------------------------
+namespace HashUtils
+{
+//-------------------------------------------------------------------------------------------------------
+/// @brief The FNV-1a 64 bit offset basis, pass this as the seed to start a new hash.
+//-------------------------------------------------------------------------------------------------------
+constexpr uint64_t k_fnvOffset = 14695981039346656037ull;
+//-------------------------------------------------------------------------------------------------------
+/// @brief Hashes a block of memory using 64 bit FNV-1a.
+/// @param [in] _data is a pointer to the data to hash.
+/// @param [in] _size is the size of the data in bytes.
+/// @param [in] _seed is a previous hash to continue from, so that several blocks can be combined.
+/// @return the hash of the data.
+//-------------------------------------------------------------------------------------------------------
+inline uint64_t fnv1a(const void* _data, const size_t _size, const uint64_t _seed = k_fnvOffset) noexcept
+{
+  constexpr uint64_t k_prime = 1099511628211ull;
+  auto bytes = static_cast<const unsigned char*>(_data);
+  uint64_t hash = _seed;
+  for (size_t i = 0; i < _size; ++i)
+  {
+    hash ^= bytes[i];
+    hash *= k_prime;
+  }
+  return hash;
+}
+//-------------------------------------------------------------------------------------------------------
+/// @brief Hashes a string using 64 bit FNV-1a.
+//-------------------------------------------------------------------------------------------------------
+inline uint64_t fnv1a(const std::string& _str, const uint64_t _seed = k_fnvOffset) noexcept
+{
+  return fnv1a(_str.data(), _str.size(), _seed);
+}
+//-------------------------------------------------------------------------------------------------------
+/// @brief Hashes the contents of a file using 64 bit FNV-1a, reading it in chunks.
+/// @param [in] _path is the path to the file.
+/// @param [out] o_hash is set to the hash of the file contents.
+/// @return false if the file could not be read.
+//-------------------------------------------------------------------------------------------------------
+inline bool fnv1aFile(const std::string& _path, uint64_t &o_hash)
+{
+  std::ifstream file(_path, std::ios::binary);
+  if (!file) return false;
+  char buffer[1 << 16];
+  o_hash = k_fnvOffset;
+  while (file)
+  {
+    file.read(buffer, sizeof(buffer));
+    o_hash = fnv1a(buffer, static_cast<size_t>(file.gcount()), o_hash);
+  }
+  return true;
+}
+//-------------------------------------------------------------------------------------------------------
+/// @brief Formats a hash as a fixed width hexadecimal string, suitable for use as a file name.
+//-------------------------------------------------------------------------------------------------------
+inline std::string toHex(const uint64_t _hash)
+{
+  static constexpr char k_digits[] = "0123456789abcdef";
+  std::string ret(16, '0');
+  for (int i = 15; i >= 0; --i)
+    ret[static_cast<size_t>(15 - i)] = k_digits[(_hash >> (i * 4)) & 0xF];
+  return ret;
+}
+}
+
+#endif // HASHUTILS_H
@@ -0,0 +1,52 @@
+#ifndef HDRIMAGE_H
+#define HDRIMAGE_H
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+
+class ThreadPool;
+
+//-------------------------------------------------------------------------------------------------------
+/// @brief A Radiance RGBE (.hdr) reader, which decodes scanlines in parallel and writes half float RGBA
+/// ready for upload. This has no GL dependency, so it can run on any thread, straight into a mapped
+/// pixel buffer.
+//-------------------------------------------------------------------------------------------------------
+namespace HdrImage
+{
+//-------------------------------------------------------------------------------------------------------
+/// @brief What we learn from the header, enough to size the output before decoding.
+//-------------------------------------------------------------------------------------------------------
+struct Info
+{
+  int m_width = 0;
+  int m_height = 0;
+  //-----------------------------------------------------------------------------------------------------
+  /// @brief Whether the file stores the bottom scanline first.
+  //-----------------------------------------------------------------------------------------------------
+  bool m_bottomUp = false;
+  //-----------------------------------------------------------------------------------------------------
+  /// @brief The byte offset of the first scanline.
+  //-----------------------------------------------------------------------------------------------------
+  size_t m_dataOffset = 0;
+};
+//-------------------------------------------------------------------------------------------------------
+/// @brief Reads just the header of an image.
+/// @param [in] _path is the file to read.
+/// @param [out] o_info is filled from the header.
+/// @return false if the file is missing, or isn't a 32 bit RGBE image with a supported orientation.
+//-------------------------------------------------------------------------------------------------------
+bool readInfo(const std::string &_path, Info &o_info);
+//-------------------------------------------------------------------------------------------------------
+/// @brief Decodes an image to RGBA16F, with the bottom row first as GL expects. Scanlines are located
+/// in a single quick pass over the run lengths, and then decoded and converted in parallel.
+/// @param [in] _path is the file to read.
+/// @param [in] _info is the header of the file, from readInfo.
+/// @param [out] o_pixels must have room for width * height * 4 halfs.
+/// @param [io] io_pool is used to decode scanlines in parallel.
+/// @return false if the file is truncated or malformed.
+//-------------------------------------------------------------------------------------------------------
+bool loadRGBA16F(const std::string &_path, const Info &_info, uint16_t* o_pixels, ThreadPool &io_pool);
+}
+
+#endif // HDRIMAGE_H
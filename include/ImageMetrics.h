@@ -0,0 +1,40 @@
+#ifndef IMAGEMETRICS_H
+#define IMAGEMETRICS_H
+
+#include <cstddef>
+
+//-------------------------------------------------------------------------------------------------------
+/// @brief Error measures for comparing baked or compressed images against a reference.
+//-------------------------------------------------------------------------------------------------------
+namespace ImageMetrics
+{
+//-------------------------------------------------------------------------------------------------------
+/// @brief The difference between two images.
+//-------------------------------------------------------------------------------------------------------
+struct Error
+{
+  //-----------------------------------------------------------------------------------------------------
+  /// @brief Root mean squared error over every channel.
+  //-----------------------------------------------------------------------------------------------------
+  double m_rmse = 0.0;
+  //-----------------------------------------------------------------------------------------------------
+  /// @brief The RMSE divided by the RMS of the reference, which is more useful for HDR data.
+  //-----------------------------------------------------------------------------------------------------
+  double m_relativeRmse = 0.0;
+  //-----------------------------------------------------------------------------------------------------
+  /// @brief Peak signal to noise ratio in decibels, relative to the given peak value.
+  //-----------------------------------------------------------------------------------------------------
+  double m_psnr = 0.0;
+};
+//-------------------------------------------------------------------------------------------------------
+/// @brief Compares two images channel by channel.
+/// @param [in] _test is the image being measured.
+/// @param [in] _reference is the image it is measured against.
+/// @param [in] _count is the number of values, in both images.
+/// @param [in] _peak is the largest possible value, 1 for LDR data. Zero uses the largest reference value.
+/// @return the error, the PSNR is infinite if the images are identical.
+//-------------------------------------------------------------------------------------------------------
+Error compare(const float* _test, const float* _reference, const size_t _count, const float _peak = 0.0f) noexcept;
+}
+
+#endif // IMAGEMETRICS_H
@@ -27,6 +27,13 @@ public:
   //-----------------------------------------------------------------------------------------------------
   void init(const std::shared_ptr<Scene> &io_scene);
 
+private slots:
+  //-----------------------------------------------------------------------------------------------------
+  /// @brief Shows the scene's averaged GPU draw time in the status bar.
+  /// @param [in] _ms is the draw time in milliseconds.
+  //-----------------------------------------------------------------------------------------------------
+  void drawTimeUpdate(const double _ms);
+
 private:
   //-----------------------------------------------------------------------------------------------------
   /// @brief Used to handle a key press, will get delegated to the scene.
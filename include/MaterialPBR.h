@@ -6,6 +6,16 @@
 #include <QOpenGLTexture>
 #include "TriMesh.h"
 #include "MeshVBO.h"
+#include "MaterialParams.h"
+#include "UniformBuffer.h"
+#include "SphericalHarmonics.h"
+#include "FramebufferPool.h"
+#include "HdrImage.h"
+#include "BrickVolume.h"
+#include "BlockCompression.h"
+#include <QOpenGLBuffer>
+#include <future>
+#include <unordered_set>
 
 class MaterialPBR : public Material
 {
@@ -25,11 +35,7 @@ public:
       ) :
     Material(io_camera, io_shaderLib, io_matrices),
     m_context(io_context),
-    m_ao(_ao),
-    m_roughness(_roughness),
-    m_metallic(_metallic),
-    m_baseSpec(_baseSpec),
-    m_normalStrength(_normalStrength),
+    m_params(MaterialParams{_ao, _roughness, _metallic, _baseSpec, _normalStrength}),
     m_morphTargetCount(_morphTargetCount),
     m_morphTargetFPS(_morphTargetFPS)
   {}
@@ -44,6 +50,16 @@ public:
   virtual void update() override;
 
   virtual const char* shaderFileName() const override;
+  //-----------------------------------------------------------------------------------------------------
+  /// @brief P switches between a linked program and a separable program pipeline, and T toggles the
+  /// tessellation stages. U cycles between the volume textures, the surface atlas and a diff of the two,
+  /// and R cycles the volumes between brick pools, a periodic tile and a tile with a detail tile over it.
+  //-----------------------------------------------------------------------------------------------------
+  virtual void handleKey(QKeyEvent* io_event, QOpenGLContext* io_context) override;
+  //-----------------------------------------------------------------------------------------------------
+  /// @brief Used to get the primitive type that the mesh should be drawn with, for the current stages.
+  //-----------------------------------------------------------------------------------------------------
+  GLenum primitiveType() const noexcept;
 
   void setMetallic(const float _metallic) noexcept;
   float getMetallic() const noexcept;
@@ -75,6 +91,12 @@ public:
   void  setEyeDisp(const float _eyeDisp) noexcept;
   float getEyeDisp() const noexcept;
 
+  //-----------------------------------------------------------------------------------------------------
+  /// @brief Sets the GPU time in milliseconds that each frame may spend refining the volumes.
+  //-----------------------------------------------------------------------------------------------------
+  void  setVolumeBakeBudget(const float _milliseconds) noexcept;
+  float getVolumeBakeBudget() const noexcept;
+
   void  setEyeScale(const float _eyeScale) noexcept;
   float getEyeScale() const noexcept;
 
@@ -107,14 +129,107 @@ public:
 
   void  setPhongStrength(const float _strength) noexcept;
   float getPhongStrength() const noexcept;
+  //-----------------------------------------------------------------------------------------------------
+  /// @brief Sets the number of importance samples per texel used to prefilter the environment, this
+  /// takes effect on the next bake, and is part of the bake cache key.
+  //-----------------------------------------------------------------------------------------------------
+  void setPrefilterSamples(const unsigned _samples) noexcept;
+  unsigned getPrefilterSamples() const noexcept;
+  //-----------------------------------------------------------------------------------------------------
+  /// @brief Sets one of the owl's colours, the base colour is zero and the noise layers follow it. The
+  /// volumes are recoloured from their layer masks in the next update, rather than rebaked.
+  //-----------------------------------------------------------------------------------------------------
+  void setColour(const size_t _index, const glm::vec3 &_colour) noexcept;
+  glm::vec3 getColour(const size_t _index) const noexcept;
+  //-----------------------------------------------------------------------------------------------------
+  /// @brief Used to get the number of colours, the base colour and one per noise layer.
+  //-----------------------------------------------------------------------------------------------------
+  size_t colourCount() const noexcept;
 
 private:
+  //-----------------------------------------------------------------------------------------------------
+  /// @brief Where the material reads the owl's solid texture from. The atlas holds the same values
+  /// against the mesh's UVs, and the diff shows how far it is from the volumes.
+  //-----------------------------------------------------------------------------------------------------
+  enum class SurfaceTextures { VOLUMES, ATLAS, ATLAS_DIFF };
+  //-----------------------------------------------------------------------------------------------------
+  /// @brief How the volumes are stored. Brick pools hold the whole volume near the surface, while tiles
+  /// hold a small bake of periodic noise that repeats across it, optionally with a second detail tile.
+  //-----------------------------------------------------------------------------------------------------
+  enum class VolumeTiling { BRICKS, TILE, DETAIL_TILE };
   void initTargets(const std::string &_posePath, const unsigned _framePad);
+  //-----------------------------------------------------------------------------------------------------
+  /// @brief Sets the samplers and morph target uniforms of a program, this is required once for each of
+  /// our program variants, and each pipeline stage.
+  /// @param [io] io_shader is the program to initialise.
+  //-----------------------------------------------------------------------------------------------------
+  void initProgram(QOpenGLShaderProgram* io_shader);
+  //-----------------------------------------------------------------------------------------------------
+  /// @brief Picks the permutation of our program, or pipeline, that matches the current settings, and
+  /// starts compiling the ones that the P and T keys would switch to next.
+  //-----------------------------------------------------------------------------------------------------
+  void updateVariant();
+  //-----------------------------------------------------------------------------------------------------
+  /// @brief Rebuilds the eye twist matrix in the material block from the eye rotation, so that it's
+  /// evaluated once when the rotation changes rather than in every shader invocation.
+  //-----------------------------------------------------------------------------------------------------
+  void updateEyeTwist();
   void initCaptureMatrices();
+  //-----------------------------------------------------------------------------------------------------
+  /// @brief Builds the key for our baked environment maps, from the hash of the HDR image and the bake
+  /// settings.
+  /// @return the key, or an empty string if the HDR image couldn't be read.
+  //-----------------------------------------------------------------------------------------------------
+  std::string iblCacheKey() const;
+  //-----------------------------------------------------------------------------------------------------
+  /// @brief Loads previously baked irradiance coefficients and prefilter maps from disk.
+  /// @return true if all maps were loaded, in which case none of them need to be baked.
+  //-----------------------------------------------------------------------------------------------------
+  bool loadIblCache();
+  //-----------------------------------------------------------------------------------------------------
+  /// @brief Writes our baked environment maps to disk.
+  /// @param [in] _prefiltered is the compressed prefilter map returned by compressPrefilteredMap.
+  //-----------------------------------------------------------------------------------------------------
+  void saveIblCache(const TextureFile &_prefiltered);
+  //-----------------------------------------------------------------------------------------------------
+  /// @brief Reads back the prefiltered map, compresses it to BC6H and replaces it with the result, so
+  /// that a fresh bake samples the same texels as a cached one. Prints the error of the compression.
+  /// @return the compressed map, ready to be saved.
+  //-----------------------------------------------------------------------------------------------------
+  TextureFile compressPrefilteredMap();
+  //-----------------------------------------------------------------------------------------------------
+  /// @brief Loads the precomputed BRDF table that ships in images, generated by tools/brdflut.
+  /// @return false if the asset is missing, in which case the table is baked on the GPU instead.
+  //-----------------------------------------------------------------------------------------------------
+  bool loadBrdfLUT();
+  //-----------------------------------------------------------------------------------------------------
+  /// @brief Starts decoding the HDR environment on a loader thread, into a mapped pixel buffer.
+  //-----------------------------------------------------------------------------------------------------
+  void beginSphereMapLoad();
+  //-----------------------------------------------------------------------------------------------------
+  /// @brief Waits for the loader thread and uploads the environment from the pixel buffer. Falls back to
+  /// a synchronous stb_image load if the file couldn't be decoded.
+  //-----------------------------------------------------------------------------------------------------
   void initSphereMap();
   void initCubeMap(const TriMesh &_cube, const MeshVBO &_vbo);
-  void initIrradianceMap(const TriMesh &_cube, const MeshVBO &_vbo);
-  void initPrefilteredMap(const TriMesh &_cube, const MeshVBO &_vbo);
+  //-----------------------------------------------------------------------------------------------------
+  /// @brief Prefilters the environment cube map for every roughness level.
+  /// @param [in] _cube is the cube mesh, which must be in the vbo.
+  /// @param [in] _vbo holds the cube vertices.
+  /// @param [out] o_texture is reset to the prefiltered map.
+  /// @param [in] _samples is the number of importance samples per texel.
+  //-----------------------------------------------------------------------------------------------------
+  void generatePrefilteredMap(
+      const TriMesh &_cube,
+      const MeshVBO &_vbo,
+      std::unique_ptr<QOpenGLTexture> &o_texture,
+      const unsigned _samples
+      );
+  //-----------------------------------------------------------------------------------------------------
+  /// @brief Bakes a high sample count reference of the prefiltered map, and prints the error of our
+  /// bake against it for each level. This is slow, so it only runs in debug builds.
+  //-----------------------------------------------------------------------------------------------------
+  void reportPrefilterError(const TriMesh &_cube, const MeshVBO &_vbo);
   void initBrdfLUTMap(const TriMesh &_plane, const MeshVBO &_vbo);
 
   void generateCubeMap(const TriMesh &_cube,
@@ -122,19 +237,183 @@ private:
       std::unique_ptr<QOpenGLTexture> &_texture,
       const int _dim,
       const std::string &_matPath,
-      const std::function<void (QOpenGLShaderProgram* io_prog)> &_prerender = [](QOpenGLShaderProgram*){}
+      const std::function<void (QOpenGLShaderProgram* io_prog)> &_prerender = [](QOpenGLShaderProgram*){},
+      const bool _mipmapped = false
   );
 
-  void generate3DTexture(
-      const TriMesh &_plane,
-      const MeshVBO &_vbo,
-      std::unique_ptr<QOpenGLTexture> &_texture, const int _dim,
-      const std::string &_matPath,
-      const QOpenGLTexture::TextureFormat _format,
-      const std::function<void (QOpenGLShaderProgram* io_prog)> &_prerender = [](QOpenGLShaderProgram*){}
-  );
-
-  std::array<QMatrix4x4, 6>  m_captureViews;
+  //-----------------------------------------------------------------------------------------------------
+  /// @brief A set of albedo and normal brick pools, along with the layout and indirection they share.
+  //-----------------------------------------------------------------------------------------------------
+  struct BrickPools
+  {
+    BrickLayout m_layout;
+    std::unique_ptr<QOpenGLTexture> m_albedo;
+    std::unique_ptr<QOpenGLTexture> m_normal;
+    //---------------------------------------------------------------------------------------------------
+    /// @brief BC6H has no alpha, so compressed pools keep the displacement in an R16F pool of it's own,
+    /// swizzled so that it reads from w. Uncompressed pools leave this empty and read the albedo's w.
+    //---------------------------------------------------------------------------------------------------
+    std::unique_ptr<QOpenGLTexture> m_height;
+    //---------------------------------------------------------------------------------------------------
+    /// @brief Maps the normalized channels of compressed pools back to their values.
+    //---------------------------------------------------------------------------------------------------
+    BlockCompression::Range m_albedoRange;
+    BlockCompression::Range m_normalRange;
+    //---------------------------------------------------------------------------------------------------
+    /// @brief The weight of each noise layer in a pair of RGBA8 masks, at the finest level. They're only
+    /// read to change the colours, so after a bake they are moved out of video memory, in to the files,
+    /// until the first recolour.
+    //---------------------------------------------------------------------------------------------------
+    std::array<std::unique_ptr<QOpenGLTexture>, 2> m_layers;
+    std::array<TextureFile, 2> m_layerFiles;
+    //---------------------------------------------------------------------------------------------------
+    /// @brief The colours that the albedo pool was blended with.
+    //---------------------------------------------------------------------------------------------------
+    std::array<QVector4D, 9> m_colours;
+    std::unique_ptr<QOpenGLTexture> m_indirection;
+    //---------------------------------------------------------------------------------------------------
+    /// @brief The dense coordinate of every brick in the pools, read by the bake programs.
+    //---------------------------------------------------------------------------------------------------
+    QOpenGLBuffer m_brickList;
+  };
+  //-----------------------------------------------------------------------------------------------------
+  /// @brief Finds the bricks near the owl's surface, allowing for the current eye displacement, and
+  /// starts baking the albedo and normal pools for them. Unless they are cached, a coarse preview is
+  /// baked immediately, and the full pools are refined over the following frames by refineVolumes.
+  //-----------------------------------------------------------------------------------------------------
+  void bakeVolumes();
+  //-----------------------------------------------------------------------------------------------------
+  /// @brief Bakes as many layers of the pending pools as the budget allows, and swaps them in once all
+  /// layers are written. The cost of a layer is measured with a timer query, which is read a few frames
+  /// later so that we never stall waiting for it.
+  //-----------------------------------------------------------------------------------------------------
+  void refineVolumes();
+  //-----------------------------------------------------------------------------------------------------
+  /// @brief Collects the pools that refineVolumes and recolourVolumes started reading back, which are
+  /// copied out on the worker threads as they land. Once a set is complete it's handed to the workers to
+  /// be encoded, or stored straight away when we aren't compressing.
+  //-----------------------------------------------------------------------------------------------------
+  void finishVolumeReadback();
+  //-----------------------------------------------------------------------------------------------------
+  /// @brief Swaps the displayed pools for their compressed versions, once the worker threads have
+  /// finished encoding them, and stores them for the next run. Pools that were rebaked in the meantime
+  /// are left alone.
+  //-----------------------------------------------------------------------------------------------------
+  void finishVolumeEncode();
+  //-----------------------------------------------------------------------------------------------------
+  /// @brief Blends the current colours by the layer masks in to a new albedo pool, and averages it's
+  /// coarser levels. This skips the noise entirely, so palette edits are interactive. Pools without
+  /// masks are rebaked instead.
+  //-----------------------------------------------------------------------------------------------------
+  void recolourVolumes();
+  //-----------------------------------------------------------------------------------------------------
+  /// @brief Builds the layout, indirection and brick list of a set of pools, around the volume surface.
+  /// @param [out] o_pools receives the layout, the pools themselves are left unallocated.
+  /// @param [in] _dim is the size of the dense volume, which must be a multiple of the brick size.
+  /// @return false if the bricks don't fit in a 3D texture.
+  //-----------------------------------------------------------------------------------------------------
+  bool buildBrickPools(BrickPools &o_pools, const int _dim);
+  //-----------------------------------------------------------------------------------------------------
+  /// @brief Bakes a range of layers, counted over every pass of the bake. The finest level of the albedo
+  /// comes first, followed by it's normals, then each coarser level of both pools.
+  /// @param [io] io_pools are the allocated pools to write.
+  /// @param [in] _firstLayer is the first layer to bake, of those counted by bakeLayerCount.
+  /// @param [in] _numLayers is the number of layers to bake.
+  //-----------------------------------------------------------------------------------------------------
+  void bakeBrickLayers(BrickPools &io_pools, const int _firstLayer, const int _numLayers);
+  //-----------------------------------------------------------------------------------------------------
+  /// @brief Used to get the number of layers bakeBrickLayers writes, which depends on the pools allocated.
+  /// @param [in] _pools are the pools to bake.
+  //-----------------------------------------------------------------------------------------------------
+  int bakeLayerCount(const BrickPools &_pools) const;
+  //-----------------------------------------------------------------------------------------------------
+  /// @brief Creates a pool from baked or cached data, with the filtering the material expects.
+  /// @param [in] _file holds the pool, compressed or not.
+  /// @param [out] o_texture is reset to the new pool.
+  //-----------------------------------------------------------------------------------------------------
+  void uploadBrickPool(const TextureFile &_file, std::unique_ptr<QOpenGLTexture> &o_texture);
+  //-----------------------------------------------------------------------------------------------------
+  /// @brief Sets the level uniforms of brick_volume.h on a program.
+  /// @param [in] _program is the id of the program, which needn't be bound.
+  /// @param [in] _layout holds the levels.
+  //-----------------------------------------------------------------------------------------------------
+  void setBrickLevels(const GLuint _program, const BrickLayout &_layout);
+  //-----------------------------------------------------------------------------------------------------
+  /// @brief Sets the levels and compression ranges of the displayed pools on one of our programs.
+  /// @param [io] io_program is the program, which needn't be bound.
+  //-----------------------------------------------------------------------------------------------------
+  void setVolumeUniforms(QOpenGLShaderProgram* io_program);
+  //-----------------------------------------------------------------------------------------------------
+  /// @brief Builds the key for our baked volumes, from the hash of the surface mesh, the colours, the
+  /// bake settings and the expanded sources of both bake programs.
+  /// @return the key, or an empty string if the surface mesh couldn't be read.
+  //-----------------------------------------------------------------------------------------------------
+  std::string volumeCacheKey() const;
+  //-----------------------------------------------------------------------------------------------------
+  /// @brief Loads previously baked albedo and normal pools from disk.
+  /// @param [in] _key is the key returned by volumeCacheKey.
+  /// @param [io] io_pools holds the layout to validate against, and receives the pools.
+  /// @return true if every pool was loaded, in which case none need to be baked.
+  //-----------------------------------------------------------------------------------------------------
+  bool loadVolumeCache(const std::string &_key, BrickPools &io_pools);
+  //-----------------------------------------------------------------------------------------------------
+  /// @brief Bakes the albedo and normals in to 2D atlases, by rasterizing the base mesh in UV space and
+  /// evaluating the noise at each texel's base position. The seams are then dilated, so that filtering
+  /// never reads texels that the mesh doesn't cover.
+  //-----------------------------------------------------------------------------------------------------
+  void bakeAtlas();
+  //-----------------------------------------------------------------------------------------------------
+  /// @brief Bakes any tile that the current tiling reads and is missing. Tiles have no layer masks, as
+  /// they are small enough to bake again from scratch whenever the colours change.
+  //-----------------------------------------------------------------------------------------------------
+  void bakeTiles();
+  //-----------------------------------------------------------------------------------------------------
+  /// @brief Bakes one mipmapped tile of the albedo, with periodic noise.
+  /// @param [out] o_texture is reset to the new tile.
+  /// @param [in] _dim is the size of the tile along each axis.
+  /// @param [in] _repeats is the number of times the tile repeats across the volume.
+  /// @param [in] _offset offsets the noise, so that different tiles don't share features.
+  //-----------------------------------------------------------------------------------------------------
+  void bakeTile(
+      std::unique_ptr<QOpenGLTexture> &o_texture,
+      const int _dim,
+      const int _repeats,
+      const glm::vec3 &_offset
+      );
+  //-----------------------------------------------------------------------------------------------------
+  /// @brief Allocates an empty brick pool for a layout, ready to be written by dispatchBricks.
+  /// @param [in] _pools holds the layout of the pool.
+  /// @param [out] o_texture is reset to the new pool.
+  /// @param [in] _format must be a format that image stores can write.
+  //-----------------------------------------------------------------------------------------------------
+  void allocateBrickPool(
+      const BrickPools &_pools,
+      std::unique_ptr<QOpenGLTexture> &o_texture,
+      const QOpenGLTexture::TextureFormat _format
+      );
+  //-----------------------------------------------------------------------------------------------------
+  /// @brief Runs a compute program over a range of layers of a brick pool, which is bound to image unit
+  /// 0. Ranges are written independently, so a bake can be spread across several frames.
+  /// @param [in] _shaderName is the name of a compute program, with one work group per padded brick.
+  /// @param [in] _pools provides the layout and brick list.
+  /// @param [in] _texture is the pool to write.
+  /// @param [in] _firstLayer is the first layer of bricks to write.
+  /// @param [in] _numLayers is the number of layers of bricks to write.
+  /// @param [in] _prebake sets any other uniforms and textures, while the program is bound.
+  //-----------------------------------------------------------------------------------------------------
+  void dispatchBricks(
+      const std::string &_shaderName,
+      const BrickPools &_pools,
+      QOpenGLTexture &_texture,
+      const int _firstLayer,
+      const int _numLayers,
+      const std::function<void (QOpenGLShaderProgram* io_prog)> &_prebake = [](QOpenGLShaderProgram*){}
+      );
+
+  //-----------------------------------------------------------------------------------------------------
+  /// @brief The capture projection multiplied by the view of each cube face, for layered cube bakes.
+  //-----------------------------------------------------------------------------------------------------
+  std::array<QMatrix4x4, 6> m_captureViewProjections;
   std::array<QVector4D, 9> m_colours = {
     {
       {0.093f,  0.02f, 0.003f, 0.0f},
@@ -148,22 +427,96 @@ private:
       {  1.0f,  0.31f, 0.171f, 0.0f}
     }
   };
-  QMatrix4x4 m_captureProjection;
-
+  bool m_coloursDirty = false;
   std::unique_ptr<QOpenGLTexture> m_sphereMap;
+  //-----------------------------------------------------------------------------------------------------
+  /// @brief The in flight environment load, the loader thread writes everything up to the flag, which
+  /// is only read once the future has completed.
+  //-----------------------------------------------------------------------------------------------------
+  std::future<void> m_sphereMapLoad;
+  QOpenGLBuffer m_sphereMapPBO {QOpenGLBuffer::PixelUnpackBuffer};
+  HdrImage::Info m_sphereMapInfo;
+  IrradianceSH m_loadedIrradiance;
+  bool m_sphereMapDecoded = false;
   std::unique_ptr<QOpenGLTexture> m_cubeMap;
-  std::unique_ptr<QOpenGLTexture> m_irradianceMap;
   std::unique_ptr<QOpenGLTexture> m_prefilteredMap;
   std::unique_ptr<QOpenGLTexture> m_brdfMap;
-  std::unique_ptr<QOpenGLTexture> m_albedoMap;
-  std::unique_ptr<QOpenGLTexture> m_normalMap;
+  //-----------------------------------------------------------------------------------------------------
+  /// @brief The pools that are drawn with, and those still being refined, which replace them once done.
+  //-----------------------------------------------------------------------------------------------------
+  BrickPools m_volumes;
+  BrickPools m_pendingVolumes;
+  //-----------------------------------------------------------------------------------------------------
+  /// @brief Set when the displayed pools are swapped or their ranges change, so that every program is
+  /// given the new levels and ranges in the next update.
+  //-----------------------------------------------------------------------------------------------------
+  bool m_volumeUniformsDirty = false;
+  //-----------------------------------------------------------------------------------------------------
+  /// @brief Drops the normal pool, and derives the normals from the albedo's displacement as we draw.
+  /// This halves the memory of the volumes, at the cost of four extra taps per fragment.
+  //-----------------------------------------------------------------------------------------------------
+  bool m_deriveNormals = false;
+  //-----------------------------------------------------------------------------------------------------
+  /// @brief Encodes refined and recoloured pools to BC6H on the worker threads, which takes them from 16
+  /// to 4 bytes a texel with baked normals. Until an encode finishes the uncompressed pools are drawn.
+  //-----------------------------------------------------------------------------------------------------
+  bool m_compressVolumes = true;
+  struct VolumeEncode;
+  std::vector<std::shared_ptr<VolumeEncode>> m_volumeEncodes;
+  struct VolumeReadback;
+  std::vector<std::shared_ptr<VolumeReadback>> m_volumeReadbacks;
+  //-----------------------------------------------------------------------------------------------------
+  /// @brief Counts the volume bakes and recolours, so that an encode which finishes after the pools it
+  /// was made from were replaced can be discarded.
+  //-----------------------------------------------------------------------------------------------------
+  unsigned m_volumeGeneration = 0;
+  unsigned m_albedoGeneration = 0;
+  std::string m_pendingCacheKey;
+  int m_pendingLayer = 0;
+  //-----------------------------------------------------------------------------------------------------
+  /// @brief The refinement budget, and the measured cost of each layer.
+  //-----------------------------------------------------------------------------------------------------
+  float m_volumeBakeBudget = 2.0f;
+  float m_bakeLayerMs = 0.0f;
+  GLuint m_bakeTimer = 0;
+  int m_bakeTimerLayers = 0;
+  //-----------------------------------------------------------------------------------------------------
+  /// @brief The surface that the bricks are placed around, and the eye displacement they allow for.
+  //-----------------------------------------------------------------------------------------------------
+  TriMesh m_volumeSurface;
+  float m_volumeDisp = 0.0f;
+  bool m_volumesDirty = false;
+  //-----------------------------------------------------------------------------------------------------
+  /// @brief The surface atlases, these and the volumes are only kept while the current mode reads them.
+  //-----------------------------------------------------------------------------------------------------
+  std::unique_ptr<QOpenGLTexture> m_albedoAtlas;
+  std::unique_ptr<QOpenGLTexture> m_normalAtlas;
+  SurfaceTextures m_surfaceTextures = SurfaceTextures::VOLUMES;
+  //-----------------------------------------------------------------------------------------------------
+  /// @brief The tiles drawn in place of the brick pools, when the volumes are tiled.
+  //-----------------------------------------------------------------------------------------------------
+  std::unique_ptr<QOpenGLTexture> m_tile;
+  std::unique_ptr<QOpenGLTexture> m_detailTile;
+  VolumeTiling m_volumeTiling = VolumeTiling::BRICKS;
 
   QOpenGLContext* m_context;
-  float m_ao;
-  float m_roughness;
-  float m_metallic;
-  float m_baseSpec;
-  float m_normalStrength;
+  //-----------------------------------------------------------------------------------------------------
+  /// @brief The key that our baked environment maps are stored under.
+  //-----------------------------------------------------------------------------------------------------
+  std::string m_iblCacheKey;
+  //-----------------------------------------------------------------------------------------------------
+  /// @brief Render targets shared by every bake, so rebaking doesn't allocate new framebuffers.
+  //-----------------------------------------------------------------------------------------------------
+  FramebufferPool m_bakeTargets;
+  //-----------------------------------------------------------------------------------------------------
+  /// @brief All scalar material parameters, setters only mark members dirty and the changed range is
+  /// uploaded once per frame in update.
+  //-----------------------------------------------------------------------------------------------------
+  UniformBlock<MaterialParams> m_params;
+  //-----------------------------------------------------------------------------------------------------
+  /// @brief Diffuse irradiance of the environment, projected on to spherical harmonics.
+  //-----------------------------------------------------------------------------------------------------
+  UniformBlock<IrradianceSH> m_irradianceSH;
 
   QOpenGLBuffer m_morphTargetBuffer;
 
@@ -172,21 +525,35 @@ private:
   float m_time = 0.0f;
   bool m_paused = true;
   GLuint m_tessType = 1;
-  int m_tessLevelInner  = 15;
-  int m_tessLevelOuter  = 15;
-  float m_tessMaskCap   = 1.f;
-  float m_phongStrength = 0.55f;
-
-  glm::vec3 m_eyeTranslate {0.21, 0.3, 0.0};
-  float m_eyeDisp      = -0.2f;
-  float m_eyeScale     = 1.55f;
-  float m_eyeRotation  =  7.0f;
-  float m_eyeWarp      =  1.0f;
-  float m_eyeExponent  =  3.0f;
-  float m_eyeThickness = 0.08f;
-  float m_eyeGap       = 0.19f;
-  float m_eyeFuzz      = 0.02f;
-  float m_eyeMaskCap   =  0.7f;
+  //-----------------------------------------------------------------------------------------------------
+  /// @brief The name of the program variant in use, settings that are compiled into the program only
+  /// flag it as dirty, and the switch happens in the first update after the new variant has compiled.
+  //-----------------------------------------------------------------------------------------------------
+  std::string m_variantName;
+  bool m_variantDirty = true;
+  std::unordered_set<QOpenGLShaderProgram*> m_initialisedVariants;
+  //-----------------------------------------------------------------------------------------------------
+  /// @brief The programs that make up the current variant, more than one when using a pipeline.
+  //-----------------------------------------------------------------------------------------------------
+  std::vector<QOpenGLShaderProgram*> m_activePrograms;
+  //-----------------------------------------------------------------------------------------------------
+  /// @brief The stages that our variant is built from, and whether they are mixed in a pipeline.
+  //-----------------------------------------------------------------------------------------------------
+  unsigned m_stages = ShaderLib::ALL_STAGES;
+  bool m_usePipelines = false;
+  //-----------------------------------------------------------------------------------------------------
+  /// @brief The stages and binding of the variant in use, until a newly requested one is ready.
+  //-----------------------------------------------------------------------------------------------------
+  unsigned m_activeStages = ShaderLib::ALL_STAGES;
+  bool m_activeUsesPipeline = false;
+  int m_morphTargetSize = 0;
+  int m_morphTargetNormalOffset = 0;
+
+  //-----------------------------------------------------------------------------------------------------
+  /// @brief Importance samples per texel for the prefilter bake, filtered sampling of the mipmapped
+  /// environment keeps this low.
+  //-----------------------------------------------------------------------------------------------------
+  unsigned m_prefilterSamples = 128;
 
   unsigned m_morphTargetCount = 0;
   unsigned m_morphTargetFPS = 0;
@@ -0,0 +1,56 @@
+#ifndef MATERIALPARAMS_H
+#define MATERIALPARAMS_H
+
+#include <QOpenGLFunctions>
+#include "vec3.hpp"
+#include "vec4.hpp"
+#include <array>
+#include <cstddef>
+
+//-------------------------------------------------------------------------------------------------------
+/// @brief CPU side mirror of the std140 MaterialParams uniform block declared in
+/// shaders/include/material_params.h, the member order and padding must match.
+//-------------------------------------------------------------------------------------------------------
+struct MaterialParams
+{
+  float ao;
+  float roughness;
+  float metallic;
+  float baseSpec;
+  float normalStrength;
+  float eyeDisp       = -0.2f;
+  float eyeScale      = 1.55f;
+  float eyeRotation   =  7.0f;
+  float eyeWarp       =  1.0f;
+  float eyeExponent   =  3.0f;
+  float eyeThickness  = 0.08f;
+  float eyeGap        = 0.19f;
+  float eyeFuzz       = 0.02f;
+  float eyeMaskCap    =  0.7f;
+  float tessMaskCap   =  1.0f;
+  float phongStrength = 0.55f;
+  // A vec3 is 16 byte aligned in std140, we are already on a 16 byte boundary here
+  glm::vec3 eyeTranslate {0.21f, 0.3f, 0.0f};
+  // Packed into the last 4 bytes of the vec3's slot
+  GLint tessLevelInner = 15;
+  GLint tessLevelOuter = 15;
+  // Pad to a vec4 boundary, where the matrix below starts
+  GLint padding[3] = {0, 0, 0};
+  // Everything below depends only on the members above, and is filled in by MaterialPBR so that the
+  // shaders don't evaluate it per vertex or fragment.
+  // The eye rotation about z, as the columns of a std140 mat3 which are each padded to a vec4
+  std::array<glm::vec4, 3> eyeTwist {{{1.0f, 0.0f, 0.0f, 0.0f}, {0.0f, 1.0f, 0.0f, 0.0f}, {0.0f, 0.0f, 1.0f, 0.0f}}};
+  glm::vec3 eyeAlbedo {0.0f, 0.0f, 0.0f};
+  // Pad the block to a multiple of a vec4
+  float blockPadding = 0.0f;
+};
+
+// Pin the std140 offsets that the shader block relies on
+static_assert(offsetof(MaterialParams, eyeTranslate) == 64, "eyeTranslate must start the fifth vec4");
+static_assert(offsetof(MaterialParams, tessLevelInner) == 76, "tessLevelInner must fill the eyeTranslate slot");
+static_assert(offsetof(MaterialParams, tessLevelOuter) == 80, "tessLevelOuter must start the sixth vec4");
+static_assert(offsetof(MaterialParams, eyeTwist) == 96, "eyeTwist must start on a vec4 boundary");
+static_assert(offsetof(MaterialParams, eyeAlbedo) == 144, "eyeAlbedo must follow the three mat3 columns");
+static_assert(sizeof(MaterialParams) == 160, "MaterialParams must be padded to a multiple of 16 bytes");
+
+#endif // MATERIALPARAMS_H
@@ -0,0 +1,34 @@
+#ifndef OWLBAKE_H
+#define OWLBAKE_H
+
+#include "TextureFile.h"
+#include "OwlNoise.h"
+
+class ThreadPool;
+
+//-------------------------------------------------------------------------------------------------------
+/// @brief CPU bakes of the owl's dense albedo and normal volumes, built on OwlNoise. These match the
+/// texels that owl_noise_comp.glsl and owl_normal_comp.glsl write, so they can be made on machines
+/// without a GPU, and used to check changes to the noise.
+//-------------------------------------------------------------------------------------------------------
+namespace OwlBake
+{
+//-------------------------------------------------------------------------------------------------------
+/// @brief Evaluates the albedo and displacement at every texel of a dense volume.
+/// @param [in] _dim is the size of the volume along each axis.
+/// @param [in] _palette holds the colours and offset of the noise.
+/// @param [io] io_pool is used to bake rows in parallel.
+/// @return an RGBA16F 3D texture, with the displacement in alpha.
+//-------------------------------------------------------------------------------------------------------
+TextureFile albedo(const int _dim, const OwlNoise::Palette &_palette, ThreadPool &io_pool);
+//-------------------------------------------------------------------------------------------------------
+/// @brief Derives the normals from the displacement of an albedo volume, wrapping at the edges as the
+/// mirrored repeat mode does.
+/// @param [in] _albedo is a volume returned by albedo.
+/// @param [io] io_pool is used to bake rows in parallel.
+/// @return an RGBA16F 3D texture, w is unused.
+//-------------------------------------------------------------------------------------------------------
+TextureFile normals(const TextureFile &_albedo, ThreadPool &io_pool);
+}
+
+#endif // OWLBAKE_H
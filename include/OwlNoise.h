@@ -0,0 +1,90 @@
+#ifndef OWLNOISE_H
+#define OWLNOISE_H
+
+#include <array>
+#include <cstddef>
+#include "vec3.hpp"
+#include "vec4.hpp"
+
+//-------------------------------------------------------------------------------------------------------
+/// @brief A CPU port of the owl's solid texture, perlin_noise.h, owl_noise_funcs.h and owl_albedo.h, so
+/// textures can be baked and checked without a GPU. Points are evaluated in batches of k_lanes, which
+/// map on to AVX2 or SSE registers when the build targets them, and plain arrays otherwise.
+//-------------------------------------------------------------------------------------------------------
+namespace OwlNoise
+{
+//-------------------------------------------------------------------------------------------------------
+/// @brief The number of points in a batch.
+//-------------------------------------------------------------------------------------------------------
+constexpr size_t k_lanes = 8;
+//-------------------------------------------------------------------------------------------------------
+/// @brief The number of noise layers blended over the base colour.
+//-------------------------------------------------------------------------------------------------------
+constexpr size_t k_layers = 8;
+//-------------------------------------------------------------------------------------------------------
+/// @brief A batch of points, stored as a structure of arrays.
+//-------------------------------------------------------------------------------------------------------
+struct Points
+{
+  alignas(32) float m_x[k_lanes];
+  alignas(32) float m_y[k_lanes];
+  alignas(32) float m_z[k_lanes];
+};
+//-------------------------------------------------------------------------------------------------------
+/// @brief The uniforms of owl_albedo.h.
+//-------------------------------------------------------------------------------------------------------
+struct Palette
+{
+  //-----------------------------------------------------------------------------------------------------
+  /// @brief The base colour followed by the colour of each noise layer, as u_cols.
+  //-----------------------------------------------------------------------------------------------------
+  std::array<glm::vec4, 9> m_cols;
+  //-----------------------------------------------------------------------------------------------------
+  /// @brief Shifts the noise, as u_offsetPos.
+  //-----------------------------------------------------------------------------------------------------
+  glm::vec3 m_offsetPos {1.0f};
+};
+//-------------------------------------------------------------------------------------------------------
+/// @brief The palette that MaterialPBR bakes with.
+//-------------------------------------------------------------------------------------------------------
+Palette defaultPalette();
+//-------------------------------------------------------------------------------------------------------
+/// @brief Classic Perlin noise, matches cnoise.
+/// @param [in] _points are the points to evaluate.
+/// @param [out] o_noise receives k_lanes values.
+//-------------------------------------------------------------------------------------------------------
+void cnoise(const Points &_points, float* o_noise) noexcept;
+//-------------------------------------------------------------------------------------------------------
+/// @brief The weight of each noise layer, which don't depend on the colours, matches calcLayers.
+/// @param [in] _uvw are the volume coordinates to evaluate.
+/// @param [in] _palette holds the offset, the colours are ignored.
+/// @param [out] o_layers receives k_lanes sets of k_layers weights, interleaved.
+//-------------------------------------------------------------------------------------------------------
+void layers(const Points &_uvw, const Palette &_palette, float* o_layers) noexcept;
+//-------------------------------------------------------------------------------------------------------
+/// @brief Blends the colours by a point's layer weights, matches combineLayers.
+/// @param [in] _layers are the k_layers weights of the point.
+/// @param [in] _palette holds the colours.
+/// @return the albedo, with the displacement in w.
+//-------------------------------------------------------------------------------------------------------
+glm::vec4 combineLayers(const float* _layers, const Palette &_palette) noexcept;
+//-------------------------------------------------------------------------------------------------------
+/// @brief The layered albedo and displacement, matches calcAlbedoDisp.
+/// @param [in] _uvw are the volume coordinates to evaluate.
+/// @param [in] _palette holds the colours and offset.
+/// @param [out] o_albedoDisp receives k_lanes RGBA values, interleaved.
+//-------------------------------------------------------------------------------------------------------
+void albedoDisp(const Points &_uvw, const Palette &_palette, float* o_albedoDisp) noexcept;
+//-------------------------------------------------------------------------------------------------------
+/// @brief Single point versions of the above, these still evaluate a whole batch.
+//-------------------------------------------------------------------------------------------------------
+float cnoise(const glm::vec3 &_point) noexcept;
+float turb(const glm::vec3 &_point, const float _frequency) noexcept;
+glm::vec4 albedoDisp(const glm::vec3 &_uvw, const Palette &_palette) noexcept;
+//-------------------------------------------------------------------------------------------------------
+/// @brief Used to get the instruction set that the batches were compiled for.
+//-------------------------------------------------------------------------------------------------------
+const char* instructionSet() noexcept;
+}
+
+#endif // OWLNOISE_H
@@ -12,6 +12,8 @@
 #include <memory>
 #include "MeshVBO.h"
 #include "Camera.h"
+#include "FrameConstants.h"
+#include "UniformBuffer.h"
 
 
 //-------------------------------------------------------------------------------------------------------
@@ -98,6 +100,10 @@ protected:
   //-----------------------------------------------------------------------------------------------------
   std::array<glm::mat4, 3> m_matrices;
   //-----------------------------------------------------------------------------------------------------
+  /// @brief Camera and transform data shared by every shader program, written once per frame.
+  //-----------------------------------------------------------------------------------------------------
+  UniformBlock<FrameConstants> m_frameConstants;
+  //-----------------------------------------------------------------------------------------------------
   /// @brief a pointer to the camera that is used to view this scene.
   //-----------------------------------------------------------------------------------------------------
   std::shared_ptr<Camera> m_camera;
@@ -2,34 +2,121 @@
 #define SHADERLIB_H
 
 #include <vector>
+#include <array>
 #include <unordered_map>
 #include <QOpenGLShaderProgram>
 #include <memory>
+#include "ShaderPreprocessor.h"
 
 class ShaderLib
 {
 public:
+  //-----------------------------------------------------------------------------------------------------
+  /// @brief Bits used to pick which stages of a program to build, these match the GL pipeline stage bits.
+  //-----------------------------------------------------------------------------------------------------
+  enum STAGE_BITS : unsigned
+  {
+    VERTEX_STAGE = 1,
+    FRAGMENT_STAGE = 2,
+    GEOMETRY_STAGE = 4,
+    TESSELLATION_STAGES = 8 | 16,
+    COMPUTE_STAGE = 32,
+    ALL_STAGES = 63
+  };
   //-----------------------------------------------------------------------------------------------------
   /// @brief Creates a shader program from a json file, by extracting the path of all required glsl
-  /// shaders for that program, compiling, attaching and linking them.
+  /// shaders for that program, compiling, attaching and linking them. This waits for the program to
+  /// finish linking, use submitShaderProg to avoid stalling.
   /// @param [in] _jsonFileName is the path to the json file.
   /// @return is the name that this shader is stored under.
   //-----------------------------------------------------------------------------------------------------
   std::string loadShaderProg(const QString &_jsonFileName);
   //-----------------------------------------------------------------------------------------------------
-  /// @brief Creates a shader program and loads a vertex and fragment shader, attaching both.
-  /// @param [in] _name is the name that this shader program should be stored under.
-  /// @param [in] _shaderPaths contains paths to the vertex, fragment, and geometry shaders in that order,
-  /// any paths left blank are ignored.
+  /// @brief Starts compiling and linking a shader program from a json file, without waiting for the
+  /// driver to finish. The program is completed the first time it is accessed, so other work can be done
+  /// in the mean time. Where KHR_parallel_shader_compile is supported, all submitted programs are built
+  /// on the driver's compiler threads.
+  /// @param [in] _jsonFileName is the path to the json file.
+  /// @return is the name that this shader will be stored under.
   //-----------------------------------------------------------------------------------------------------
-  void createShader(const std::string &_name, const std::array<QString, 5> &_shaderPaths);
+  std::string submitShaderProg(const QString &_jsonFileName);
   //-----------------------------------------------------------------------------------------------------
-  /// @brief Binds a stored shader.
+  /// @brief Creates a shader program and begins compiling the given shaders, attaching all of them.
+  /// @param [in] _name is the name that this shader program should be stored under.
+  /// @param [in] _shaderPaths contains paths to the vertex, fragment, geometry, tessellation control,
+  /// tessellation evaluation and compute shaders in that order, any paths left blank are ignored.
+  /// @param [in] _defines are extra #define directives, such as "NAME" or "NAME VALUE", for every stage.
+  //-----------------------------------------------------------------------------------------------------
+  void createShader(
+      const std::string &_name,
+      const std::array<QString, 6> &_shaderPaths,
+      const std::vector<std::string> &_defines = {}
+      );
+  //-----------------------------------------------------------------------------------------------------
+  /// @brief Starts building a specialised variant of a program that was loaded from json. Each key names
+  /// a set of #defines listed under "Permutations" in the json file, so runtime switches can be compiled
+  /// out rather than branched on. Stages can also be left out, in which case the HAS_GEOMETRY and
+  /// HAS_TESSELLATION defines tell the remaining stages what they are connected to. Variants are cached,
+  /// so asking for the same keys again is cheap.
+  /// @param [in] _name is the name of the base shader program.
+  /// @param [in] _keys are the permutation keys to enable, in any order.
+  /// @param [in] _stages is a combination of STAGE_BITS, for the stages to include.
+  /// @return is the name that the variant is stored under, which is the base name if no keys are given.
+  //-----------------------------------------------------------------------------------------------------
+  std::string submitVariant(
+      const std::string &_name,
+      std::vector<std::string> _keys,
+      const unsigned _stages = ALL_STAGES
+      );
+  //-----------------------------------------------------------------------------------------------------
+  /// @brief Starts building a program pipeline from a program that was loaded from json. Every stage is
+  /// compiled once into it's own separable program, which is shared by all pipelines that use it. The
+  /// HAS_GEOMETRY and HAS_TESSELLATION defines change with the stages, so a pipeline that leaves stages
+  /// out still builds new programs for the rest. Submit pipelines ahead of time and check isReady to
+  /// switch between them without a stall.
+  /// @param [in] _name is the name of the base shader program.
+  /// @param [in] _keys are the permutation keys to enable, in any order.
+  /// @param [in] _stages is a combination of STAGE_BITS, for the stages to include.
+  /// @return is the name that the pipeline is stored under.
+  //-----------------------------------------------------------------------------------------------------
+  std::string submitPipeline(
+      const std::string &_name,
+      std::vector<std::string> _keys,
+      const unsigned _stages = ALL_STAGES
+      );
+  //-----------------------------------------------------------------------------------------------------
+  /// @brief Binds a stored pipeline, waiting for it's stages to finish building if required. The current
+  /// shader becomes the pipeline's vertex stage program.
+  /// @param [in] _name is the name of the pipeline that should be bound.
+  //-----------------------------------------------------------------------------------------------------
+  void usePipeline(const std::string& _name);
+  //-----------------------------------------------------------------------------------------------------
+  /// @brief Accesses the separable programs that make up a pipeline, waiting for them if required. As
+  /// these are never bound directly, uniforms should be set with glProgramUniform.
+  /// @param [in] _name is the name of the pipeline.
+  /// @return the program for each stage of the pipeline.
+  //-----------------------------------------------------------------------------------------------------
+  std::vector<QOpenGLShaderProgram*> getPipelineStages(const std::string& _name);
+  //-----------------------------------------------------------------------------------------------------
+  /// @brief Used to check whether a submitted program or pipeline has finished building, by polling
+  /// GL_COMPLETION_STATUS without blocking. Callers can keep drawing with another program until then.
+  /// @param [in] _name is the name of the shader program or pipeline to check.
+  /// @return true if accessing the program will not stall.
+  //-----------------------------------------------------------------------------------------------------
+  bool isReady(const std::string& _name);
+  //-----------------------------------------------------------------------------------------------------
+  /// @brief Used to get a hash of every expanded stage of a program loaded from json, which changes if
+  /// any of it's files, or the files they include, do. Bakes use this to key their on disk caches.
+  /// @param [in] _name is the name of the base shader program.
+  //-----------------------------------------------------------------------------------------------------
+  uint64_t sourceHash(const std::string& _name);
+  //-----------------------------------------------------------------------------------------------------
+  /// @brief Binds a stored shader, waiting for it to finish building if required.
   /// @param [in] _name is the name of the shader program that should be bound.
   //-----------------------------------------------------------------------------------------------------
   void useShader(const std::string& _name);
   //-----------------------------------------------------------------------------------------------------
-  /// @brief Accesses a stored shader program.
+  /// @brief Accesses a stored shader program, waiting for it to finish building if required.
   /// @param [in] _name is the name of the shader program should be accessed.
   /// @return a pointer to the specified shader.
   //-----------------------------------------------------------------------------------------------------
@@ -41,23 +128,113 @@ public:
   QOpenGLShaderProgram* getCurrentShader();
 
 private:
-  std::string loadFileToString(const std::string &_path);
-  void parseIncludes(std::string &io_shaderString);
-
-private:
-  enum SHADER_TYPES {VERTEX, FRAGMENT, GEOMETRY, TESSCONTROL, TESSEVAL};
+  enum SHADER_TYPES {VERTEX, FRAGMENT, GEOMETRY, TESSCONTROL, TESSEVAL, COMPUTE};
+  //-----------------------------------------------------------------------------------------------------
+  /// @brief A compiled shader stage, which may be shared by several programs.
+  //-----------------------------------------------------------------------------------------------------
+  struct ShaderPart
+  {
+    std::unique_ptr<QOpenGLShader> m_shader;
+    //-----------------------------------------------------------------------------------------------------
+    /// @brief The glsl file this was compiled from, parts are keyed on the path and their defines.
+    //-----------------------------------------------------------------------------------------------------
+    std::string m_path;
+    //-----------------------------------------------------------------------------------------------------
+    /// @brief Whether the compile status has been read back, we delay this as it blocks on the compiler.
+    //-----------------------------------------------------------------------------------------------------
+    bool m_checked = false;
+  };
+  //-----------------------------------------------------------------------------------------------------
+  /// @brief Everything we need to build variants of a program loaded from json.
+  //-----------------------------------------------------------------------------------------------------
+  struct ProgramDesc
+  {
+    std::array<QString, 6> m_shaderPaths;
+    //-----------------------------------------------------------------------------------------------------
+    /// @brief Maps each permutation key to the #defines that it enables.
+    //-----------------------------------------------------------------------------------------------------
+    std::unordered_map<std::string, std::vector<std::string>> m_permutations;
+  };
+  //-----------------------------------------------------------------------------------------------------
+  /// @brief A set of separable programs, along with the GL stage bits each one is used for.
+  //-----------------------------------------------------------------------------------------------------
+  struct Pipeline
+  {
+    GLuint m_id = 0;
+    std::vector<std::pair<GLbitfield, std::string>> m_stages;
+  };
+  //-----------------------------------------------------------------------------------------------------
+  /// @brief Sorts and de-duplicates permutation keys, and gathers the defines they enable.
+  //-----------------------------------------------------------------------------------------------------
+  std::vector<std::string> permutationDefines(const std::string &_name, std::vector<std::string> &io_keys);
+  //-----------------------------------------------------------------------------------------------------
+  /// @brief Builds the name suffix for a set of sorted keys and stages, so each variant is stored once.
+  //-----------------------------------------------------------------------------------------------------
+  static std::string variantSuffix(const std::vector<std::string> &_keys, const unsigned _stages);
+  //-----------------------------------------------------------------------------------------------------
+  /// @brief Adds the HAS_GEOMETRY and HAS_TESSELLATION defines for the stages that will be present.
+  //-----------------------------------------------------------------------------------------------------
+  static void addStageDefines(
+      const std::array<QString, 6> &_shaderPaths,
+      const unsigned _stages,
+      std::vector<std::string> &io_defines
+      );
+  //-----------------------------------------------------------------------------------------------------
+  /// @brief Starts compiling a shader stage, unless one with the same source and relevant defines exists.
+  /// @return the key that the stage is stored under in m_shaderParts.
+  //-----------------------------------------------------------------------------------------------------
+  std::string submitPart(
+      const std::string &_path,
+      const SHADER_TYPES _shader,
+      const std::vector<std::string> &_defines
+      );
+  //-----------------------------------------------------------------------------------------------------
+  /// @brief Inserts #define lines after the #version directive, and restores the line numbering.
+  //-----------------------------------------------------------------------------------------------------
+  static std::string injectDefines(const std::string &_source, const std::vector<std::string> &_defines);
+  //-----------------------------------------------------------------------------------------------------
+  /// @brief Queries the current context for KHR_parallel_shader_compile, and lets the driver pick how
+  /// many compiler threads to use. Only done once.
+  //-----------------------------------------------------------------------------------------------------
+  void initParallelCompile();
+  //-----------------------------------------------------------------------------------------------------
+  /// @brief Waits for a submitted program to finish building, and reports any errors.
+  /// @param [in] _name is the name of the shader program.
+  //-----------------------------------------------------------------------------------------------------
+  void finalize(const std::string& _name);
   //-----------------------------------------------------------------------------------------------------
   /// @brief A map from shader name to shader program, so that they can be reused and easily bound.
   //-----------------------------------------------------------------------------------------------------
   std::unordered_map<std::string, std::unique_ptr<QOpenGLShaderProgram>> m_shaderPrograms;
   //-----------------------------------------------------------------------------------------------------
-  /// @brief A map from shader name to shader, so that they can be reused by shader programs.
+  /// @brief A map from shader path and defines to shader, so that they can be reused by shader programs.
+  //-----------------------------------------------------------------------------------------------------
+  std::unordered_map<std::string, ShaderPart> m_shaderParts;
   //-----------------------------------------------------------------------------------------------------
-  std::unordered_map<std::string, std::unique_ptr<QOpenGLShader>> m_shaderParts;
+  /// @brief A map from shader name to the description it was loaded from, used to build variants.
+  //-----------------------------------------------------------------------------------------------------
+  std::unordered_map<std::string, ProgramDesc> m_programDescs;
+  //-----------------------------------------------------------------------------------------------------
+  /// @brief A map from pipeline name to pipeline.
+  //-----------------------------------------------------------------------------------------------------
+  std::unordered_map<std::string, Pipeline> m_pipelines;
+  //-----------------------------------------------------------------------------------------------------
+  /// @brief The shader parts of every program that has been submitted but not yet finalized.
+  //-----------------------------------------------------------------------------------------------------
+  std::unordered_map<std::string, std::vector<std::string>> m_pendingPrograms;
   //-----------------------------------------------------------------------------------------------------
   /// @brief A pointer to the currently bound shader program.
   //-----------------------------------------------------------------------------------------------------
   QOpenGLShaderProgram* m_currentShader;
+  //-----------------------------------------------------------------------------------------------------
+  /// @brief Expands includes in our shader sources, and caches the results across programs and runs.
+  //-----------------------------------------------------------------------------------------------------
+  ShaderPreprocessor m_preprocessor;
+  //-----------------------------------------------------------------------------------------------------
+  /// @brief Whether we can poll the driver for completion, without blocking.
+  //-----------------------------------------------------------------------------------------------------
+  bool m_parallelCompile = false;
+  bool m_parallelCompileChecked = false;
 };
 
 #endif // SHADERLIB_H
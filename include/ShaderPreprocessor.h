@@ -0,0 +1,98 @@
+#ifndef SHADERPREPROCESSOR_H
+#define SHADERPREPROCESSOR_H
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <unordered_set>
+#include <cstdint>
+
+//-------------------------------------------------------------------------------------------------------
+/// @brief Expands #include directives in GLSL sources. Files are read from disk once and shared between
+/// every program, nested includes are followed, each file is only included once per shader, and #line
+/// directives are emitted so that driver errors refer to the original file. Expanded sources are also
+/// stored on disk along with the hash, size and modification time of every file that contributed to
+/// them, so that a cache hit never reads the files themselves.
+//-------------------------------------------------------------------------------------------------------
+class ShaderPreprocessor
+{
+public:
+  //-----------------------------------------------------------------------------------------------------
+  /// @brief Constructor.
+  /// @param [in] _cacheDir is the directory used to store expanded sources between runs, the cache is
+  /// disabled if this is empty.
+  //-----------------------------------------------------------------------------------------------------
+  ShaderPreprocessor(const std::string &_cacheDir = "cache/shaders");
+  //-----------------------------------------------------------------------------------------------------
+  /// @brief Expands all includes for the shader at the given path.
+  /// @param [in] _path is the path to the root shader file.
+  /// @return the expanded source, ready to be compiled.
+  //-----------------------------------------------------------------------------------------------------
+  const std::string& process(const std::string &_path);
+  //-----------------------------------------------------------------------------------------------------
+  /// @brief Lists the files that make up an expanded shader, the index of each file is the source string
+  /// number used in the #line directives, so it can be used to decode a compile log.
+  /// @param [in] _path is the path to the root shader file, which must have been processed.
+  /// @return the root file followed by all of it's includes.
+  //-----------------------------------------------------------------------------------------------------
+  const std::vector<std::string>& sourceFiles(const std::string &_path) const;
+  //-----------------------------------------------------------------------------------------------------
+  /// @brief Formats the source string numbers of an expanded shader for display after a compile log.
+  /// @param [in] _path is the path to the root shader file, which must have been processed.
+  //-----------------------------------------------------------------------------------------------------
+  std::string sourceLegend(const std::string &_path) const;
+  //-----------------------------------------------------------------------------------------------------
+  /// @brief Used to get a hash of an expanded shader, which changes if any of it's files do.
+  /// @param [in] _path is the path to the root shader file, which must have been processed.
+  //-----------------------------------------------------------------------------------------------------
+  uint64_t hash(const std::string &_path) const;
+  //-----------------------------------------------------------------------------------------------------
+  /// @brief Forgets all files read so far, so that changes on disk are picked up by the next process.
+  //-----------------------------------------------------------------------------------------------------
+  void clear();
+
+private:
+  //-----------------------------------------------------------------------------------------------------
+  /// @brief A file read from disk, along with it's content hash.
+  //-----------------------------------------------------------------------------------------------------
+  struct SourceFile
+  {
+    std::string m_source;
+    uint64_t m_hash = 0;
+  };
+  //-----------------------------------------------------------------------------------------------------
+  /// @brief The result of expanding a root shader.
+  //-----------------------------------------------------------------------------------------------------
+  struct ProcessedShader
+  {
+    std::string m_source;
+    std::vector<std::string> m_files;
+    uint64_t m_hash = 0;
+  };
+
+  const SourceFile& loadFile(const std::string &_path);
+  void expand(
+      const std::string &_path,
+      std::string &o_out,
+      std::vector<std::string> &io_files,
+      std::unordered_set<std::string> &io_included
+      );
+  std::string cachePath(const std::string &_path) const;
+  bool loadCached(const std::string &_path, ProcessedShader &o_shader);
+  void saveCached(const std::string &_path, const ProcessedShader &_shader) const;
+
+  //-----------------------------------------------------------------------------------------------------
+  /// @brief Every file read so far, so that includes shared by several stages are only read once.
+  //-----------------------------------------------------------------------------------------------------
+  std::unordered_map<std::string, SourceFile> m_files;
+  //-----------------------------------------------------------------------------------------------------
+  /// @brief Every root shader expanded so far.
+  //-----------------------------------------------------------------------------------------------------
+  std::unordered_map<std::string, ProcessedShader> m_processed;
+  //-----------------------------------------------------------------------------------------------------
+  /// @brief The directory that expanded sources are cached in.
+  //-----------------------------------------------------------------------------------------------------
+  std::string m_cacheDir;
+};
+
+#endif // SHADERPREPROCESSOR_H
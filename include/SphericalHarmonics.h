@@ -0,0 +1,84 @@
+#ifndef SPHERICALHARMONICS_H
+#define SPHERICALHARMONICS_H
+
+#include <array>
+#include <string>
+#include <cstdint>
+#include "vec3.hpp"
+#include "vec4.hpp"
+
+class ThreadPool;
+
+//-------------------------------------------------------------------------------------------------------
+/// @brief CPU side mirror of the std140 IrradianceSH uniform block declared in
+/// shaders/include/sh_irradiance.h. Each coefficient is padded to a vec4, as std140 requires for arrays.
+//-------------------------------------------------------------------------------------------------------
+struct IrradianceSH
+{
+  std::array<glm::vec4, 9> coeffs {};
+};
+
+static_assert(sizeof(IrradianceSH) == 9 * 16, "IrradianceSH must match the std140 layout");
+
+//-------------------------------------------------------------------------------------------------------
+/// @brief Order 3 (9 coefficient) spherical harmonic projection of environment maps, used in place of an
+/// irradiance cube map. Everything here is plain CPU code, so it can also run without a GL context.
+//-------------------------------------------------------------------------------------------------------
+namespace SphericalHarmonics
+{
+//-------------------------------------------------------------------------------------------------------
+/// @brief Projects an equirectangular radiance map onto the first 9 SH basis functions. Rows are
+/// processed in parallel, and the image is expected bottom row first, as uploaded to GL.
+/// @param [in] _pixels points to the image data.
+/// @param [in] _width is the width of the image.
+/// @param [in] _height is the height of the image.
+/// @param [in] _components is the number of floats per pixel, at least 3.
+/// @param [io] io_pool is the pool to run the projection on.
+/// @return the radiance SH coefficients.
+//-------------------------------------------------------------------------------------------------------
+IrradianceSH projectEquirect(
+    const float* _pixels,
+    const int _width,
+    const int _height,
+    const int _components,
+    ThreadPool &io_pool
+    );
+//-------------------------------------------------------------------------------------------------------
+/// @brief Projects an equirectangular radiance map stored as half floats, such as RGBA16F upload data.
+//-------------------------------------------------------------------------------------------------------
+IrradianceSH projectEquirect(
+    const uint16_t* _halfPixels,
+    const int _width,
+    const int _height,
+    const int _components,
+    ThreadPool &io_pool
+    );
+//-------------------------------------------------------------------------------------------------------
+/// @brief Convolves radiance coefficients with the clamped cosine lobe. The result is divided by pi, so
+/// evaluating it gives the same value that our irradiance cube map used to store.
+/// @param [io] io_sh is the radiance SH to convert in place.
+//-------------------------------------------------------------------------------------------------------
+void convolveIrradiance(IrradianceSH &io_sh) noexcept;
+//-------------------------------------------------------------------------------------------------------
+/// @brief Evaluates the SH in a direction, this matches shIrradiance in the shader.
+/// @param [in] _sh is the SH to evaluate.
+/// @param [in] _dir is a normalized direction.
+//-------------------------------------------------------------------------------------------------------
+glm::vec3 evaluate(const IrradianceSH &_sh, const glm::vec3 &_dir) noexcept;
+//-------------------------------------------------------------------------------------------------------
+/// @brief Reads coefficients written by save.
+/// @param [in] _path is the file to read.
+/// @param [out] o_sh is filled with the coefficients.
+/// @return false if the file is missing or not a valid SH file.
+//-------------------------------------------------------------------------------------------------------
+bool load(const std::string &_path, IrradianceSH &o_sh);
+//-------------------------------------------------------------------------------------------------------
+/// @brief Writes coefficients to disk, creating the directory if required.
+/// @param [in] _path is the file to write.
+/// @param [in] _sh is the coefficients to write.
+/// @return false if the file couldn't be written.
+//-------------------------------------------------------------------------------------------------------
+bool save(const std::string &_path, const IrradianceSH &_sh);
+}
+
+#endif // SPHERICALHARMONICS_H
@@ -0,0 +1,88 @@
+#ifndef TEXTUREFILE_H
+#define TEXTUREFILE_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+//-------------------------------------------------------------------------------------------------------
+/// @brief A minimal binary texture container, in the spirit of KTX2. A fixed header describes the GL
+/// formats and base size, followed by a level index giving the offset and size of every mip level, with
+/// all faces (or layers) of a level stored contiguously. This is independent of GL so that it can be
+/// written by offline tools as well as the application.
+//-------------------------------------------------------------------------------------------------------
+class TextureFile
+{
+public:
+  //-----------------------------------------------------------------------------------------------------
+  /// @brief Describes the texture, the GL enums are stored as plain integers. Block compressed textures
+  /// have no pixel format or type, and their bytes per pixel is the size of a 4x4 block.
+  //-----------------------------------------------------------------------------------------------------
+  struct Header
+  {
+    uint32_t m_target = 0;
+    uint32_t m_internalFormat = 0;
+    uint32_t m_pixelFormat = 0;
+    uint32_t m_pixelType = 0;
+    uint32_t m_width = 0;
+    uint32_t m_height = 0;
+    uint32_t m_depth = 1;
+    uint32_t m_faces = 1;
+    uint32_t m_levels = 0;
+    uint32_t m_bytesPerPixel = 0;
+  };
+  //-----------------------------------------------------------------------------------------------------
+  /// @brief Constructs an empty texture.
+  //-----------------------------------------------------------------------------------------------------
+  TextureFile() = default;
+  //-----------------------------------------------------------------------------------------------------
+  /// @brief Constructs a texture and allocates storage for every level.
+  /// @param [in] _header describes the texture, the number of levels must be set.
+  //-----------------------------------------------------------------------------------------------------
+  TextureFile(const Header &_header);
+  //-----------------------------------------------------------------------------------------------------
+  /// @brief Reads a texture from disk.
+  /// @param [in] _path is the file to read.
+  /// @return false if the file is missing or malformed, in which case the texture is left empty.
+  //-----------------------------------------------------------------------------------------------------
+  bool load(const std::string &_path);
+  //-----------------------------------------------------------------------------------------------------
+  /// @brief Writes the texture to disk, creating the parent directory if required.
+  /// @param [in] _path is the file to write.
+  /// @return false if the file could not be written.
+  //-----------------------------------------------------------------------------------------------------
+  bool save(const std::string &_path) const;
+  //-----------------------------------------------------------------------------------------------------
+  /// @brief Used to access the header.
+  //-----------------------------------------------------------------------------------------------------
+  const Header& header() const noexcept;
+  //-----------------------------------------------------------------------------------------------------
+  /// @brief Used to check whether the texture holds blocks, rather than pixels.
+  //-----------------------------------------------------------------------------------------------------
+  bool isCompressed() const noexcept;
+  //-----------------------------------------------------------------------------------------------------
+  /// @brief Used to get the dimension of a mip level, given the base dimension.
+  //-----------------------------------------------------------------------------------------------------
+  static uint32_t levelDim(const uint32_t _dim, const uint32_t _level) noexcept;
+  //-----------------------------------------------------------------------------------------------------
+  /// @brief Used to get the size in bytes of a single face of a mip level.
+  //-----------------------------------------------------------------------------------------------------
+  size_t faceSize(const uint32_t _level) const noexcept;
+  //-----------------------------------------------------------------------------------------------------
+  /// @brief Used to access the pixels of one face of a mip level, tightly packed.
+  //-----------------------------------------------------------------------------------------------------
+  unsigned char* data(const uint32_t _level, const uint32_t _face = 0) noexcept;
+  const unsigned char* data(const uint32_t _level, const uint32_t _face = 0) const noexcept;
+
+private:
+  //-----------------------------------------------------------------------------------------------------
+  /// @brief Describes the format of the texture.
+  //-----------------------------------------------------------------------------------------------------
+  Header m_header;
+  //-----------------------------------------------------------------------------------------------------
+  /// @brief The pixel data of each level, with all faces stored one after another.
+  //-----------------------------------------------------------------------------------------------------
+  std::vector<std::vector<unsigned char>> m_levels;
+};
+
+#endif // TEXTUREFILE_H
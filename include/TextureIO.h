@@ -0,0 +1,84 @@
+#ifndef TEXTUREIO_H
+#define TEXTUREIO_H
+
+#include <QOpenGLTexture>
+#include <QOpenGLContext>
+#include <QOpenGLBuffer>
+#include <future>
+#include <memory>
+#include "TextureFile.h"
+#include "ThreadPool.h"
+
+//-------------------------------------------------------------------------------------------------------
+/// @brief Moves textures between the GPU and TextureFiles, so that baked results can be stored on disk.
+//-------------------------------------------------------------------------------------------------------
+namespace TextureIO
+{
+//-------------------------------------------------------------------------------------------------------
+/// @brief A read back in flight. The texture is copied in to the pixel buffer on the GPU, and the fence
+/// tells us when that copy has landed, so that it can be collected without stalling the pipeline. The
+/// buffer then stays mapped while a worker copies it in to the file.
+//-------------------------------------------------------------------------------------------------------
+struct Download
+{
+  TextureFile m_file;
+  QOpenGLBuffer m_buffer {QOpenGLBuffer::PixelPackBuffer};
+  GLsync m_fence = nullptr;
+  std::future<void> m_copy;
+};
+//-------------------------------------------------------------------------------------------------------
+/// @brief Reads back every mip level and face of a texture, waiting for the GPU to finish writing it.
+/// This is only meant for loading, while drawing use beginDownload.
+/// @param [io] io_context is the context that owns the texture.
+/// @param [in] _texture is the texture to read back, which will be bound to the active unit.
+/// @param [in] _pixelFormat is the GL format to read the pixels as.
+/// @param [in] _pixelType is the GL type to read the pixels as.
+/// @param [in] _bytesPerPixel is the size of one pixel in the given format and type.
+/// @return the texture data, ready to be saved.
+//-------------------------------------------------------------------------------------------------------
+TextureFile download(
+    QOpenGLContext* io_context,
+    QOpenGLTexture &_texture,
+    const QOpenGLTexture::PixelFormat _pixelFormat,
+    const QOpenGLTexture::PixelType _pixelType,
+    const uint32_t _bytesPerPixel
+    );
+//-------------------------------------------------------------------------------------------------------
+/// @brief Starts reading back every mip level and face of a texture, without waiting for it.
+/// @param [io] io_context is the context that owns the texture.
+/// @param [in] _texture is the texture to read back, which will be bound to the active unit. It may be
+/// released once this returns.
+/// @param [in] _pixelFormat is the GL format to read the pixels as.
+/// @param [in] _pixelType is the GL type to read the pixels as.
+/// @param [in] _bytesPerPixel is the size of one pixel in the given format and type.
+/// @param [out] o_download is reset to the new read back, collect it with finishDownload.
+//-------------------------------------------------------------------------------------------------------
+void beginDownload(
+    QOpenGLContext* io_context,
+    QOpenGLTexture &_texture,
+    const QOpenGLTexture::PixelFormat _pixelFormat,
+    const QOpenGLTexture::PixelType _pixelType,
+    const uint32_t _bytesPerPixel,
+    Download &o_download
+    );
+//-------------------------------------------------------------------------------------------------------
+/// @brief Polls a read back started by beginDownload. Once the GPU has written the pixels the buffer is
+/// mapped and copied in to the file on a worker thread, and a later call unmaps it. This never waits, so
+/// it's called again on a later frame until it succeeds.
+/// @param [io] io_context is the context that the read back was started in.
+/// @param [io] io_download is the read back to collect, which must stay in place until it's finished.
+/// @param [io] io_pool runs the copy.
+/// @return false while the read back is still in flight. Read backs that are collected, or were never
+/// started, return true.
+//-------------------------------------------------------------------------------------------------------
+bool finishDownload(QOpenGLContext* io_context, Download &io_download, ThreadPool &io_pool);
+//-------------------------------------------------------------------------------------------------------
+/// @brief Creates a texture with immutable storage, and fills every level and face from a TextureFile,
+/// which may be block compressed. Filtering and wrap modes are left for the caller to set.
+/// @param [in] _file is the texture data to upload.
+/// @param [out] o_texture is reset to the new texture.
+//-------------------------------------------------------------------------------------------------------
+void upload(const TextureFile &_file, std::unique_ptr<QOpenGLTexture> &o_texture);
+}
+
+#endif // TEXTUREIO_H
@@ -0,0 +1,66 @@
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <future>
+#include <functional>
+
+//-------------------------------------------------------------------------------------------------------
+/// @brief A fixed size pool of worker threads, used for CPU side baking and loading work.
+//-------------------------------------------------------------------------------------------------------
+class ThreadPool
+{
+public:
+  //-----------------------------------------------------------------------------------------------------
+  /// @brief Constructor, starts the worker threads.
+  /// @param [in] _numThreads is the number of workers, zero uses one per hardware thread.
+  //-----------------------------------------------------------------------------------------------------
+  explicit ThreadPool(const unsigned _numThreads = 0);
+  //-----------------------------------------------------------------------------------------------------
+  /// @brief Destructor, finishes any queued tasks and joins the workers.
+  //-----------------------------------------------------------------------------------------------------
+  ~ThreadPool();
+  ThreadPool(const ThreadPool&) = delete;
+  ThreadPool& operator=(const ThreadPool&) = delete;
+  //-----------------------------------------------------------------------------------------------------
+  /// @brief A pool shared by the whole application, created on first use.
+  //-----------------------------------------------------------------------------------------------------
+  static ThreadPool& instance();
+  //-----------------------------------------------------------------------------------------------------
+  /// @brief Queues a task to be run on a worker.
+  /// @param [in] _task is the task to run.
+  /// @return a future that becomes ready when the task has finished.
+  //-----------------------------------------------------------------------------------------------------
+  std::future<void> submit(std::function<void()> _task);
+  //-----------------------------------------------------------------------------------------------------
+  /// @brief Splits the range [0, _count) into chunks, and processes them on the workers and the calling
+  /// thread. Returns once every chunk has been processed.
+  /// @param [in] _count is the number of items to process.
+  /// @param [in] _func is called with the begin and end of each chunk.
+  /// @param [in] _grain is the smallest number of items worth putting in a chunk.
+  //-----------------------------------------------------------------------------------------------------
+  void parallelFor(
+      const size_t _count,
+      const std::function<void(size_t _begin, size_t _end)> &_func,
+      const size_t _grain = 1
+      );
+  //-----------------------------------------------------------------------------------------------------
+  /// @brief Used to get the number of worker threads.
+  //-----------------------------------------------------------------------------------------------------
+  unsigned size() const noexcept;
+
+private:
+  void workerLoop();
+
+  std::vector<std::thread> m_workers;
+  std::deque<std::packaged_task<void()>> m_tasks;
+  std::mutex m_mutex;
+  std::condition_variable m_condition;
+  bool m_stop = false;
+};
+
+#endif // THREADPOOL_H
@@ -0,0 +1,137 @@
+#ifndef UNIFORMBUFFER_H
+#define UNIFORMBUFFER_H
+
+#include <QOpenGLBuffer>
+#include <QOpenGLContext>
+#include <algorithm>
+
+//-------------------------------------------------------------------------------------------------------
+/// @brief Fixed binding points for the uniform blocks shared by all shader programs, these must match
+/// the binding layout qualifiers used in shaders/include.
+//-------------------------------------------------------------------------------------------------------
+namespace UniformBindings
+{
+enum BINDING { MATERIAL, FRAME, IRRADIANCE };
+}
+
+class UniformBuffer
+{
+public:
+  //-----------------------------------------------------------------------------------------------------
+  /// @brief Creates the GL buffer and fills it with the initial block data.
+  /// @param [io] io_context is the context used to bind the buffer to it's binding point.
+  /// @param [in] _binding is the uniform block binding point that this buffer should be attached to.
+  /// @param [in] _size is the size in bytes of the uniform block.
+  /// @param [in] _data is a pointer to the initial block data.
+  //-----------------------------------------------------------------------------------------------------
+  void init(QOpenGLContext* io_context, const GLuint _binding, const int _size, const void* _data);
+  //-----------------------------------------------------------------------------------------------------
+  /// @brief Flags a byte range of the block as changed, so that it is sent on the next upload.
+  /// @param [in] _offset is the offset in bytes of the changed range.
+  /// @param [in] _size is the size in bytes of the changed range.
+  //-----------------------------------------------------------------------------------------------------
+  void markDirty(const int _offset, const int _size) noexcept;
+  //-----------------------------------------------------------------------------------------------------
+  /// @brief Flags the whole block as changed.
+  //-----------------------------------------------------------------------------------------------------
+  void markAllDirty() noexcept;
+  //-----------------------------------------------------------------------------------------------------
+  /// @brief Sends the dirty range of the block to the GPU in a single write, and binds the buffer.
+  /// @param [in] _data is a pointer to the start of the CPU side block.
+  //-----------------------------------------------------------------------------------------------------
+  void upload(const void* _data);
+  //-----------------------------------------------------------------------------------------------------
+  /// @brief Attaches the buffer to it's uniform block binding point.
+  //-----------------------------------------------------------------------------------------------------
+  void bind();
+  //-----------------------------------------------------------------------------------------------------
+  /// @brief Used to check whether any part of the block is waiting to be uploaded.
+  /// @return true if there is a dirty range.
+  //-----------------------------------------------------------------------------------------------------
+  bool isDirty() const noexcept;
+
+private:
+  //-----------------------------------------------------------------------------------------------------
+  /// @brief The buffer object that stores our block, buffers are untyped so a vertex buffer is fine.
+  //-----------------------------------------------------------------------------------------------------
+  QOpenGLBuffer m_buffer;
+  //-----------------------------------------------------------------------------------------------------
+  /// @brief The context used to access the 4.3 functions.
+  //-----------------------------------------------------------------------------------------------------
+  QOpenGLContext* m_context = nullptr;
+  //-----------------------------------------------------------------------------------------------------
+  /// @brief The uniform block binding point.
+  //-----------------------------------------------------------------------------------------------------
+  GLuint m_binding = 0;
+  //-----------------------------------------------------------------------------------------------------
+  /// @brief The size of the block in bytes.
+  //-----------------------------------------------------------------------------------------------------
+  int m_size = 0;
+  //-----------------------------------------------------------------------------------------------------
+  /// @brief The start and end of the range that has changed since the last upload.
+  //-----------------------------------------------------------------------------------------------------
+  int m_dirtyBegin = 0;
+  int m_dirtyEnd = 0;
+};
+
+//-------------------------------------------------------------------------------------------------------
+/// @brief Mirrors a std140 uniform block with a C++ struct, changes to members are tracked so that only
+/// the modified range is sent to the GPU, once, when upload is called.
+//-------------------------------------------------------------------------------------------------------
+template <typename T>
+class UniformBlock
+{
+public:
+  UniformBlock(const T& _data = T()) :
+    m_data(_data)
+  {}
+  //-----------------------------------------------------------------------------------------------------
+  /// @brief Creates the buffer and attaches it to the given binding point.
+  //-----------------------------------------------------------------------------------------------------
+  void init(QOpenGLContext* io_context, const GLuint _binding)
+  {
+    m_buffer.init(io_context, _binding, static_cast<int>(sizeof(T)), &m_data);
+  }
+  //-----------------------------------------------------------------------------------------------------
+  /// @brief Sets a member of the block, and marks it dirty if the value has changed.
+  /// @param [in] _member is a pointer to the member that should be set.
+  /// @param [in] _value is the new value for the member.
+  //-----------------------------------------------------------------------------------------------------
+  template <typename M, typename V>
+  void set(M T::* _member, const V& _value)
+  {
+    M& field = m_data.*_member;
+    if (field == _value) return;
+    field = _value;
+    m_buffer.markDirty(offsetOf(field), static_cast<int>(sizeof(M)));
+  }
+  //-----------------------------------------------------------------------------------------------------
+  /// @brief Replaces the whole block, for data that is produced all at once.
+  /// @param [in] _data is the new block data.
+  //-----------------------------------------------------------------------------------------------------
+  void reset(const T& _data)
+  {
+    m_data = _data;
+    m_buffer.markAllDirty();
+  }
+  //-----------------------------------------------------------------------------------------------------
+  /// @brief Read only access to the CPU side copy of the block.
+  //-----------------------------------------------------------------------------------------------------
+  const T& get() const noexcept { return m_data; }
+  //-----------------------------------------------------------------------------------------------------
+  /// @brief Sends all changes since the last call to the GPU.
+  //-----------------------------------------------------------------------------------------------------
+  void upload() { m_buffer.upload(&m_data); }
+
+private:
+  template <typename M>
+  int offsetOf(const M& _field) const noexcept
+  {
+    return static_cast<int>(reinterpret_cast<const char*>(&_field) - reinterpret_cast<const char*>(&m_data));
+  }
+
+  T m_data;
+  UniformBuffer m_buffer;
+};
+
+#endif // UNIFORMBUFFER_H
@@ -12,9 +12,7 @@ out vec2 TexCoords;
 out vec3 WorldPos;
 out vec3 Normal;
 
-uniform mat4 MVP;
-uniform mat4 N;
-uniform mat4 M;
+#include "shaders/include/frame_constants.h"
 
 void main()
 {
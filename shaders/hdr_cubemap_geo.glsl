@@ -0,0 +1,23 @@
+#version 410 core
+
+// One invocation per cube face, so all six faces are written by a single draw
+layout (triangles, invocations = 6) in;
+layout (triangle_strip, max_vertices = 3) out;
+
+in vec3 vert_localPos[];
+out vec3 vs_localPos;
+
+// Capture projection multiplied by the view for each face, in face order
+uniform mat4 u_faceVP[6];
+
+void main()
+{
+  for (int i = 0; i < 3; ++i)
+  {
+    gl_Layer = gl_InvocationID;
+    vs_localPos = vert_localPos[i];
+    gl_Position = u_faceVP[gl_InvocationID] * vec4(vert_localPos[i], 1.0);
+    EmitVertex();
+  }
+  EndPrimitive();
+}
@@ -4,6 +4,10 @@ in vec3 vs_localPos;
 
 uniform samplerCube u_envMap;
 uniform float u_roughness;
+// The source cube map must be mipmapped, so that each sample can read a level that covers it's
+// solid angle, this is what lets us get away with a low sample count
+uniform uint u_sampleCount = 128u;
+uniform float u_envResolution = 512.0;
 
 
 #include "shaders/include/pbr_funcs.h"
@@ -18,7 +22,7 @@ void main()
   vec3 n, r, v;
   n = r = v = normalize(vs_localPos);
 
-  const uint k_sample_count = 1024u;
+  const uint k_sample_count = u_sampleCount;
   vec3 prefilteredColor = vec3(0.0);
   float totalWeight = 0.0;
 
@@ -36,8 +40,7 @@ void main()
       float h_dot_v = max(dot(h, v), 0.0);
       float pdf = d * n_dot_h / (4.0 * h_dot_v) + 0.0001;
 
-      float resolution = 512.0; // resolution of source cubemap (per face)
-      float saTexel  = 4.0 * k_PI / (6.0 * resolution * resolution);
+      float saTexel  = 4.0 * k_PI / (6.0 * u_envResolution * u_envResolution);
       float saSample = 1.0 / (float(k_sample_count) * pdf + 0.0001);
 
       float mipLevel = u_roughness == 0.0 ? 0.0 : 0.5 * log2(saSample / saTexel);
@@ -2,13 +2,10 @@
 
 layout (location = 0) in vec3 in_vert;
 
-out vec3 vs_localPos;
-
-uniform mat4 u_MV;
-uniform mat4 u_P;
+out vec3 vert_localPos;
 
 void main()
 {
-    vs_localPos = in_vert;
-    gl_Position =  u_P * u_MV * vec4(in_vert, 1.0);
+    // Projection happens per face in the geometry shader
+    vert_localPos = in_vert;
 }
@@ -0,0 +1,113 @@
+// Sparse volumes keep only the bricks near the owl's surface, in a pool texture. Each stored brick is
+// padded with a one texel apron so that filtering never crosses in to another brick, and an RGBA8UI
+// indirection texture holds the pool position of every brick. The volume is mipmapped, every level is
+// fitted to the surface and has it's own slices of the indirection, but shares the pool. See BrickVolume.h.
+const int k_brickDim = 8;
+const int k_paddedBrickDim = k_brickDim + 2;
+// Matches BrickVolume::k_maxLevels
+const int k_maxBrickLevels = 10;
+
+// xyz is the texel of the whole volume that each level starts at, and w is it's first indirection slice
+uniform ivec4 u_brickLevelOrigins[k_maxBrickLevels];
+// xyz is the number of bricks along each axis of each level, and w is the size of the whole volume
+uniform ivec4 u_brickLevelSizes[k_maxBrickLevels];
+uniform int u_brickLevels = 1;
+
+// ----------------------------------------------------------------------------
+// Maps a texel in to the volume, in the same way as the mirrored repeat wrap mode
+ivec3 mirrorTexel(ivec3 _texel, int _dim)
+{
+  ivec3 texel = _texel;
+  for (int i = 0; i < 3; ++i)
+  {
+    int period = 2 * _dim;
+    int t = texel[i] % period;
+    if (t < 0) t += period;
+    texel[i] = t < _dim ? t : period - t - 1;
+  }
+  return texel;
+}
+// ----------------------------------------------------------------------------
+// Unpacks an entry of the brick list, xyz is the brick within it's level and w is the level
+ivec4 unpackBrick(uint _packed)
+{
+  return ivec4(_packed & 0xFFu, (_packed >> 8u) & 0xFFu, (_packed >> 16u) & 0xFFu, _packed >> 24u);
+}
+// ----------------------------------------------------------------------------
+// The texel of the whole volume that a texel of a padded brick maps to, where zero is the apron
+ivec3 brickVolumeTexel(ivec4 _brick, ivec3 _paddedTexel)
+{
+  return u_brickLevelOrigins[_brick.w].xyz + _brick.xyz * k_brickDim + _paddedTexel - 1;
+}
+// ----------------------------------------------------------------------------
+// Finds the pool texel that holds a texel of the whole volume at a level, returns false if the brick
+// isn't stored. Texels outside of the level are clamped to it's edge
+bool brickTexel(usampler3D _indirection, int _level, ivec3 _texel, out ivec3 o_poolTexel)
+{
+  ivec4 origin = u_brickLevelOrigins[_level];
+  ivec3 texel = clamp(_texel - origin.xyz, ivec3(0), u_brickLevelSizes[_level].xyz * k_brickDim - 1);
+  ivec3 brick = texel / k_brickDim;
+  uvec4 entry = texelFetch(_indirection, brick + ivec3(0, 0, origin.w), 0);
+  o_poolTexel = ivec3(entry.xyz) * k_paddedBrickDim + 1 + texel - brick * k_brickDim;
+  return entry.w != 0u;
+}
+// ----------------------------------------------------------------------------
+// Converts a volume coordinate to a texel position in the pool at a level, along with the origin of the
+// padded brick that holds it. Bricks outside of the band read the first brick in the pool, the band is
+// conservative so this only happens if the surface is displaced further than the bake allowed for
+vec3 brickPoolTexel(usampler3D _indirection, int _level, vec3 _coord, out vec3 o_brickOrigin)
+{
+  ivec4 origin = u_brickLevelOrigins[_level];
+  ivec4 size = u_brickLevelSizes[_level];
+  vec3 texel = clamp(_coord * float(size.w) - vec3(origin.xyz), vec3(0.0), vec3(size.xyz * k_brickDim) - 0.5);
+  ivec3 brick = ivec3(texel) / k_brickDim;
+  uvec4 entry = texelFetch(_indirection, brick + ivec3(0, 0, origin.w), 0);
+  o_brickOrigin = vec3(ivec3(entry.xyz) * k_paddedBrickDim);
+  return o_brickOrigin + 1.0 + texel - vec3(brick * k_brickDim);
+}
+// ----------------------------------------------------------------------------
+// Samples a pool between two levels, the bricks of both are filtered as usual and then blended
+vec4 sampleBrickLevels(sampler3D _pool, usampler3D _indirection, vec3 _coord, float _lod)
+{
+  float lod = clamp(_lod, 0.0, float(u_brickLevels - 1));
+  int level = int(lod);
+  int next = min(level + 1, u_brickLevels - 1);
+  vec3 poolSize = vec3(textureSize(_pool, 0));
+  vec3 brickOrigin;
+  vec4 fine = texture(_pool, brickPoolTexel(_indirection, level, _coord, brickOrigin) / poolSize);
+  vec4 coarse = texture(_pool, brickPoolTexel(_indirection, next, _coord, brickOrigin) / poolSize);
+  return mix(fine, coarse, lod - float(level));
+}
+// ----------------------------------------------------------------------------
+// Takes the normal from the gradient of a pool's w channel, in the same way as owl_normal_comp.glsl. The
+// taps are one texel either side, which the apron holds, so no further indirection lookups are needed.
+// They are kept half a texel inside the apron, so filtering never blends in a neighbouring brick. The
+// taps of coarser levels are further apart, which is allowed for by the level's texel size
+vec3 brickHeightNormal(sampler3D _pool, vec3 _poolTexel, vec3 _brickOrigin, float _texelSize)
+{
+  vec3 poolSize = vec3(textureSize(_pool, 0));
+  vec3 lower = _brickOrigin + 0.5;
+  vec3 upper = _brickOrigin + float(k_paddedBrickDim) - 0.5;
+  float s01 = texture(_pool, clamp(_poolTexel - vec3(1.0, 0.0, 0.0), lower, upper) / poolSize).w;
+  float s21 = texture(_pool, clamp(_poolTexel + vec3(1.0, 0.0, 0.0), lower, upper) / poolSize).w;
+  float s10 = texture(_pool, clamp(_poolTexel - vec3(0.0, 1.0, 0.0), lower, upper) / poolSize).w;
+  float s12 = texture(_pool, clamp(_poolTexel + vec3(0.0, 1.0, 0.0), lower, upper) / poolSize).w;
+
+  vec3 va = normalize(vec3(2.0 * _texelSize, 0.0, s21 - s01));
+  vec3 vb = normalize(vec3(0.0, 2.0 * _texelSize, s12 - s10));
+  return cross(va, vb);
+}
+// ----------------------------------------------------------------------------
+// Derives the normal between two levels, the same way that sampleBrickLevels blends the pools
+vec3 brickLevelsHeightNormal(sampler3D _pool, usampler3D _indirection, vec3 _coord, float _lod)
+{
+  float lod = clamp(_lod, 0.0, float(u_brickLevels - 1));
+  int level = int(lod);
+  int next = min(level + 1, u_brickLevels - 1);
+  vec3 brickOrigin;
+  vec3 poolTexel = brickPoolTexel(_indirection, level, _coord, brickOrigin);
+  vec3 fine = brickHeightNormal(_pool, poolTexel, brickOrigin, float(1 << level));
+  poolTexel = brickPoolTexel(_indirection, next, _coord, brickOrigin);
+  vec3 coarse = brickHeightNormal(_pool, poolTexel, brickOrigin, float(1 << next));
+  return mix(fine, coarse, lod - float(level));
+}
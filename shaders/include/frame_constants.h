@@ -0,0 +1,12 @@
+// Per frame camera and transform data, written once per frame by Scene::renderScene. This is mirrored
+// by the FrameConstants struct in include/FrameConstants.h, so the order must not change.
+// The binding matches UniformBindings::FRAME.
+layout (std140, binding = 1) uniform FrameConstants
+{
+  mat4 M;
+  mat4 V;
+  mat4 P;
+  mat4 MVP;
+  mat4 N;
+  vec3 u_camPos;
+};
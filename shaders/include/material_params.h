@@ -0,0 +1,29 @@
+// Material parameters shared by every stage of the owl programs, this is mirrored by the
+// MaterialParams struct in include/MaterialParams.h, so the order must not change.
+// The binding matches UniformBindings::MATERIAL.
+layout (std140, binding = 0) uniform MaterialParams
+{
+  float u_ao;
+  float u_roughness;
+  float u_metallic;
+  float u_baseSpec;
+  float u_normalStrength;
+  float u_eyeDisp;
+  float u_eyeScale;
+  float u_eyeRotation;
+  float u_eyeWarp;
+  float u_eyeExponent;
+  float u_eyeThickness;
+  float u_eyeGap;
+  float u_eyeFuzz;
+  float u_eyeMaskCap;
+  float u_tessMaskCap;
+  float u_phongStrength;
+  vec3  u_eyeTranslate;
+  int   u_tessLevelInner;
+  int   u_tessLevelOuter;
+  // Precomputed on the CPU from the parameters above, the rotation of the first eye by u_eyeRotation
+  // about z, the second eye turns the other way which is it's transpose
+  mat3  u_eyeTwist;
+  vec3  u_eyeAlbedo;
+};
@@ -0,0 +1,46 @@
+// The owl's solid texture, shared by the volume and surface atlas bakes. Both look it up with the base
+// position mapped in to [0,1], as owl_pbr_frag.glsl does.
+const float k_scale = 5.0;
+
+uniform vec3 u_offsetPos = vec3(1.0);
+
+#include "shaders/include/perlin_noise.h"
+#include "shaders/include/owl_noise_funcs.h"
+#include "shaders/include/owl_layers.h"
+// ----------------------------------------------------------------------------
+// The weight of each noise pattern, in the order they're layered over the base colour. With a non zero
+// period every pattern repeats over it, see owl_noise_funcs.h
+float[k_numLayers] calcLayers(vec3 _uvw, vec3 _period)
+{
+  vec3 pos = _uvw * k_scale;
+  vec3 randP = (pos + u_offsetPos);
+  return float[](
+    // large darken
+    1 - clamp(1.0,0.0,blendNoise(randPos(randP + vec3(1,0,0), _period, 4, 5), _period, 0.005)),
+    // thin darkening noise
+    turb(randP, _period, 4) * blendNoise(randPos(pos, _period, 2, 15), _period, 0.01) * 0.5,
+    // small variance
+    turb(randP, _period, 4) * blendNoise(randP, _period, 2) * 2,
+    // light brushed
+    brushed(randP, _period, 0.25, vec3(20.0,1.0,1.0)) * slicednoise(randPos(randP, _period, 2), _period, 0.5, 5, 0.2),
+    // dark brushed
+    brushed(randP, _period, 0.5, vec3(5.0,25.0,1.0)) * slicednoise(randPos(randP, _period, 3), _period, 0.6, 3, 0.5),
+    // rough wood
+    veins(randP, _period, 6, 10) * slicednoise(randPos(randP, _period, 1), _period, 0.3, 3, 1.5),
+    // veins
+    veins(randP, _period, 4, 2) * slicednoise(randPos(randP, _period, 4), _period, 1, 1.25, 0.15) * 2,
+    // wood chips
+    slicednoise(randP, _period, 2.0, 0.04, 0.4)
+  );
+}
+// ----------------------------------------------------------------------------
+float[k_numLayers] calcLayers(vec3 _uvw)
+{
+  return calcLayers(_uvw, vec3(0.0));
+}
+// ----------------------------------------------------------------------------
+// Layers noise patterns over the base colour, w is the sum of the layers which is used as displacement
+vec4 calcAlbedoDisp(vec3 _uvw)
+{
+  return combineLayers(calcLayers(_uvw));
+}
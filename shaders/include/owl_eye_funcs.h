@@ -11,7 +11,7 @@ mat3 rotationMatrix3d(vec3 axis, float angle)
               oc * axis.z * axis.x - axis.y * s,  oc * axis.y * axis.z + axis.x * s,  oc * axis.z * axis.z + c);
 }
 
-vec3 eyePos(vec3 _pos, float scale, vec3 translate, float _twist)
+vec3 eyePos(vec3 _pos, float scale, vec3 translate, mat3 _twist)
 {
   vec3 newPos = _pos;
   float stretch = 1.15;
@@ -19,12 +19,17 @@ vec3 eyePos(vec3 _pos, float scale, vec3 translate, float _twist)
 
   newPos = newPos/scale - vec3(translate);
 
-  vec3 upVec = vec3(0.0, 0.0, 1.0);
-  newPos = rotationMatrix3d(upVec, _twist) * newPos;
+  newPos = _twist * newPos;
 
   return newPos;
 }
 
+vec3 eyePos(vec3 _pos, float scale, vec3 translate, float _twist)
+{
+  vec3 upVec = vec3(0.0, 0.0, 1.0);
+  return eyePos(_pos, scale, translate, rotationMatrix3d(upVec, _twist));
+}
+
 float eyeMask(vec3 _pos, float _fuzz, float _cap)
 {
   vec2 centre = vec2(0.5);
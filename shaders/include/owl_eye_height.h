@@ -0,0 +1,13 @@
+// The height of the eye rings at a base position, used to displace the surface. _z is the z of the
+// base normal, which keeps the rings to the front of the face. Needs material_params.h and
+// owl_eye_funcs.h
+float eyeHeight(vec3 _pos, float _z)
+{
+  vec3 posA = eyePos(_pos, u_eyeScale, u_eyeTranslate, u_eyeTwist);
+  _pos.x *= -1.0;
+  vec3 posB = eyePos(_pos, u_eyeScale, u_eyeTranslate, transpose(u_eyeTwist));
+  float maskA = eyeMask(posA, u_eyeFuzz, u_eyeMaskCap);
+  float maskB = eyeMask(posB, u_eyeFuzz, u_eyeMaskCap);
+  float bigMask = mask(maskA, maskB, u_eyeFuzz, _z);
+  return eyes(posA, posB, u_eyeFuzz, u_eyeGap, u_eyeThickness, u_eyeWarp, u_eyeExponent, maskA, maskB) * bigMask;
+}
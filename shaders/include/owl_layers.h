@@ -0,0 +1,46 @@
+// The owl's colours are blended over each other by eight noise layers. The layers don't depend on the
+// colours, so they're stored in a pair of RGBA8 masks, and the colours can be changed by recombining
+// them without evaluating the noise again.
+const int k_numLayers = 8;
+
+uniform vec4 u_cols[k_numLayers + 1];
+
+// The range each layer is stored in, the noise isn't bounded so these were measured over a 256^3 bake
+// with OwlNoise::layers, and given some room to spare
+const float k_layerMin[k_numLayers] = float[](0.0, -8.0, -0.5, 0.0, 0.0, 0.0, 0.0, 0.0);
+const float k_layerMax[k_numLayers] = float[](24.0, 4.0, 0.5, 1.0, 1.0, 1.0, 3.0, 1.0);
+
+// ----------------------------------------------------------------------------
+// Blends the colours by the layers, w is the sum of the layers which is used as displacement
+vec4 combineLayers(float _layers[k_numLayers])
+{
+  vec4 result = u_cols[0];
+  for (int i = 0; i < k_numLayers; ++i)
+  {
+    result.xyz = mix(result.xyz, u_cols[i + 1].xyz, _layers[i]);
+    result.w += _layers[i];
+  }
+  return result;
+}
+// ----------------------------------------------------------------------------
+// Fits the layers to their ranges, the first four go in o_low and the rest in o_high
+void packLayers(float _layers[k_numLayers], out vec4 o_low, out vec4 o_high)
+{
+  for (int i = 0; i < 4; ++i)
+  {
+    o_low[i] = (_layers[i] - k_layerMin[i]) / (k_layerMax[i] - k_layerMin[i]);
+    o_high[i] = (_layers[i + 4] - k_layerMin[i + 4]) / (k_layerMax[i + 4] - k_layerMin[i + 4]);
+  }
+}
+// ----------------------------------------------------------------------------
+// Maps a pair of masks back to the layers
+float[k_numLayers] unpackLayers(vec4 _low, vec4 _high)
+{
+  float layers[k_numLayers];
+  for (int i = 0; i < 4; ++i)
+  {
+    layers[i] = mix(k_layerMin[i], k_layerMax[i], _low[i]);
+    layers[i + 4] = mix(k_layerMin[i + 4], k_layerMax[i + 4], _high[i]);
+  }
+  return layers;
+}
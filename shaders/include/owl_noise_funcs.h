@@ -4,30 +4,71 @@ float noiseFunction(vec3 pos)
   return cnoise(pos);
 }
 
-float turb (vec3 _pos, float _frequency)
+// Tiled bakes need noise that repeats over the tile, so every pattern below also takes a period. A
+// period of zero gives the plain noise, unchanged. Periodic noise can only repeat a whole number of
+// times over the period, so each frequency is snapped to the nearest that does, and frequencies too low
+// to repeat at all are raised to one repeat per period.
+vec3 tileRepeats(vec3 _period, float _frequency)
+{
+  return max(round(_period * _frequency), vec3(1.0));
+}
+
+float periodicNoise(vec3 _pos, vec3 _period, float _frequency)
+{
+  if (_period.x <= 0.0) return noiseFunction(_pos * _frequency);
+  // The repeats are passed on exactly, rather than as period * frequency, so that pnoise's lattice wraps
+  vec3 repeats = tileRepeats(_period, _frequency);
+  return pnoise(_pos * repeats / _period, repeats);
+}
+
+// The frequency that periodicNoise is evaluated at, octaves are scaled by this to keep their gradients
+float periodicFrequency(vec3 _period, float _frequency)
+{
+  if (_period.x <= 0.0) return _frequency;
+  vec3 frequency = tileRepeats(_period, _frequency) / _period;
+  return min(frequency.x, min(frequency.y, frequency.z));
+}
+
+float turb (vec3 _pos, vec3 _period, float _frequency)
 {
   vec3 pos = _pos;
   float ret = 0;
   float frequency = _frequency;
   for(int i = 0; i < 8; ++i)
   {
-    ret += abs(noiseFunction(pos*frequency))/frequency;
+    ret += abs(periodicNoise(pos, _period, frequency))/periodicFrequency(_period, frequency);
     frequency*=2.1;
   }
   return ret;
 }
 
+float turb (vec3 _pos, float _frequency)
+{
+  return turb(_pos, vec3(0.0), _frequency);
+}
+
+float slicednoise (vec3 pos, vec3 period, float frequency, float fuzz, float slice)
+{
+  return smoothstep(slice, slice + fuzz, turb(pos, period, frequency));
+}
+
 float slicednoise (vec3 pos, float frequency, float fuzz, float slice)
 {
-  return smoothstep(slice, slice + fuzz, turb(pos, frequency));
+  return slicednoise(pos, vec3(0.0), frequency, fuzz, slice);
 }
 
-float brushed (vec3 _pos, float frequency, vec3 stretch)
+float brushed (vec3 _pos, vec3 _period, float frequency, vec3 stretch)
 {
   vec3 pos = _pos;
-  pos += noiseFunction(pos*frequency)/frequency;
+  pos += periodicNoise(pos, _period, frequency)/periodicFrequency(_period, frequency);
   pos *= stretch;
-  return turb(pos, frequency*2);
+  // Stretching the position stretches the period with it
+  return turb(pos, _period * stretch, frequency*2);
+}
+
+float brushed (vec3 _pos, float frequency, vec3 stretch)
+{
+  return brushed(_pos, vec3(0.0), frequency, stretch);
 }
 
 float dots(vec3 _pos)
@@ -36,24 +77,46 @@ float dots(vec3 _pos)
   return 1 - slicednoise(pos, 4, 0.01, 0.02);
 }
 
-float veins(vec3 _pos, float frequency, float stretch)
+float veins(vec3 _pos, vec3 _period, float frequency, float stretch)
 {
   vec3 pos = _pos;
+  vec3 period = _period;
   pos[0] *= stretch;
-  return 1 - slicednoise(pos, frequency, 0.05, 0.01);
+  period[0] *= stretch;
+  return 1 - slicednoise(pos, period, frequency, 0.05, 0.01);
+}
+
+float veins(vec3 _pos, float frequency, float stretch)
+{
+  return veins(_pos, vec3(0.0), frequency, stretch);
+}
+
+vec3 randPos(vec3 _pos, vec3 _period, float rand, float scale)
+{
+  return _pos + periodicNoise(_pos + rand, _period, 1.0) * scale;
 }
 
 vec3 randPos(vec3 _pos, float rand, float scale)
 {
-  return _pos + noiseFunction(_pos + rand) * scale;
+  return randPos(_pos, vec3(0.0), rand, scale);
+}
+
+vec3 randPos(vec3 _pos, vec3 _period, float rand)
+{
+  return randPos(_pos, _period, rand, 1.0);
 }
 
 vec3 randPos(vec3 _pos, float rand)
 {
-  return _pos + noiseFunction(_pos + rand);
+  return randPos(_pos, vec3(0.0), rand, 1.0);
+}
+
+float blendNoise(vec3 pos, vec3 period, float freq)
+{
+  return periodicNoise(randPos(pos,period,0,1), period, freq)/periodicFrequency(period, freq);
 }
 
 float blendNoise(vec3 pos, float freq)
 {
-  return noiseFunction(randPos(pos,0,1) * freq)/freq;
+  return blendNoise(pos, vec3(0.0), freq);
 }
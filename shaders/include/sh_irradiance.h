@@ -0,0 +1,23 @@
+// Diffuse irradiance as 9 spherical harmonic coefficients, projected on the CPU by
+// SphericalHarmonics::projectEquirect. This is mirrored by the IrradianceSH struct in
+// include/SphericalHarmonics.h, and the binding matches UniformBindings::IRRADIANCE.
+layout (std140, binding = 2) uniform IrradianceSH
+{
+  vec4 u_irradianceSH[9];
+};
+
+// Matches SphericalHarmonics::evaluate, the result is irradiance divided by pi
+vec3 shIrradiance(vec3 n)
+{
+  return max(
+        u_irradianceSH[0].rgb * 0.282095 +
+        u_irradianceSH[1].rgb * (0.488603 * n.y) +
+        u_irradianceSH[2].rgb * (0.488603 * n.z) +
+        u_irradianceSH[3].rgb * (0.488603 * n.x) +
+        u_irradianceSH[4].rgb * (1.092548 * n.x * n.y) +
+        u_irradianceSH[5].rgb * (1.092548 * n.y * n.z) +
+        u_irradianceSH[6].rgb * (0.315392 * (3.0 * n.z * n.z - 1.0)) +
+        u_irradianceSH[7].rgb * (1.092548 * n.x * n.z) +
+        u_irradianceSH[8].rgb * (0.546274 * (n.x * n.x - n.y * n.y)),
+        vec3(0.0));
+}
@@ -0,0 +1,42 @@
+// Tiled volumes hold a small dense bake of periodic noise, which repeats seamlessly across the whole
+// volume with the repeat wrap mode, in place of the brick pools. A detail tile that repeats at another
+// scale is blended over it by a low frequency mask, so that the repetition is harder to pick out. Both
+// are mipmapped, so the hardware filters them. See owl_tile_comp.glsl.
+uniform sampler3D u_detailMap;
+// The number of times each tile repeats across the volume, x is the tile and y the detail tile
+uniform vec2 u_tileRepeats = vec2(1.0);
+// The size of each tile's texels in texels of the full volume, which the derived normals allow for
+uniform vec2 u_tileTexelSizes = vec2(1.0);
+// The detail mask varies a few times across the owl, slower than either tile repeats
+const float k_detailMaskFrequency = 2.0;
+
+// ----------------------------------------------------------------------------
+// Takes the normal from the gradient of a tile's w channel, in the same way as brickHeightNormal. The
+// taps wrap around the tile like any other lookup, so they need no clamping
+vec3 tileHeightNormal(sampler3D _tile, vec3 _tileCoord, float _texelSize)
+{
+  vec3 texel = 1.0 / vec3(textureSize(_tile, 0));
+  float s01 = texture(_tile, _tileCoord - vec3(texel.x, 0.0, 0.0)).w;
+  float s21 = texture(_tile, _tileCoord + vec3(texel.x, 0.0, 0.0)).w;
+  float s10 = texture(_tile, _tileCoord - vec3(0.0, texel.y, 0.0)).w;
+  float s12 = texture(_tile, _tileCoord + vec3(0.0, texel.y, 0.0)).w;
+
+  vec3 va = normalize(vec3(2.0 * _texelSize, 0.0, s21 - s01));
+  vec3 vb = normalize(vec3(0.0, 2.0 * _texelSize, s12 - s10));
+  return cross(va, vb);
+}
+// ----------------------------------------------------------------------------
+// Samples the tiles at a volume coordinate, along with the normal derived from their displacement
+vec4 sampleTiles(sampler3D _tile, vec3 _coord, out vec3 o_normal)
+{
+  vec3 tileCoord = _coord * u_tileRepeats.x;
+  vec4 albedo = texture(_tile, tileCoord);
+  o_normal = tileHeightNormal(_tile, tileCoord, u_tileTexelSizes.x);
+#ifdef DETAIL_TILE
+  float detail = smoothstep(-0.3, 0.3, cnoise(_coord * k_detailMaskFrequency));
+  vec3 detailCoord = _coord * u_tileRepeats.y;
+  albedo = mix(albedo, texture(u_detailMap, detailCoord), detail);
+  o_normal = normalize(mix(o_normal, tileHeightNormal(u_detailMap, detailCoord, u_tileTexelSizes.y), detail));
+#endif
+  return albedo;
+}
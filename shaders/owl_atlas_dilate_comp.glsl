@@ -0,0 +1,47 @@
+#version 430 core
+
+// One step of seam dilation over both atlases. Texels that no triangle covered take the average of their
+// covered neighbours, so that filtering across a UV seam never reads the cleared background.
+layout(local_size_x = 16, local_size_y = 16) in;
+layout(rgba16f, binding = 0) uniform writeonly image2D u_albedoOut;
+layout(rgba16f, binding = 1) uniform writeonly image2D u_normalOut;
+
+uniform sampler2D u_albedoAtlas;
+// Coverage is stored in the normal's w
+uniform sampler2D u_normalAtlas;
+
+// ----------------------------------------------------------------------------
+void main()
+{
+  ivec2 size = textureSize(u_normalAtlas, 0);
+  ivec2 texel = ivec2(gl_GlobalInvocationID.xy);
+  if (any(greaterThanEqual(texel, size))) return;
+
+  vec4 albedo = texelFetch(u_albedoAtlas, texel, 0);
+  vec4 normal = texelFetch(u_normalAtlas, texel, 0);
+  if (normal.w == 0.0)
+  {
+    vec4 albedoSum = vec4(0.0);
+    vec3 normalSum = vec3(0.0);
+    float count = 0.0;
+    for (int y = -1; y <= 1; ++y)
+    {
+      for (int x = -1; x <= 1; ++x)
+      {
+        ivec2 neighbour = clamp(texel + ivec2(x, y), ivec2(0), size - 1);
+        vec4 neighbourNormal = texelFetch(u_normalAtlas, neighbour, 0);
+        if (neighbourNormal.w == 0.0) continue;
+        albedoSum += texelFetch(u_albedoAtlas, neighbour, 0);
+        normalSum += neighbourNormal.xyz;
+        count += 1.0;
+      }
+    }
+    if (count > 0.0)
+    {
+      albedo = albedoSum / count;
+      normal = vec4(normalSum / count, 1.0);
+    }
+  }
+  imageStore(u_albedoOut, texel, albedo);
+  imageStore(u_normalOut, texel, normal);
+}
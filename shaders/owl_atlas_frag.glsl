@@ -0,0 +1,40 @@
+#version 430 core
+
+// Evaluates the owl's solid texture at the base position of each atlas texel. The NORMALS permutation
+// writes the normal map instead, with coverage in w so that the seams can be dilated afterwards.
+layout (location = 0) in vec3 vs_basePosition;
+layout (location = 0) out vec4 FragColour;
+
+// The normals take their gradients across a texel of the volume they replace
+uniform int u_volumeDim = 512;
+
+#include "shaders/include/owl_albedo.h"
+
+const vec2 k_size = vec2(2.0,0.0);
+
+// ----------------------------------------------------------------------------
+// Maps a base position in to the volume in the same way as owl_pbr_frag.glsl, including the mirrored wrap
+// that the volume bake applies
+vec3 volumeCoord(vec3 _offset)
+{
+  vec3 coord = vs_basePosition * 0.2 + vec3(0.5, 0.55, 0.5) + _offset;
+  return 1.0 - abs(mod(coord, 2.0) - 1.0);
+}
+// ----------------------------------------------------------------------------
+void main()
+{
+#ifdef NORMALS
+  float texel = 1.0 / float(u_volumeDim);
+  float s01 = calcAlbedoDisp(volumeCoord(vec3(-texel, 0.0, 0.0))).w;
+  float s21 = calcAlbedoDisp(volumeCoord(vec3( texel, 0.0, 0.0))).w;
+  float s10 = calcAlbedoDisp(volumeCoord(vec3(0.0, -texel, 0.0))).w;
+  float s12 = calcAlbedoDisp(volumeCoord(vec3(0.0,  texel, 0.0))).w;
+
+  vec3 va = normalize(vec3(k_size.xy, s21-s01));
+  vec3 vb = normalize(vec3(k_size.yx, s12-s10));
+
+  FragColour = vec4(cross(va,vb), 1.0);
+#else
+  FragColour = calcAlbedoDisp(volumeCoord(vec3(0.0)));
+#endif
+}
@@ -0,0 +1,13 @@
+#version 430 core
+
+// Rasterizes the base mesh in UV space, so every texel of the atlas receives it's interpolated base position
+layout (location = 0) in vec3 in_vert;
+layout (location = 1) in vec2 in_uv;
+
+layout (location = 0) out vec3 vs_basePosition;
+
+void main()
+{
+  vs_basePosition = in_vert;
+  gl_Position = vec4(in_uv * 2.0 - 1.0, 0.0, 1.0);
+}
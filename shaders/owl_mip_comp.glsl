@@ -0,0 +1,47 @@
+#version 430 core
+
+#include "shaders/include/brick_volume.h"
+
+// Each work group writes one padded brick of a level, by averaging the level below it in the same pool
+// Layout qualifiers must be literals before GLSL 4.40, these match k_paddedBrickDim
+layout(local_size_x = 10, local_size_y = 10, local_size_z = 10) in;
+layout(rgba16f, binding = 0) uniform writeonly image3D u_pool;
+// The coordinate of every brick in the pool, packed as x | y << 8 | z << 16 | level << 24
+layout(std430, binding = 1) readonly buffer BrickList
+{
+  uint u_bricks[];
+};
+
+uniform uint u_layerOffset = 0u;
+uniform int u_level = 1;
+// The same pool as u_pool, the finer level was written by an earlier dispatch
+uniform sampler3D u_finePool;
+uniform usampler3D u_brickIndirection;
+
+// ----------------------------------------------------------------------------
+void main()
+{
+  uvec3 poolBrick = gl_WorkGroupID + uvec3(0u, 0u, u_layerOffset);
+  uvec3 poolBricks = uvec3(imageSize(u_pool)) / uint(k_paddedBrickDim);
+  uint brickIndex = poolBrick.x + poolBricks.x * (poolBrick.y + poolBricks.y * poolBrick.z);
+  // Layers are shared between levels at either end
+  if (brickIndex >= uint(u_bricks.length())) return;
+  ivec4 brick = unpackBrick(u_bricks[brickIndex]);
+  if (brick.w != u_level) return;
+
+  // Every texel is the average of the eight beneath it, the finer band is narrower in texels of this
+  // level, so any that weren't stored are left out. They are only missing far from the surface
+  ivec3 fine = brickVolumeTexel(brick, ivec3(gl_LocalInvocationID)) * 2;
+  vec4 sum = vec4(0.0);
+  float count = 0.0;
+  for (int i = 0; i < 8; ++i)
+  {
+    ivec3 poolTexel;
+    if (brickTexel(u_brickIndirection, u_level - 1, fine + ivec3(i & 1, (i >> 1) & 1, i >> 2), poolTexel))
+    {
+      sum += texelFetch(u_finePool, poolTexel, 0);
+      count += 1.0;
+    }
+  }
+  imageStore(u_pool, ivec3(poolBrick) * k_paddedBrickDim + ivec3(gl_LocalInvocationID), sum / max(count, 1.0));
+}
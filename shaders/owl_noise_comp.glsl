@@ -0,0 +1,45 @@
+#version 430 core
+
+#include "shaders/include/brick_volume.h"
+
+// Each work group writes one padded brick of the albedo pool, the layer offset lets a bake be split up
+// Layout qualifiers must be literals before GLSL 4.40, these match k_paddedBrickDim
+layout(local_size_x = 10, local_size_y = 10, local_size_z = 10) in;
+layout(rgba16f, binding = 0) uniform writeonly image3D u_albedoMap;
+// The layers are kept alongside, so that the colours can be changed by owl_recombine_comp.glsl
+layout(rgba8, binding = 1) uniform writeonly image3D u_layersLow;
+layout(rgba8, binding = 2) uniform writeonly image3D u_layersHigh;
+// The coordinate of every brick in the pool, packed as x | y << 8 | z << 16 | level << 24
+layout(std430, binding = 1) readonly buffer BrickList
+{
+  uint u_bricks[];
+};
+
+uniform uint u_layerOffset = 0u;
+
+#include "shaders/include/owl_albedo.h"
+// ----------------------------------------------------------------------------
+void main() 
+{
+  uvec3 poolBrick = gl_WorkGroupID + uvec3(0u, 0u, u_layerOffset);
+  uvec3 poolBricks = uvec3(imageSize(u_albedoMap)) / uint(k_paddedBrickDim);
+  uint brickIndex = poolBrick.x + poolBricks.x * (poolBrick.y + poolBricks.y * poolBrick.z);
+  // The last layer of the finest level is usually shared with the next, which owl_mip_comp.glsl writes
+  if (brickIndex >= uint(u_bricks.length())) return;
+  ivec4 brick = unpackBrick(u_bricks[brickIndex]);
+  if (brick.w != 0) return;
+
+  // The apron holds the neighbouring texels of the whole volume, which is wrapped as it was when dense
+  int volumeDim = u_brickLevelSizes[0].w;
+  ivec3 texel = mirrorTexel(brickVolumeTexel(brick, ivec3(gl_LocalInvocationID)), volumeDim);
+  // Matches the old per slice draws, texel centres across each slice and the slice index in depth
+  float dim = float(volumeDim);
+  vec3 uvw = vec3((vec2(texel.xy) + 0.5) / dim, float(texel.z) / dim);
+  ivec3 poolTexel = ivec3(poolBrick) * k_paddedBrickDim + ivec3(gl_LocalInvocationID);
+  float layers[k_numLayers] = calcLayers(uvw);
+  vec4 low, high;
+  packLayers(layers, low, high);
+  imageStore(u_albedoMap, poolTexel, combineLayers(layers));
+  imageStore(u_layersLow, poolTexel, low);
+  imageStore(u_layersHigh, poolTexel, high);
+}
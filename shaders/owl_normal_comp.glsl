@@ -0,0 +1,66 @@
+#version 430 core
+
+#include "shaders/include/brick_volume.h"
+
+// Each work group writes one padded brick of the normal pool, the layer offset lets a bake be split up
+// Layout qualifiers must be literals before GLSL 4.40, these match k_paddedBrickDim
+layout(local_size_x = 10, local_size_y = 10, local_size_z = 10) in;
+layout(rgba16f, binding = 0) uniform writeonly image3D u_normalMap;
+// The coordinate of every brick in the pool, packed as x | y << 8 | z << 16 | level << 24
+layout(std430, binding = 1) readonly buffer BrickList
+{
+  uint u_bricks[];
+};
+
+uniform uint u_layerOffset = 0u;
+uniform sampler3D u_bumpMap;
+uniform usampler3D u_brickIndirection;
+
+const uvec3 k_groupSize = gl_WorkGroupSize;
+// The tile holds every height in the group, plus a one texel border for the gradient taps
+const uvec3 k_tileSize = uvec3(k_groupSize.xy + 2u, k_groupSize.z);
+const uint k_tileCount = k_tileSize.x * k_tileSize.y * k_tileSize.z;
+const uint k_groupCount = k_groupSize.x * k_groupSize.y * k_groupSize.z;
+
+const vec2 k_size = vec2(2.0,0.0);
+
+shared float s_heights[k_tileSize.z][k_tileSize.y][k_tileSize.x];
+
+// ----------------------------------------------------------------------------
+void main() 
+{
+  uvec3 poolBrick = gl_WorkGroupID + uvec3(0u, 0u, u_layerOffset);
+  uvec3 poolBricks = uvec3(imageSize(u_normalMap)) / uint(k_paddedBrickDim);
+  uint brickIndex = poolBrick.x + poolBricks.x * (poolBrick.y + poolBricks.y * poolBrick.z);
+  // The last layer of the finest level is usually shared with the next, barriers can't follow a return
+  // so the groups of other levels run through without storing anything
+  ivec4 brick = unpackBrick(brickIndex < uint(u_bricks.length()) ? u_bricks[brickIndex] : 0xFF000000u);
+  bool used = brick.w == 0;
+  ivec3 brickOrigin = used ? brickVolumeTexel(brick, ivec3(0)) : ivec3(0);
+  ivec3 poolOrigin = ivec3(poolBrick) * k_paddedBrickDim;
+
+  // Each height is fetched once, rather than by all four of it's neighbours
+  for (uint i = gl_LocalInvocationIndex; used && i < k_tileCount; i += k_groupCount)
+  {
+    uvec3 tile = uvec3(i % k_tileSize.x, (i / k_tileSize.x) % k_tileSize.y, i / (k_tileSize.x * k_tileSize.y));
+    ivec3 texel = brickOrigin + ivec3(tile) - ivec3(1, 1, 0);
+    // The border can reach in to bricks that aren't stored, where we fall back to our own apron
+    ivec3 poolTexel;
+    if (!brickTexel(u_brickIndirection, 0, texel, poolTexel))
+      poolTexel = poolOrigin + clamp(texel - brickOrigin, ivec3(0), ivec3(k_paddedBrickDim - 1));
+    s_heights[tile.z][tile.y][tile.x] = texelFetch(u_bumpMap, poolTexel, 0).w;
+  }
+  barrier();
+  if (!used) return;
+
+  uvec3 tile = gl_LocalInvocationID + uvec3(1u, 1u, 0u);
+  float s01 = s_heights[tile.z][tile.y][tile.x - 1u];
+  float s21 = s_heights[tile.z][tile.y][tile.x + 1u];
+  float s10 = s_heights[tile.z][tile.y - 1u][tile.x];
+  float s12 = s_heights[tile.z][tile.y + 1u][tile.x];
+
+  vec3 va = normalize(vec3(k_size.xy, s21-s01));
+  vec3 vb = normalize(vec3(k_size.yx, s12-s10));
+
+  imageStore(u_normalMap, poolOrigin + ivec3(gl_LocalInvocationID), vec4(cross(va,vb), 0.0));
+}
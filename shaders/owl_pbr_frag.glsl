@@ -4,34 +4,52 @@
 // This code is based on code from here https://learnopengl.com/#!PBR/Lighting
 layout (location = 0) out vec4 FragColour;
 
-in struct
+// We read the tessellation outputs, or the vertex outputs without tessellation, both are displaced
+layout (location = 0) in struct
 {
-  vec3 world_position;
+  vec3 position;
   vec3 base_position;
   vec3 normal;
+  vec3 base_normal;
   vec2 uv;
   float eyeVal;
-} go_out;
+} fs_in;
 
-// material parameters
+// material parameters, every volume is a brick pool and they share the same indirection, unless they
+// are tiled in which case the albedo map is a tile, see volume_tile.h
 uniform sampler3D u_albedoMap;
 uniform sampler3D u_normalMap;
-uniform float u_metallic = 0.0;
-uniform float u_roughness = 0.0;
-uniform float u_ao = 0.0;
-uniform float u_baseSpec = 0.0;
-uniform float u_normalStrength = 0.0;
+// The displacement is read from w, this is the albedo pool unless it was compressed
+uniform sampler3D u_heightMap;
+uniform usampler3D u_brickIndirection;
+// Compressed pools store each channel fitted to a range, which these map back
+uniform vec3 u_albedoScale = vec3(1.0);
+uniform vec3 u_albedoBias = vec3(0.0);
+uniform vec3 u_normalScale = vec3(1.0);
+uniform vec3 u_normalBias = vec3(0.0);
+#include "shaders/include/brick_volume.h"
+#ifdef SURFACE_ATLAS
+// The same values baked against the mesh's UVs, used in place of the volumes
+uniform sampler2D u_albedoAtlas;
+uniform sampler2D u_normalAtlas;
+#endif
+#include "shaders/include/material_params.h"
 // camera parameters
-uniform vec3 u_camPos;
+#include "shaders/include/frame_constants.h"
 //env map params
-uniform samplerCube u_irradianceMap;
+#include "shaders/include/sh_irradiance.h"
 uniform samplerCube u_prefilterMap;
 uniform sampler2D   u_brdfMap;
-//vert params
-uniform vec3 u_offsetPos = vec3(0.0);
 
 
-// lights
+// lights, the count can be overriden by a permutation
+#ifndef NUM_LIGHTS
+#define NUM_LIGHTS 4
+#endif
+// Only four lights are defined below, permutations can use fewer but not more
+#if NUM_LIGHTS > 4
+#error NUM_LIGHTS can be at most 4
+#endif
 const float k_scale = 10.0f;
 const float k_lightHeight = 4.0f;
 const vec3 k_lightPositions[4] = vec3[4](
@@ -54,6 +72,9 @@ const float k_PI = 3.14159265359;
 
 #include "shaders/include/perlin_noise.h"
 #include "shaders/include/owl_noise_funcs.h"
+#ifdef TILED_VOLUMES
+#include "shaders/include/volume_tile.h"
+#endif
 #include "shaders/include/owl_eye_funcs.h"
 #include "shaders/include/owl_bump_funcs.h"
 #include "shaders/include/pbr_funcs.h"
@@ -61,11 +82,51 @@ const float k_PI = 3.14159265359;
 
 void main()
 {
+  // The displaced eyes are shaded with the normal of the displaced triangle, which the derivatives of
+  // the position give us, blended in by the height
+  vec3 faceNormal = normalize(cross(dFdx(fs_in.position), dFdy(fs_in.position)));
+  vec3 vertexNormal = normalize(fs_in.normal);
+  faceNormal *= sign(dot(faceNormal, vertexNormal));
+  vec3 normal = mix(vertexNormal, faceNormal, fs_in.eyeVal);
+  vec3 worldPosition = vec3(M * vec4(fs_in.position, 1.0));
   // We use the base position to look-up our textures so that animation doesn't slide through
-  vec3 coord = go_out.base_position * 0.2 + vec3(0.5, 0.55, 0.5);
-
+#if !defined(SURFACE_ATLAS) || defined(ATLAS_DIFF)
+  vec3 volumeCoord = fs_in.base_position * 0.2 + vec3(0.5, 0.55, 0.5);
+#ifdef TILED_VOLUMES
+  // The tiles are dense and mipmapped, so they're filtered as usual, and always derive their normals
+  vec3 tileNormal;
+  vec4 volumeAlbedo = sampleTiles(u_albedoMap, volumeCoord, tileNormal);
+  vec4 volumeNormal = vec4(tileNormal, 0.0);
+#else
+  // The level is picked from the fragment's footprint in texels of the finest level, and the two nearest
+  // levels are blended for trilinear filtering
+  vec3 texelDx = dFdx(volumeCoord) * float(u_brickLevelSizes[0].w);
+  vec3 texelDy = dFdy(volumeCoord) * float(u_brickLevelSizes[0].w);
+  float lod = 0.5 * log2(max(dot(texelDx, texelDx), dot(texelDy, texelDy)));
+  vec4 volumeAlbedo = vec4(
+        sampleBrickLevels(u_albedoMap, u_brickIndirection, volumeCoord, lod).xyz * u_albedoScale + u_albedoBias,
+        sampleBrickLevels(u_heightMap, u_brickIndirection, volumeCoord, lod).w
+        );
+#ifdef DERIVED_NORMALS
+  // There is no normal volume, so the normal is derived from the albedo's displacement as it's needed
+  vec4 volumeNormal = vec4(brickLevelsHeightNormal(u_heightMap, u_brickIndirection, volumeCoord, lod), 0.0);
+#else
+  vec4 volumeNormal = sampleBrickLevels(u_normalMap, u_brickIndirection, volumeCoord, lod);
+  volumeNormal.xyz = volumeNormal.xyz * u_normalScale + u_normalBias;
+#endif
+#endif
+#endif
+
+#ifdef NO_NORMAL_MAP
+  // With a normal strength of zero the normal map has no effect, so we skip the lookup entirely
+  vec3 perturbedNormal = normalize(normal);
+#else
   // Retrieve our normal map value
-  vec4 normalAdjust = texture(u_normalMap, coord);
+#ifdef SURFACE_ATLAS
+  vec4 normalAdjust = texture(u_normalAtlas, fs_in.uv);
+#else
+  vec4 normalAdjust = volumeNormal;
+#endif
 
   // Extract the normal from the normal map (rescale to [-1,1]
   vec3 tgt = normalAdjust.rgb * 2.0 - 1.0;
@@ -74,16 +135,21 @@ void main()
   vec3 src = vec3(0.0, 0.0, 1.0);
 
   // Perturb the normal according to the target
-  vec3 perturbedNormal = normalize(mix(go_out.normal, rotateVector(src, tgt, go_out.normal), u_normalStrength));
+  vec3 perturbedNormal = normalize(mix(normal, rotateVector(src, tgt, normal), u_normalStrength));
+#endif
 
   // Get the albedo map val
-  vec4 albedoDisp = texture(u_albedoMap, coord);
+#ifdef SURFACE_ATLAS
+  vec4 albedoDisp = texture(u_albedoAtlas, fs_in.uv);
+#else
+  vec4 albedoDisp = volumeAlbedo;
+#endif
   // Apply new albedo for the eyes
-  vec3 eyeAlbedo = mix(albedoDisp.xyz, vec3(0.4, 0.34, 0.38) * turb(u_offsetPos, 10), go_out.eyeVal);
+  vec3 eyeAlbedo = mix(albedoDisp.xyz, u_eyeAlbedo, fs_in.eyeVal);
 
   // Final inputs to the reflectance equation
   vec3 n = perturbedNormal;
-  vec3 v = normalize(u_camPos - go_out.world_position);
+  vec3 v = normalize(u_camPos - worldPosition);
 
 
   // use albedo as f0 when metallic, otherwise use the set uniform
@@ -91,10 +157,10 @@ void main()
 
   // reflectance equation
   vec3 light_out = vec3(0.0);
-  for(int i = 0; i < 4; ++i)
+  for(int i = 0; i < NUM_LIGHTS; ++i)
   {
     vec3 trans = vec3(0.0, 0.0, -2.0);
-    vec3 ray = k_lightPositions[i] - go_out.world_position + trans;
+    vec3 ray = k_lightPositions[i] - worldPosition + trans;
     // calculate per-light radiance
     vec3 l = normalize(ray);
     vec3 h = normalize(v + l);
@@ -125,7 +191,7 @@ void main()
 
   vec3 f = fresnelSchlickRoughness(max(dot(n, v), 0.0), f0, u_roughness);
 
-  vec3 irradiance = texture(u_irradianceMap, n).rgb;
+  vec3 irradiance = shIrradiance(n);
   vec3 diffuse = diffuseTerm(f, u_metallic) * (irradiance * eyeAlbedo);
 
 
@@ -146,5 +212,18 @@ void main()
   // gamma correct
   color = pow(color, vec3(1.0/2.2));
 
+#ifdef ATLAS_DIFF
+  // Shows where the atlas differs from the volumes, red is the albedo error, green the normal error and
+  // blue the displacement error, all scaled up so that small differences are visible
+  const float k_diffScale = 10.0;
+  vec4 albedoError = abs(albedoDisp - volumeAlbedo);
+  vec3 normalError = abs(texture(u_normalAtlas, fs_in.uv).xyz - volumeNormal.xyz);
+  FragColour = vec4(vec3(
+                      max(albedoError.x, max(albedoError.y, albedoError.z)),
+                      max(normalError.x, max(normalError.y, normalError.z)),
+                      albedoError.w
+                      ) * k_diffScale, 1.0);
+#else
   FragColour = vec4(color, 1.0);
+#endif
 }
@@ -2,7 +2,7 @@
 
 layout(vertices = 3) out;
 
-in struct
+layout (location = 0) in struct
 {
   vec3 position;
   vec3 base_position;
@@ -11,7 +11,7 @@ in struct
   vec2 uv;
 } vs_out[];
 
-out struct
+layout (location = 0) out struct
 {
   vec3 position;
   vec3 base_position;
@@ -22,14 +22,17 @@ out struct
   float tess_mask;
 } tc_out[];
 
-uniform int u_tessLevelInner = 1;
-uniform int u_tessLevelOuter = 1;
-uniform float u_eyeRotation = 7.0;
-uniform float u_eyeScale     = 1.55;
-uniform vec3  u_eyeTranslate = vec3(0.21, 0.3, 0.0);
-uniform float u_eyeFuzz      = 0.02;
-uniform float u_tessMaskCap = 1.0;
+in gl_PerVertex
+{
+  vec4 gl_Position;
+} gl_in[gl_MaxPatchVertices];
+
+out gl_PerVertex
+{
+  vec4 gl_Position;
+} gl_out[];
 
+#include "shaders/include/material_params.h"
 #include "shaders/include/owl_eye_funcs.h"
 #define ID gl_InvocationID
 
@@ -41,18 +44,19 @@ float PIi(int i, vec3 q)
 
 void main(void)
 {
-  // compute patch data
+#ifndef FLAT_TESS
+  // compute patch data, only needed for phong tessellation
   for (int i = 0; i < 3; ++i)
   {
     int j = (i + 1) % 3;
     tc_out[ID].phong_patch[i] = PIi(i, vs_out[j].position) + PIi(j, vs_out[i].position);
   }
+#endif
 
   vec3 pos = vs_out[ID].base_position;
-  float rotation = radians(u_eyeRotation);
-  vec3 posA = eyePos(pos, u_eyeScale, u_eyeTranslate, rotation);
+  vec3 posA = eyePos(pos, u_eyeScale, u_eyeTranslate, u_eyeTwist);
   pos.x *= -1.0;
-  vec3 posB = eyePos(pos, u_eyeScale, u_eyeTranslate, -rotation);
+  vec3 posB = eyePos(pos, u_eyeScale, u_eyeTranslate, transpose(u_eyeTwist));
 
   float tessMask = mask(eyeMask(posA, u_eyeFuzz, u_tessMaskCap), eyeMask(posB, u_eyeFuzz, u_tessMaskCap), u_eyeFuzz, vs_out[ID].base_normal.z);
   tc_out[ID].tess_mask = tessMask;
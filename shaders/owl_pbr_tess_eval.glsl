@@ -4,7 +4,7 @@
 
 layout(triangles, equal_spacing, cw) in;
 
-in struct
+layout (location = 0) in struct
 {
   vec3 position;
   vec3 base_position;
@@ -15,28 +15,39 @@ in struct
   float tess_mask;
 } tc_out[];
 
-out struct
+layout (location = 0) out struct
 {
   vec3 position;
   vec3 base_position;
   vec3 normal;
   vec3 base_normal;
   vec2 uv;
+  float eyeVal;
 } te_out;
 
-uniform mat4 MVP;
-uniform float u_phong_strength = 0.55;
+in gl_PerVertex
+{
+  vec4 gl_Position;
+} gl_in[gl_MaxPatchVertices];
 
-#define coord gl_TessCoord
+out gl_PerVertex
+{
+  vec4 gl_Position;
+};
 
-// The signature for our position function
-subroutine vec3 tessFuncType(vec3);
+#include "shaders/include/frame_constants.h"
+#include "shaders/include/material_params.h"
+#include "shaders/include/owl_eye_funcs.h"
+#include "shaders/include/owl_eye_height.h"
 
-// This uniform variable indicates which fractal function to use
-subroutine uniform tessFuncType u_tessFunction;
+#define coord gl_TessCoord
 
-subroutine(tessFuncType) vec3 phongTess(vec3 baryPos)
+// Flat and phong tessellation are compiled as separate permutations, rather than a subroutine
+vec3 tessPosition(vec3 baryPos)
 {
+#ifdef FLAT_TESS
+  return baryPos;
+#else
   vec3 coord2 = coord * coord;
   vec3 terms[3] = vec3[3](vec3(0.0),vec3(0.0),vec3(0.0));
   for (int i = 0; i < 3; ++i)
@@ -49,12 +60,8 @@ subroutine(tessFuncType) vec3 phongTess(vec3 baryPos)
     int j = (i + 1) % 3;
     phongPos += (coord2[i] * tc_out[i].position + coord[i] * coord[j] * terms[i]);
   }
-  return mix(baryPos, phongPos, u_phong_strength);
-}
-
-subroutine(tessFuncType) vec3 flatTess(vec3 baryPos)
-{
-  return baryPos;
+  return mix(baryPos, phongPos, u_phongStrength);
+#endif
 }
 
 void main(void)
@@ -69,7 +76,13 @@ void main(void)
   te_out.normal   = (coord.x * tc_out[0].normal   + coord.y * tc_out[1].normal   + coord.z * tc_out[2].normal);
   te_out.base_normal   = (coord.x * tc_out[0].base_normal   + coord.y * tc_out[1].base_normal   + coord.z * tc_out[2].base_normal);
   te_out.uv       = (coord.x * tc_out[0].uv       + coord.y * tc_out[1].uv       + coord.z * tc_out[2].uv);
-  te_out.position = u_tessFunction(baryPos);
+  te_out.position = tessPosition(baryPos);
   te_out.base_position = (gl_TessCoord.x * tc_out[0].base_position + gl_TessCoord.y * tc_out[1].base_position + gl_TessCoord.z * tc_out[2].base_position);
+
+  // The eyes are displaced once per tessellated vertex, the fragment stage derives the displaced normal
+  float height = eyeHeight(te_out.base_position, te_out.base_normal.z);
+  te_out.eyeVal = height;
+  te_out.position += normalize(te_out.normal) * height * u_eyeDisp;
+  te_out.base_position += te_out.base_normal * height * u_eyeDisp;
   gl_Position = MVP * vec4(te_out.position, 1.0);
 }
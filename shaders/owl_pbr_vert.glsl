@@ -14,15 +14,32 @@ layout (std430, binding = 0) readonly buffer morph_targets
   vec4 targets[];
 };
 
-out struct
+// Stage interfaces are matched by location, so stages can be skipped in a program pipeline
+layout (location = 0) out struct
 {
   vec3 position;
   vec3 base_position;
   vec3 normal;
   vec3 base_normal;
   vec2 uv;
+#ifndef HAS_TESSELLATION
+  // Matches the tessellation outputs, which the fragment stage otherwise reads
+  float eyeVal;
+#endif
 } vs_out;
 
+out gl_PerVertex
+{
+  vec4 gl_Position;
+};
+
+#ifndef HAS_TESSELLATION
+#include "shaders/include/frame_constants.h"
+#include "shaders/include/material_params.h"
+#include "shaders/include/owl_eye_funcs.h"
+#include "shaders/include/owl_eye_height.h"
+#endif
+
 uniform int u_morph_target_size = 0;
 uniform int u_morph_target_normal_offset = 0;
 uniform float u_blend = 0.0;
@@ -53,4 +70,12 @@ void main()
   vs_out.normal = targetNormal;
   vs_out.base_normal = in_normal;
   vs_out.uv = in_uv;
+#ifndef HAS_TESSELLATION
+  // Without tessellation the eyes are displaced at the mesh's own vertices, and we project them
+  float height = eyeHeight(in_vert, in_normal.z);
+  vs_out.eyeVal = height;
+  vs_out.position += targetNormal * height * u_eyeDisp;
+  vs_out.base_position += in_normal * height * u_eyeDisp;
+  gl_Position = MVP * vec4(vs_out.position, 1.0);
+#endif
 }
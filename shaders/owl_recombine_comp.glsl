@@ -0,0 +1,38 @@
+#version 430 core
+
+#include "shaders/include/brick_volume.h"
+
+// Each work group rewrites one padded brick of the albedo pool from the layer masks, so the colours can
+// be changed without evaluating the noise. The coarser levels are then averaged by owl_mip_comp.glsl
+// Layout qualifiers must be literals before GLSL 4.40, these match k_paddedBrickDim
+layout(local_size_x = 10, local_size_y = 10, local_size_z = 10) in;
+layout(rgba16f, binding = 0) uniform writeonly image3D u_albedoMap;
+// The coordinate of every brick in the pool, packed as x | y << 8 | z << 16 | level << 24
+layout(std430, binding = 1) readonly buffer BrickList
+{
+  uint u_bricks[];
+};
+
+uniform uint u_layerOffset = 0u;
+// The masks written by owl_noise_comp.glsl, which share the albedo pool's layout
+uniform sampler3D u_layersLow;
+uniform sampler3D u_layersHigh;
+// The displacement is read from w and kept as it was, the masks are too coarse to sum it from
+uniform sampler3D u_heightMap;
+
+#include "shaders/include/owl_layers.h"
+// ----------------------------------------------------------------------------
+void main()
+{
+  uvec3 poolBrick = gl_WorkGroupID + uvec3(0u, 0u, u_layerOffset);
+  uvec3 poolBricks = uvec3(imageSize(u_albedoMap)) / uint(k_paddedBrickDim);
+  uint brickIndex = poolBrick.x + poolBricks.x * (poolBrick.y + poolBricks.y * poolBrick.z);
+  // Only the finest level has masks, the others are averaged from it
+  if (brickIndex >= uint(u_bricks.length())) return;
+  if (unpackBrick(u_bricks[brickIndex]).w != 0) return;
+
+  ivec3 poolTexel = ivec3(poolBrick) * k_paddedBrickDim + ivec3(gl_LocalInvocationID);
+  float layers[k_numLayers] = unpackLayers(texelFetch(u_layersLow, poolTexel, 0), texelFetch(u_layersHigh, poolTexel, 0));
+  vec4 albedo = vec4(combineLayers(layers).xyz, texelFetch(u_heightMap, poolTexel, 0).w);
+  imageStore(u_albedoMap, poolTexel, albedo);
+}
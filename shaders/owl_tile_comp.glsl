@@ -0,0 +1,23 @@
+#version 430 core
+
+// Each invocation writes one texel of a dense tile of the albedo, baked with periodic noise so that it
+// repeats seamlessly across the volume with the repeat wrap mode
+layout(local_size_x = 8, local_size_y = 8, local_size_z = 8) in;
+layout(rgba16f, binding = 0) uniform writeonly image3D u_albedoMap;
+
+// The number of times the tile repeats across the volume, along each axis
+uniform int u_tileRepeats = 4;
+
+#include "shaders/include/owl_albedo.h"
+// ----------------------------------------------------------------------------
+void main()
+{
+  ivec3 dim = imageSize(u_albedoMap);
+  ivec3 texel = ivec3(gl_GlobalInvocationID);
+  if (any(greaterThanEqual(texel, dim))) return;
+
+  // The tile covers the start of the volume, and the noise repeats over the same span
+  vec3 uvw = (vec3(texel) + 0.5) / vec3(dim * u_tileRepeats);
+  vec3 period = vec3(k_scale / float(u_tileRepeats));
+  imageStore(u_albedoMap, texel, combineLayers(calcLayers(uvw, period)));
+}
@@ -0,0 +1,578 @@
+#include "BlockCompression.h"
+#include "ThreadPool.h"
+#include "HalfFloat.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace
+{
+// Plain RGB16F, which is what decode produces
+constexpr uint32_t k_glRGB16F = 0x881B;
+constexpr uint32_t k_glRGB = 0x1907;
+constexpr uint32_t k_glHalfFloat = 0x140B;
+// The range is stored as a two texel RGB32F 1D texture, the scale followed by the bias
+constexpr uint32_t k_glTexture1D = 0x0DE0;
+constexpr uint32_t k_glRGB32F = 0x8815;
+constexpr uint32_t k_glFloat = 0x1406;
+
+// The largest finite half, values beyond it can't be represented by BC6H
+constexpr int k_maxHalf = 0x7BFF;
+// Every one region mode interpolates with these 6 bit weights
+constexpr int k_weights[16] = {0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64};
+
+//-----------------------------------------------------------------------------------------------------
+/// @brief The one region modes. Mode 11 stores both endpoints in full, the others store the second as
+/// a delta from the first, which trades range within the block for precision.
+//-----------------------------------------------------------------------------------------------------
+struct Mode
+{
+  unsigned m_id;
+  int m_endpointBits;
+  int m_deltaBits;
+};
+constexpr Mode k_modes[] = {{0x03, 10, 0}, {0x07, 11, 9}, {0x0B, 12, 8}, {0x0F, 16, 4}};
+
+//-----------------------------------------------------------------------------------------------------
+/// @brief Maps a half to the integer domain that BC6H interpolates in, where the bits of a positive half
+/// are already ordered by value. Negative values and infinities are clamped.
+//-----------------------------------------------------------------------------------------------------
+int halfToInt(const uint16_t _half) noexcept
+{
+  return _half & 0x8000 ? 0 : std::min<int>(_half, k_maxHalf);
+}
+//-----------------------------------------------------------------------------------------------------
+/// @brief Sign extends the low bits of a value.
+//-----------------------------------------------------------------------------------------------------
+int signExtend(const unsigned _value, const int _bits) noexcept
+{
+  const int value = static_cast<int>(_value & ((1u << _bits) - 1));
+  return value >= (1 << (_bits - 1)) ? value - (1 << _bits) : value;
+}
+//-----------------------------------------------------------------------------------------------------
+/// @brief Expands a quantized endpoint to 16 bits, as the GPU does before interpolating.
+//-----------------------------------------------------------------------------------------------------
+int unquantize(const int _q, const int _bits) noexcept
+{
+  if (_bits >= 15 || _q == 0) return _q;
+  if (_q == (1 << _bits) - 1) return 0xFFFF;
+  return ((_q << 16) + 0x8000) >> _bits;
+}
+//-----------------------------------------------------------------------------------------------------
+/// @brief The value a texel decodes to, given the quantized endpoints and it's weight. The result is
+/// scaled back in to the range of a half, which is the last step of decoding.
+//-----------------------------------------------------------------------------------------------------
+int interpolate(const int _q0, const int _q1, const int _bits, const int _weight) noexcept
+{
+  const int e0 = unquantize(_q0, _bits);
+  const int e1 = unquantize(_q1, _bits);
+  return (((e0 * (64 - _weight) + e1 * _weight + 32) >> 6) * 31) >> 6;
+}
+//-----------------------------------------------------------------------------------------------------
+/// @brief Finds the quantized endpoint that decodes closest to a value, in the halfToInt domain.
+//-----------------------------------------------------------------------------------------------------
+int quantize(const float _value, const int _bits) noexcept
+{
+  const int highest = (1 << _bits) - 1;
+  // Undo the finishing scale, then the expansion, which is close to a shift
+  const float expanded = _value * 64.0f / 31.0f;
+  const int guess = static_cast<int>(std::lround(expanded / static_cast<float>(1 << (16 - _bits))));
+
+  int best = std::min(std::max(guess, 0), highest);
+  float bestError = std::abs(static_cast<float>(interpolate(best, best, _bits, 0)) - _value);
+  for (int q = std::max(guess - 1, 0); q <= std::min(guess + 1, highest); ++q)
+  {
+    const float error = std::abs(static_cast<float>(interpolate(q, q, _bits, 0)) - _value);
+    if (error < bestError)
+    {
+      best = q;
+      bestError = error;
+    }
+  }
+  return best;
+}
+
+//-----------------------------------------------------------------------------------------------------
+/// @brief The mode, endpoints and indices of a block, along with their error.
+//-----------------------------------------------------------------------------------------------------
+struct Candidate
+{
+  const Mode* m_mode;
+  int m_endpoints[2][3];
+  int m_indices[16];
+  float m_error;
+};
+//-----------------------------------------------------------------------------------------------------
+/// @brief Quantizes a pair of endpoints for a mode and picks the closest palette entry for each texel.
+//-----------------------------------------------------------------------------------------------------
+Candidate evaluate(const float _texels[16][3], const float _e0[3], const float _e1[3], const Mode &_mode) noexcept
+{
+  Candidate candidate;
+  candidate.m_mode = &_mode;
+  const int bits = _mode.m_endpointBits;
+  // The delta is kept within a symmetric range, so that the endpoints can still be swapped
+  const int maxDelta = _mode.m_deltaBits ? (1 << (_mode.m_deltaBits - 1)) - 1 : 0;
+  int palette[16][3];
+  for (int c = 0; c < 3; ++c)
+  {
+    const int q0 = quantize(_e0[c], bits);
+    int q1 = quantize(_e1[c], bits);
+    if (_mode.m_deltaBits) q1 = q0 + std::min(std::max(q1 - q0, -maxDelta), maxDelta);
+    candidate.m_endpoints[0][c] = q0;
+    candidate.m_endpoints[1][c] = q1;
+    for (int i = 0; i < 16; ++i)
+      palette[i][c] = interpolate(q0, q1, bits, k_weights[i]);
+  }
+
+  candidate.m_error = 0.0f;
+  for (int t = 0; t < 16; ++t)
+  {
+    float bestError = std::numeric_limits<float>::max();
+    for (int i = 0; i < 16; ++i)
+    {
+      float error = 0.0f;
+      for (int c = 0; c < 3; ++c)
+      {
+        const float diff = static_cast<float>(palette[i][c]) - _texels[t][c];
+        error += diff * diff;
+      }
+      if (error < bestError)
+      {
+        bestError = error;
+        candidate.m_indices[t] = i;
+      }
+    }
+    candidate.m_error += bestError;
+  }
+  return candidate;
+}
+//-----------------------------------------------------------------------------------------------------
+/// @brief Solves for the endpoints that best fit the texels given their weights, by least squares.
+/// @return false if every texel has the same weight, which leaves the endpoints undetermined.
+//-----------------------------------------------------------------------------------------------------
+bool refitEndpoints(const float _texels[16][3], const int _indices[16], float o_e0[3], float o_e1[3]) noexcept
+{
+  float aa = 0.0f, ab = 0.0f, bb = 0.0f;
+  float ra[3] = {}, rb[3] = {};
+  for (int t = 0; t < 16; ++t)
+  {
+    const float b = static_cast<float>(k_weights[_indices[t]]) / 64.0f;
+    const float a = 1.0f - b;
+    aa += a * a;
+    ab += a * b;
+    bb += b * b;
+    for (int c = 0; c < 3; ++c)
+    {
+      ra[c] += a * _texels[t][c];
+      rb[c] += b * _texels[t][c];
+    }
+  }
+  const float det = aa * bb - ab * ab;
+  if (std::abs(det) < 1e-6f) return false;
+  for (int c = 0; c < 3; ++c)
+  {
+    o_e0[c] = (bb * ra[c] - ab * rb[c]) / det;
+    o_e1[c] = (aa * rb[c] - ab * ra[c]) / det;
+  }
+  return true;
+}
+
+//-----------------------------------------------------------------------------------------------------
+/// @brief Packs fields in to a block, starting from the least significant bit.
+//-----------------------------------------------------------------------------------------------------
+class BitWriter
+{
+public:
+  explicit BitWriter(unsigned char* io_block) : m_block(io_block)
+  {
+    std::fill(m_block, m_block + BlockCompression::k_blockBytes, 0);
+  }
+  void write(const unsigned _value, const int _bits) noexcept
+  {
+    for (int i = 0; i < _bits; ++i, ++m_bit)
+      m_block[m_bit >> 3] |= static_cast<unsigned char>(((_value >> i) & 1u) << (m_bit & 7));
+  }
+
+private:
+  unsigned char* m_block;
+  int m_bit = 0;
+};
+//-----------------------------------------------------------------------------------------------------
+/// @brief Reads fields back out of a block, in the order BitWriter wrote them.
+//-----------------------------------------------------------------------------------------------------
+class BitReader
+{
+public:
+  explicit BitReader(const unsigned char* _block) : m_block(_block) {}
+  unsigned read(const int _bits) noexcept
+  {
+    unsigned value = 0;
+    for (int i = 0; i < _bits; ++i, ++m_bit)
+      value |= ((m_block[m_bit >> 3] >> (m_bit & 7)) & 1u) << i;
+    return value;
+  }
+
+private:
+  const unsigned char* m_block;
+  int m_bit = 0;
+};
+
+//-----------------------------------------------------------------------------------------------------
+/// @brief Calls a function for every block of every level, face and slice of a texture.
+/// @param [in] _header describes the uncompressed texture.
+/// @param [in] _func is given the level, face, slice and block coordinates, along with the index of the
+/// block within the slices of that face.
+//-----------------------------------------------------------------------------------------------------
+template <typename Func>
+void forEachBlock(const TextureFile::Header &_header, ThreadPool &io_pool, Func &&_func)
+{
+  using BlockCompression::k_blockDim;
+  for (uint32_t level = 0; level < _header.m_levels; ++level)
+  {
+    const uint32_t width = TextureFile::levelDim(_header.m_width, level);
+    const uint32_t height = TextureFile::levelDim(_header.m_height, level);
+    const uint32_t depth = TextureFile::levelDim(_header.m_depth, level);
+    const uint32_t blocksX = (width + k_blockDim - 1) / k_blockDim;
+    const uint32_t blocksY = (height + k_blockDim - 1) / k_blockDim;
+    for (uint32_t face = 0; face < _header.m_faces; ++face)
+    {
+      io_pool.parallelFor(static_cast<size_t>(depth) * blocksY, [&](size_t _begin, size_t _end)
+      {
+        for (size_t row = _begin; row < _end; ++row)
+        {
+          const auto z = static_cast<uint32_t>(row / blocksY);
+          const auto by = static_cast<uint32_t>(row % blocksY);
+          for (uint32_t bx = 0; bx < blocksX; ++bx)
+            _func(level, face, z, bx, by, row * blocksX + bx);
+        }
+      });
+    }
+  }
+}
+//-----------------------------------------------------------------------------------------------------
+/// @brief Compresses a texture, passing the RGB halfs of each texel through a function first.
+//-----------------------------------------------------------------------------------------------------
+template <typename Func>
+TextureFile encodeTexture(const TextureFile &_texture, ThreadPool &io_pool, Func &&_transform)
+{
+  using namespace BlockCompression;
+  const auto& source = _texture.header();
+  const uint32_t channels = source.m_bytesPerPixel / sizeof(uint16_t);
+  auto header = source;
+  header.m_internalFormat = k_glBC6H;
+  header.m_pixelFormat = 0;
+  header.m_pixelType = 0;
+  header.m_bytesPerPixel = k_blockBytes;
+  TextureFile compressed(header);
+
+  forEachBlock(source, io_pool, [&](uint32_t _level, uint32_t _face, uint32_t _z, uint32_t _bx, uint32_t _by, size_t _block)
+  {
+    const uint32_t width = TextureFile::levelDim(source.m_width, _level);
+    const uint32_t height = TextureFile::levelDim(source.m_height, _level);
+    const auto texels = reinterpret_cast<const uint16_t*>(_texture.data(_level, _face)) +
+        static_cast<size_t>(_z) * width * height * channels;
+
+    // Blocks that hang over the edge repeat the last row or column
+    uint16_t block[16][3];
+    for (uint32_t y = 0; y < k_blockDim; ++y)
+    {
+      const uint32_t row = std::min(_by * k_blockDim + y, height - 1);
+      for (uint32_t x = 0; x < k_blockDim; ++x)
+      {
+        const uint32_t column = std::min(_bx * k_blockDim + x, width - 1);
+        auto texel = block[y * k_blockDim + x];
+        std::copy_n(texels + (static_cast<size_t>(row) * width + column) * channels, 3, texel);
+        _transform(texel);
+      }
+    }
+    encodeBlock(block, compressed.data(_level, _face) + _block * k_blockBytes);
+  });
+  return compressed;
+}
+}
+
+//-----------------------------------------------------------------------------------------------------
+void BlockCompression::encodeBlock(const uint16_t _texels[16][3], unsigned char o_block[16]) noexcept
+{
+  // We fit in the integer domain that the GPU interpolates in. It's close to logarithmic, which spreads
+  // the error relative to brightness for HDR colour, and linear for data that was normalized
+  float texels[16][3];
+  float mean[3] = {};
+  for (int t = 0; t < 16; ++t)
+  {
+    for (int c = 0; c < 3; ++c)
+    {
+      texels[t][c] = static_cast<float>(halfToInt(_texels[t][c]));
+      mean[c] += texels[t][c] / 16.0f;
+    }
+  }
+
+  // The principal axis of the texels, by power iteration on their covariance
+  float covariance[3][3] = {};
+  for (int t = 0; t < 16; ++t)
+    for (int i = 0; i < 3; ++i)
+      for (int j = 0; j < 3; ++j)
+        covariance[i][j] += (texels[t][i] - mean[i]) * (texels[t][j] - mean[j]);
+  float axis[3] = {1.0f, 1.0f, 1.0f};
+  for (int iteration = 0; iteration < 8; ++iteration)
+  {
+    float next[3] = {};
+    for (int i = 0; i < 3; ++i)
+      for (int j = 0; j < 3; ++j)
+        next[i] += covariance[i][j] * axis[j];
+    const float length = std::sqrt(next[0] * next[0] + next[1] * next[1] + next[2] * next[2]);
+    // A flat block has no axis, any direction will do
+    if (length < 1e-6f) break;
+    for (int i = 0; i < 3; ++i) axis[i] = next[i] / length;
+  }
+
+  // The endpoints span the texels' projections on to the axis
+  float lowest = std::numeric_limits<float>::max();
+  float highest = std::numeric_limits<float>::lowest();
+  for (int t = 0; t < 16; ++t)
+  {
+    float projection = 0.0f;
+    for (int c = 0; c < 3; ++c) projection += (texels[t][c] - mean[c]) * axis[c];
+    lowest = std::min(lowest, projection);
+    highest = std::max(highest, projection);
+  }
+  float e0[3], e1[3];
+  for (int c = 0; c < 3; ++c)
+  {
+    e0[c] = mean[c] + axis[c] * lowest;
+    e1[c] = mean[c] + axis[c] * highest;
+  }
+
+  // Each mode is refit to the indices it chose, which pulls the endpoints in from outliers. The modes
+  // with deltas win on smooth blocks, where mode 11 can't place it's endpoints finely enough
+  Candidate best;
+  best.m_error = std::numeric_limits<float>::max();
+  for (const auto& mode : k_modes)
+  {
+    float m0[3], m1[3];
+    std::copy_n(e0, 3, m0);
+    std::copy_n(e1, 3, m1);
+    Candidate fitted = evaluate(texels, m0, m1, mode);
+    for (int iteration = 0; iteration < 2 && fitted.m_error > 0.0f; ++iteration)
+    {
+      if (!refitEndpoints(texels, fitted.m_indices, m0, m1)) break;
+      const Candidate refit = evaluate(texels, m0, m1, mode);
+      if (refit.m_error >= fitted.m_error) break;
+      fitted = refit;
+    }
+    if (fitted.m_error < best.m_error) best = fitted;
+  }
+
+  // The first index is stored without it's top bit, so it must be in the lower half of the palette
+  if (best.m_indices[0] & 8)
+  {
+    for (int c = 0; c < 3; ++c) std::swap(best.m_endpoints[0][c], best.m_endpoints[1][c]);
+    for (auto& index : best.m_indices) index = 15 - index;
+  }
+
+  // The low 10 bits of the first endpoint come first, then each channel's second endpoint or delta,
+  // followed by the rest of it's first endpoint with the bits reversed
+  const Mode& mode = *best.m_mode;
+  BitWriter writer(o_block);
+  writer.write(mode.m_id, 5);
+  for (int c = 0; c < 3; ++c)
+    writer.write(static_cast<unsigned>(best.m_endpoints[0][c]), 10);
+  for (int c = 0; c < 3; ++c)
+  {
+    const int second = mode.m_deltaBits ? best.m_endpoints[1][c] - best.m_endpoints[0][c] : best.m_endpoints[1][c];
+    writer.write(static_cast<unsigned>(second), mode.m_deltaBits ? mode.m_deltaBits : 10);
+    for (int bit = mode.m_endpointBits - 1; bit >= 10; --bit)
+      writer.write(static_cast<unsigned>(best.m_endpoints[0][c]) >> bit, 1);
+  }
+  writer.write(static_cast<unsigned>(best.m_indices[0]), 3);
+  for (int t = 1; t < 16; ++t)
+    writer.write(static_cast<unsigned>(best.m_indices[t]), 4);
+}
+//-----------------------------------------------------------------------------------------------------
+bool BlockCompression::decodeBlock(const unsigned char _block[16], uint16_t o_texels[16][3]) noexcept
+{
+  BitReader reader(_block);
+  const unsigned id = reader.read(5);
+  const auto mode = std::find_if(std::begin(k_modes), std::end(k_modes), [id](const Mode &_mode) { return _mode.m_id == id; });
+  if (mode == std::end(k_modes))
+  {
+    for (int t = 0; t < 16; ++t) std::fill(o_texels[t], o_texels[t] + 3, 0);
+    return false;
+  }
+
+  const int bits = mode->m_endpointBits;
+  const unsigned mask = (1u << bits) - 1;
+  unsigned endpoints[2][3];
+  for (int c = 0; c < 3; ++c)
+    endpoints[0][c] = reader.read(10);
+  for (int c = 0; c < 3; ++c)
+  {
+    endpoints[1][c] = reader.read(mode->m_deltaBits ? mode->m_deltaBits : 10);
+    for (int bit = bits - 1; bit >= 10; --bit)
+      endpoints[0][c] |= reader.read(1) << bit;
+    // Deltas are signed, and wrap within the endpoint's bits
+    if (mode->m_deltaBits)
+      endpoints[1][c] = (endpoints[0][c] + static_cast<unsigned>(signExtend(endpoints[1][c], mode->m_deltaBits))) & mask;
+  }
+  for (int t = 0; t < 16; ++t)
+  {
+    const auto index = static_cast<int>(reader.read(t ? 4 : 3));
+    for (int c = 0; c < 3; ++c)
+    {
+      const auto q0 = static_cast<int>(endpoints[0][c]);
+      const auto q1 = static_cast<int>(endpoints[1][c]);
+      o_texels[t][c] = static_cast<uint16_t>(interpolate(q0, q1, bits, k_weights[index]));
+    }
+  }
+  return true;
+}
+//-----------------------------------------------------------------------------------------------------
+TextureFile BlockCompression::encode(const TextureFile &_texture, ThreadPool &io_pool)
+{
+  return encodeTexture(_texture, io_pool, [](uint16_t*) {});
+}
+//-----------------------------------------------------------------------------------------------------
+TextureFile BlockCompression::encode(const TextureFile &_texture, Range &o_range, ThreadPool &io_pool)
+{
+  const auto& header = _texture.header();
+  const uint32_t channels = header.m_bytesPerPixel / sizeof(uint16_t);
+  float lowest[3], highest[3];
+  std::fill_n(lowest, 3, std::numeric_limits<float>::max());
+  std::fill_n(highest, 3, std::numeric_limits<float>::lowest());
+  for (uint32_t level = 0; level < header.m_levels; ++level)
+  {
+    for (uint32_t face = 0; face < header.m_faces; ++face)
+    {
+      const size_t count = _texture.faceSize(level) / header.m_bytesPerPixel;
+      const auto texels = reinterpret_cast<const uint16_t*>(_texture.data(level, face));
+      for (size_t i = 0; i < count; ++i)
+      {
+        for (uint32_t c = 0; c < 3; ++c)
+        {
+          const float value = HalfFloat::toFloat(texels[i * channels + c]);
+          lowest[c] = std::min(lowest[c], value);
+          highest[c] = std::max(highest[c], value);
+        }
+      }
+    }
+  }
+
+  // Values in [1, 2) share an exponent, so their halfs are evenly spaced, and BC6H interpolates them
+  // linearly. The top of the range stays a step below 2 so that it keeps the same exponent
+  constexpr float span = 1.0f - 1.0f / 1024.0f;
+  float normalize[3];
+  for (uint32_t c = 0; c < 3; ++c)
+  {
+    const float extent = std::max(highest[c] - lowest[c], 0.0f);
+    normalize[c] = extent > 0.0f ? span / extent : 0.0f;
+    o_range.m_scale[c] = extent / span;
+    o_range.m_bias[c] = lowest[c] - o_range.m_scale[c];
+  }
+  return encodeTexture(_texture, io_pool, [&](uint16_t* io_texel)
+  {
+    for (uint32_t c = 0; c < 3; ++c)
+      io_texel[c] = HalfFloat::fromFloat(1.0f + (HalfFloat::toFloat(io_texel[c]) - lowest[c]) * normalize[c]);
+  });
+}
+//-----------------------------------------------------------------------------------------------------
+TextureFile BlockCompression::decode(const TextureFile &_texture, ThreadPool &io_pool)
+{
+  auto header = _texture.header();
+  header.m_internalFormat = k_glRGB16F;
+  header.m_pixelFormat = k_glRGB;
+  header.m_pixelType = k_glHalfFloat;
+  header.m_bytesPerPixel = 3 * sizeof(uint16_t);
+  TextureFile decoded(header);
+
+  forEachBlock(header, io_pool, [&](uint32_t _level, uint32_t _face, uint32_t _z, uint32_t _bx, uint32_t _by, size_t _block)
+  {
+    const uint32_t width = TextureFile::levelDim(header.m_width, _level);
+    const uint32_t height = TextureFile::levelDim(header.m_height, _level);
+    auto texels = reinterpret_cast<uint16_t*>(decoded.data(_level, _face)) + static_cast<size_t>(_z) * width * height * 3;
+
+    uint16_t block[16][3];
+    decodeBlock(_texture.data(_level, _face) + _block * k_blockBytes, block);
+    for (uint32_t y = 0; y < k_blockDim && _by * k_blockDim + y < height; ++y)
+    {
+      const uint32_t row = _by * k_blockDim + y;
+      for (uint32_t x = 0; x < k_blockDim && _bx * k_blockDim + x < width; ++x)
+        std::copy_n(block[y * k_blockDim + x], 3, texels + (static_cast<size_t>(row) * width + _bx * k_blockDim + x) * 3);
+    }
+  });
+  return decoded;
+}
+//-----------------------------------------------------------------------------------------------------
+ImageMetrics::Error BlockCompression::measure(
+    const TextureFile &_compressed,
+    const TextureFile &_source,
+    const Range &_range,
+    ThreadPool &io_pool
+    )
+{
+  const auto decoded = decode(_compressed, io_pool);
+  const uint32_t channels = _source.header().m_bytesPerPixel / sizeof(uint16_t);
+
+  // The volumes are too large to widen in one go, so we accumulate the sums that ImageMetrics::compare
+  // would, a texel at a time
+  double squaredError = 0.0;
+  double squaredReference = 0.0;
+  double peak = 0.0;
+  size_t count = 0;
+  for (uint32_t level = 0; level < decoded.header().m_levels; ++level)
+  {
+    for (uint32_t face = 0; face < decoded.header().m_faces; ++face)
+    {
+      const size_t texels = decoded.faceSize(level) / (3 * sizeof(uint16_t));
+      const auto test = reinterpret_cast<const uint16_t*>(decoded.data(level, face));
+      const auto reference = reinterpret_cast<const uint16_t*>(_source.data(level, face));
+      for (size_t i = 0; i < texels; ++i)
+      {
+        for (uint32_t c = 0; c < 3; ++c)
+        {
+          const double expected = HalfFloat::toFloat(reference[i * channels + c]);
+          const double actual = HalfFloat::toFloat(test[i * 3 + c]) * _range.m_scale[c] + _range.m_bias[c];
+          const double diff = actual - expected;
+          squaredError += diff * diff;
+          squaredReference += expected * expected;
+          peak = std::max(peak, std::abs(expected));
+        }
+      }
+      count += texels * 3;
+    }
+  }
+
+  ImageMetrics::Error error;
+  if (!count) return error;
+  const double mse = squaredError / count;
+  error.m_rmse = std::sqrt(mse);
+  error.m_relativeRmse = squaredReference > 0.0 ? std::sqrt(squaredError / squaredReference) : 0.0;
+  error.m_psnr = mse > 0.0 ? 10.0 * std::log10(peak * peak / mse) : std::numeric_limits<double>::infinity();
+  return error;
+}
+//-----------------------------------------------------------------------------------------------------
+TextureFile BlockCompression::Range::toFile() const
+{
+  TextureFile::Header header;
+  header.m_target = k_glTexture1D;
+  header.m_internalFormat = k_glRGB32F;
+  header.m_pixelFormat = k_glRGB;
+  header.m_pixelType = k_glFloat;
+  header.m_width = 2;
+  header.m_levels = 1;
+  header.m_bytesPerPixel = 3 * sizeof(float);
+  TextureFile file(header);
+  auto values = reinterpret_cast<float*>(file.data(0));
+  std::copy_n(m_scale, 3, values);
+  std::copy_n(m_bias, 3, values + 3);
+  return file;
+}
+//-----------------------------------------------------------------------------------------------------
+bool BlockCompression::Range::fromFile(const TextureFile &_file)
+{
+  const auto& header = _file.header();
+  if (header.m_internalFormat != k_glRGB32F || header.m_width != 2 || header.m_levels != 1) return false;
+  const auto values = reinterpret_cast<const float*>(_file.data(0));
+  std::copy_n(values, 3, m_scale);
+  std::copy_n(values + 3, 3, m_bias);
+  return true;
+}
@@ -0,0 +1,113 @@
+#include "BrdfLut.h"
+#include "ThreadPool.h"
+#include "HalfFloat.h"
+#include <vector>
+#include <cmath>
+#include <algorithm>
+
+namespace
+{
+// TextureFile is independent of GL, so we store the enums it needs by value
+constexpr uint32_t k_glTexture2D = 0x0DE1;
+constexpr uint32_t k_glRG16F = 0x822F;
+constexpr uint32_t k_glRG = 0x8227;
+constexpr uint32_t k_glHalfFloat = 0x140B;
+
+constexpr float k_pi = 3.14159265359f;
+
+//-----------------------------------------------------------------------------------------------------
+/// @brief Van der Corpus sequence, matches radicalInverse_VdC in pbr_funcs.h.
+//-----------------------------------------------------------------------------------------------------
+float radicalInverse(uint32_t _bits) noexcept
+{
+  _bits = (_bits << 16u) | (_bits >> 16u);
+  _bits = ((_bits & 0x55555555u) << 1u) | ((_bits & 0xAAAAAAAAu) >> 1u);
+  _bits = ((_bits & 0x33333333u) << 2u) | ((_bits & 0xCCCCCCCCu) >> 2u);
+  _bits = ((_bits & 0x0F0F0F0Fu) << 4u) | ((_bits & 0xF0F0F0F0u) >> 4u);
+  _bits = ((_bits & 0x00FF00FFu) << 8u) | ((_bits & 0xFF00FF00u) >> 8u);
+  return static_cast<float>(_bits) * 2.3283064365386963e-10f;
+}
+
+//-----------------------------------------------------------------------------------------------------
+/// @brief Smith's G1 with the IBL remapping of k, matches brdfSchlickGGX.
+//-----------------------------------------------------------------------------------------------------
+inline float schlickGGX(const float _nDotV, const float _k) noexcept
+{
+  return _nDotV / (_nDotV * (1.0f - _k) + _k);
+}
+}
+
+//-----------------------------------------------------------------------------------------------------
+TextureFile BrdfLut::generate(const int _dim, const unsigned _samples, ThreadPool &io_pool)
+{
+  TextureFile::Header header;
+  header.m_target = k_glTexture2D;
+  header.m_internalFormat = k_glRG16F;
+  header.m_pixelFormat = k_glRG;
+  header.m_pixelType = k_glHalfFloat;
+  header.m_width = header.m_height = static_cast<uint32_t>(_dim);
+  header.m_levels = 1;
+  header.m_bytesPerPixel = 2 * sizeof(uint16_t);
+  TextureFile lut(header);
+  auto texels = reinterpret_cast<uint16_t*>(lut.data(0));
+
+  // The Hammersley points are the same for every texel
+  std::vector<float> sinPhi(_samples), xi(_samples);
+  for (unsigned i = 0; i < _samples; ++i)
+  {
+    sinPhi[i] = std::sin(2.0f * k_pi * static_cast<float>(i) / _samples);
+    xi[i] = radicalInverse(i);
+  }
+
+  io_pool.parallelFor(static_cast<size_t>(_dim), [&](size_t _begin, size_t _end)
+  {
+    // As N is +Z and V lies in the XZ plane, only the x and z of each half vector are needed. The
+    // shader's tangent frame for +Z maps the sample's y on to x, so we use sin(phi) here
+    std::vector<float> hx(_samples), hz(_samples);
+    for (size_t row = _begin; row < _end; ++row)
+    {
+      const float roughness = (static_cast<float>(row) + 0.5f) / _dim;
+      const float a = roughness * roughness;
+      const float k = a * 0.5f;
+      // GGX half vectors depend only on roughness, so we build them once per row
+      for (unsigned i = 0; i < _samples; ++i)
+      {
+        const float cosTheta = std::sqrt((1.0f - xi[i]) / (1.0f + (a * a - 1.0f) * xi[i]));
+        const float sinTheta = std::sqrt(1.0f - cosTheta * cosTheta);
+        hx[i] = sinPhi[i] * sinTheta;
+        hz[i] = cosTheta;
+      }
+
+      for (int column = 0; column < _dim; ++column)
+      {
+        const float nDotV = (static_cast<float>(column) + 0.5f) / _dim;
+        const float vx = std::sqrt(1.0f - nDotV * nDotV);
+        const float vz = nDotV;
+        const float gV = schlickGGX(nDotV, k);
+
+        // Branch free over plain arrays, so the compiler can vectorise the whole loop
+        float scale = 0.0f;
+        float bias = 0.0f;
+        for (unsigned i = 0; i < _samples; ++i)
+        {
+          const float vDotH = std::max(vx * hx[i] + vz * hz[i], 0.0f);
+          const float nDotL = 2.0f * vDotH * hz[i] - vz;
+          const float nDotH = hz[i];
+          const float clampedNDotL = std::max(nDotL, 0.0f);
+          const float gVis = schlickGGX(clampedNDotL, k) * gV * vDotH / (nDotH * nDotV);
+          const float oneMinus = 1.0f - vDotH;
+          const float oneMinus2 = oneMinus * oneMinus;
+          const float fc = oneMinus2 * oneMinus2 * oneMinus;
+          const float weight = nDotL > 0.0f ? gVis : 0.0f;
+          scale += (1.0f - fc) * weight;
+          bias += fc * weight;
+        }
+
+        auto texel = texels + (row * static_cast<size_t>(_dim) + static_cast<size_t>(column)) * 2;
+        texel[0] = HalfFloat::fromFloat(scale / _samples);
+        texel[1] = HalfFloat::fromFloat(bias / _samples);
+      }
+    }
+  });
+  return lut;
+}
@@ -0,0 +1,239 @@
+#include "BrickVolume.h"
+#include <glm.hpp>
+#include <array>
+#include <cmath>
+#include <limits>
+#include <algorithm>
+#include <utility>
+
+namespace
+{
+//-----------------------------------------------------------------------------------------------------
+/// @brief Stops degenerate triangles from splitting forever.
+//-----------------------------------------------------------------------------------------------------
+constexpr int k_maxSplitDepth = 16;
+
+struct SweptVertex
+{
+  glm::vec3 m_pos;
+  glm::vec3 m_normal;
+};
+
+//-----------------------------------------------------------------------------------------------------
+/// @brief Everything that stays the same while we mark the triangles of a mesh.
+//-----------------------------------------------------------------------------------------------------
+struct BandMarker
+{
+  float m_minDisp;
+  float m_maxDisp;
+  float m_texelScale;
+  glm::vec3 m_texelOffset;
+  glm::ivec3 m_bricks;
+  std::vector<uint8_t> m_marked;
+
+  void mark(const SweptVertex &_a, const SweptVertex &_b, const SweptVertex &_c, const int _depth)
+  {
+    // Split until the triangle is about a brick across at either end of the sweep
+    float extent = 0.0f;
+    for (const auto disp : {m_minDisp, m_maxDisp})
+    {
+      const auto bounds = sweptBounds(_a, _b, _c, disp, disp);
+      const auto size = bounds.second - bounds.first;
+      extent = std::max({extent, size.x, size.y, size.z});
+    }
+    if (_depth < k_maxSplitDepth && extent > BrickVolume::k_brickDim)
+    {
+      // Split the longest edge, the normals are interpolated linearly, as they are by the shaders
+      const std::array<const SweptVertex*, 3> verts = {{&_a, &_b, &_c}};
+      size_t longest = 0;
+      float longestLength = 0.0f;
+      for (size_t i = 0; i < 3; ++i)
+      {
+        const auto edge = verts[(i + 1) % 3]->m_pos - verts[i]->m_pos;
+        const auto length = glm::dot(edge, edge);
+        if (length > longestLength)
+        {
+          longest = i;
+          longestLength = length;
+        }
+      }
+      const auto& a = *verts[longest];
+      const auto& b = *verts[(longest + 1) % 3];
+      const auto& c = *verts[(longest + 2) % 3];
+      const SweptVertex mid {(a.m_pos + b.m_pos) * 0.5f, (a.m_normal + b.m_normal) * 0.5f};
+      mark(a, mid, c, _depth + 1);
+      mark(mid, b, c, _depth + 1);
+      return;
+    }
+
+    // The sweep is also split in to steps of about a brick, so that diagonal normals stay tight
+    float normalLength = 0.0f;
+    for (const auto vert : {&_a, &_b, &_c})
+      normalLength = std::max(normalLength, std::sqrt(glm::dot(vert->m_normal, vert->m_normal)));
+    const float sweep = (m_maxDisp - m_minDisp) * normalLength * m_texelScale;
+    const int steps = std::max(1, static_cast<int>(std::ceil(sweep / BrickVolume::k_brickDim)));
+    const float step = (m_maxDisp - m_minDisp) / static_cast<float>(steps);
+    for (int i = 0; i < steps; ++i)
+    {
+      const float disp = m_minDisp + step * static_cast<float>(i);
+      const auto bounds = sweptBounds(_a, _b, _c, disp, i + 1 == steps ? m_maxDisp : disp + step);
+      markBounds(bounds.first, bounds.second);
+    }
+  }
+
+  //-----------------------------------------------------------------------------------------------------
+  /// @brief The bounds of a triangle swept between two displacements, in texels, which is conservative
+  /// as every point of the sweep is a blend of the six corners.
+  //-----------------------------------------------------------------------------------------------------
+  std::pair<glm::vec3, glm::vec3> sweptBounds(
+      const SweptVertex &_a,
+      const SweptVertex &_b,
+      const SweptVertex &_c,
+      const float _minDisp,
+      const float _maxDisp
+      ) const
+  {
+    glm::vec3 lo(std::numeric_limits<float>::max());
+    glm::vec3 hi(std::numeric_limits<float>::lowest());
+    for (const auto vert : {&_a, &_b, &_c})
+    {
+      for (const auto disp : {_minDisp, _maxDisp})
+      {
+        const auto texel = (vert->m_pos + vert->m_normal * disp) * m_texelScale + m_texelOffset;
+        lo = glm::min(lo, texel);
+        hi = glm::max(hi, texel);
+      }
+    }
+    return {lo, hi};
+  }
+
+  void markBounds(const glm::vec3 &_lo, const glm::vec3 &_hi)
+  {
+    // A texel of margin covers the filter footprint, the level is fitted to include it
+    const float brickDim = static_cast<float>(BrickVolume::k_brickDim);
+    const glm::ivec3 first = glm::max(glm::ivec3(glm::floor((_lo - 1.0f) / brickDim)), glm::ivec3(0));
+    const glm::ivec3 last = glm::min(glm::ivec3(glm::floor((_hi + 1.0f) / brickDim)), m_bricks - 1);
+    for (int z = first.z; z <= last.z; ++z)
+    {
+      for (int y = first.y; y <= last.y; ++y)
+      {
+        for (int x = first.x; x <= last.x; ++x)
+          m_marked[static_cast<size_t>(x + m_bricks.x * (y + m_bricks.y * z))] = 1;
+      }
+    }
+  }
+};
+}
+
+//-----------------------------------------------------------------------------------------------------
+BrickLayout BrickVolume::build(
+    const std::vector<glm::vec3> &_vertices,
+    const std::vector<glm::vec3> &_normals,
+    const std::vector<uint16_t> &_indices,
+    const float _scale,
+    const glm::vec3 &_offset,
+    const float _minDisp,
+    const float _maxDisp,
+    const int _dim,
+    const int _maxPoolDim
+    )
+{
+  if (_indices.empty())
+    return BrickLayout();
+  // Every level is fitted to the bounds of the swept surface, the sweep of each triangle lies within
+  // the bounds of it's corners
+  const float minDisp = std::min(_minDisp, _maxDisp);
+  const float maxDisp = std::max(_minDisp, _maxDisp);
+  glm::vec3 lo(std::numeric_limits<float>::max());
+  glm::vec3 hi(std::numeric_limits<float>::lowest());
+  for (const auto index : _indices)
+  {
+    for (const auto disp : {minDisp, maxDisp})
+    {
+      const auto coord = (_vertices[index] + _normals[index] * disp) * _scale + _offset;
+      lo = glm::min(lo, coord);
+      hi = glm::max(hi, coord);
+    }
+  }
+
+  BrickLayout layout;
+  layout.m_dim = _dim;
+  for (int dim = _dim; dim > 0 && static_cast<int>(layout.m_levels.size()) < k_maxLevels; dim /= 2)
+  {
+    BrickLevel level;
+    level.m_dim = dim;
+    // With a texel of margin either side for filtering
+    const float dimF = static_cast<float>(dim);
+    level.m_origin = glm::ivec3(glm::floor(lo * dimF)) - 1;
+    const glm::ivec3 end = glm::ivec3(glm::ceil(hi * dimF)) + 1;
+    level.m_bricks = (end - level.m_origin + k_brickDim - 1) / k_brickDim;
+    if (glm::any(glm::greaterThan(level.m_bricks, glm::ivec3(256))))
+      return BrickLayout();
+
+    BandMarker marker {
+      minDisp,
+      maxDisp,
+      _scale * dimF,
+      _offset * dimF - glm::vec3(level.m_origin),
+      level.m_bricks,
+      std::vector<uint8_t>(static_cast<size_t>(level.m_bricks.x * level.m_bricks.y * level.m_bricks.z), 0)
+    };
+    for (size_t i = 0; i + 2 < _indices.size(); i += 3)
+    {
+      const auto vert = [&](const size_t _index)
+      {
+        return SweptVertex {_vertices[_index], _normals[_index]};
+      };
+      marker.mark(vert(_indices[i]), vert(_indices[i + 1]), vert(_indices[i + 2]), 0);
+    }
+
+    const auto levelIndex = static_cast<uint32_t>(layout.m_levels.size());
+    level.m_indirectionSlice = layout.m_indirectionSize.z;
+    level.m_firstBrick = static_cast<int>(layout.m_bricks.size());
+    for (size_t i = 0; i < marker.m_marked.size(); ++i)
+    {
+      if (!marker.m_marked[i]) continue;
+      const auto brick = static_cast<uint32_t>(i);
+      const auto bx = static_cast<uint32_t>(level.m_bricks.x);
+      const auto by = static_cast<uint32_t>(level.m_bricks.y);
+      layout.m_bricks.push_back((brick % bx) | ((brick / bx) % by) << 8 | (brick / (bx * by)) << 16 | levelIndex << 24);
+    }
+    level.m_numBricks = static_cast<int>(layout.m_bricks.size()) - level.m_firstBrick;
+    layout.m_indirectionSize = glm::max(layout.m_indirectionSize, level.m_bricks);
+    layout.m_indirectionSize.z = level.m_indirectionSlice + level.m_bricks.z;
+    layout.m_levels.push_back(level);
+    // The coarsest level is a single brick
+    if (level.m_bricks == glm::ivec3(1)) break;
+  }
+
+  // Keep the pool close to a cube, and within the limits of the texture size and our 8 bit coordinates
+  const int count = static_cast<int>(layout.m_bricks.size());
+  const int maxBricks = std::min(_maxPoolDim / k_paddedDim, 256);
+  const int side = std::min(static_cast<int>(std::ceil(std::cbrt(static_cast<double>(count)))), maxBricks);
+  const int layers = side ? (count + side * side - 1) / (side * side) : 0;
+  if (!count || layers > maxBricks || layout.m_indirectionSize.z > _maxPoolDim)
+    return BrickLayout();
+
+  layout.m_poolBricks = glm::ivec3(side, side, layers);
+  const auto& size = layout.m_indirectionSize;
+  layout.m_indirection.assign(static_cast<size_t>(size.x * size.y * size.z) * 4, 0);
+  for (int i = 0; i < count; ++i)
+  {
+    const auto brick = layout.m_bricks[static_cast<size_t>(i)];
+    const auto& level = layout.m_levels[brick >> 24];
+    const int z = level.m_indirectionSlice + static_cast<int>((brick >> 16) & 0xFF);
+    const auto texel = static_cast<size_t>(static_cast<int>(brick & 0xFF) + size.x * (static_cast<int>((brick >> 8) & 0xFF) + size.y * z));
+    auto entry = &layout.m_indirection[texel * 4];
+    entry[0] = static_cast<uint8_t>(i % side);
+    entry[1] = static_cast<uint8_t>((i / side) % side);
+    entry[2] = static_cast<uint8_t>(i / (side * side));
+    entry[3] = 255;
+  }
+  return layout;
+}
+//-----------------------------------------------------------------------------------------------------
+size_t BrickVolume::poolBytes(const BrickLayout &_layout, const size_t _bytesPerTexel) noexcept
+{
+  const auto bricks = static_cast<size_t>(_layout.m_poolBricks.x * _layout.m_poolBricks.y * _layout.m_poolBricks.z);
+  return bricks * static_cast<size_t>(k_paddedDim * k_paddedDim * k_paddedDim) * _bytesPerTexel;
+}
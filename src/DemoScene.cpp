@@ -3,6 +3,9 @@
 #include <QOpenGLContext>
 #include <QOpenGLFunctions_4_1_Core>
 #include <QOpenGLFramebufferObject>
+#include <QColorDialog>
+#include <cmath>
+#include <algorithm>
 
 //-----------------------------------------------------------------------------------------------------
 void DemoScene::writeMeshAttributes()
@@ -53,6 +56,8 @@ void DemoScene::initGeo()
   // Create and bind our Vertex Array Object
   m_vao->create();
   m_vao->bind();
+  for (auto& timer : m_drawTimers)
+    timer.create();
   // Create and bind our Vertex Buffer Object
   m_meshVBO.init();
   generateNewGeometry();
@@ -69,26 +74,24 @@ void DemoScene::initMaterials()
 {
   m_material.reset(new MaterialPBR(m_camera, m_shaderLib, &m_matrices, context(), 0.5f, 0.2f, 0.0, 0.1f, 0.3f, 200u, 25u));
 
-  auto name = m_shaderLib->loadShaderProg(m_material->shaderFileName());
+  // Only submit the program here, it will finish compiling while the material bakes it's textures
+  auto name = m_shaderLib->submitShaderProg(m_material->shaderFileName());
   m_material->setShaderName(name);
   m_material->apply();
 }
 //-----------------------------------------------------------------------------------------------------
 void DemoScene::metallicUpdate(const double _metallic)
 {
-  makeCurrent();
   m_material->setMetallic(static_cast<float>(_metallic));
 }
 //-----------------------------------------------------------------------------------------------------
 void DemoScene::aoUpdate(const double _ao)
 {
-  makeCurrent();
   m_material->setAO(static_cast<float>(_ao));
 }
 //-----------------------------------------------------------------------------------------------------
 void DemoScene::eyeTranslateXUpdate(const double _x)
 {
-  makeCurrent();
   auto currentTranslate = m_material->getEyeTranslate();
   currentTranslate.x = static_cast<float>(_x);
   m_material->setEyeTranslate(currentTranslate);
@@ -96,7 +99,6 @@ void DemoScene::eyeTranslateXUpdate(const double _x)
 //-----------------------------------------------------------------------------------------------------
 void DemoScene::eyeTranslateYUpdate(const double _y)
 {
-  makeCurrent();
   auto currentTranslate = m_material->getEyeTranslate();
   currentTranslate.y = static_cast<float>(_y);
   m_material->setEyeTranslate(currentTranslate);
@@ -104,7 +106,6 @@ void DemoScene::eyeTranslateYUpdate(const double _y)
 //-----------------------------------------------------------------------------------------------------
 void DemoScene::eyeTranslateZUpdate(const double _z)
 {
-  makeCurrent();
   auto currentTranslate = m_material->getEyeTranslate();
   currentTranslate.z = static_cast<float>(_z);
   m_material->setEyeTranslate(currentTranslate);
@@ -112,25 +113,21 @@ void DemoScene::eyeTranslateZUpdate(const double _z)
 //-----------------------------------------------------------------------------------------------------
 void DemoScene::roughnessUpdate(const double _roughness)
 {
-  makeCurrent();
   m_material->setRoughness(static_cast<float>(_roughness));
 }
 //-----------------------------------------------------------------------------------------------------
 void DemoScene::baseSpecUpdate(const double _baseSpec)
 {
-  makeCurrent();
   m_material->setBaseSpec(static_cast<float>(_baseSpec));
 }
 //-----------------------------------------------------------------------------------------------------
 void DemoScene::normalStrengthUpdate(const double _normalStrength)
 {
-  makeCurrent();
   m_material->setNormalStrength(static_cast<float>(_normalStrength));
 }
 //-----------------------------------------------------------------------------------------------------
 void DemoScene::setPaused(const bool _paused)
 {
-  makeCurrent();
   m_material->setPaused(_paused);
 }
 //-----------------------------------------------------------------------------------------------------
@@ -142,82 +139,89 @@ void DemoScene::tessUpdate(const int _tessType)
 //-----------------------------------------------------------------------------------------------------
 void DemoScene::phongStrengthUpdate(const int _strengthPercent)
 {
-  makeCurrent();
   m_material->setPhongStrength(_strengthPercent * 0.01f);
 }
 //-----------------------------------------------------------------------------------------------------
 void DemoScene::tessLevelInnerUpdate(const int _tessLevel)
 {
-  makeCurrent();
   m_material->setTessLevelInner(_tessLevel);
 }
 //-----------------------------------------------------------------------------------------------------
 void DemoScene::tessLevelOuterUpdate(const int _tessLevel)
 {
-  makeCurrent();
   m_material->setTessLevelOuter(_tessLevel);
 }
 //-----------------------------------------------------------------------------------------------------
 void DemoScene::eyeDispUpdate(const double _eyeDisp)
 {
-  makeCurrent();
   m_material->setEyeDisp(static_cast<float>(_eyeDisp));
 }
 //-----------------------------------------------------------------------------------------------------
 void DemoScene::eyeScaleUpdate(const double _eyeScale)
 {
-  makeCurrent();
   m_material->setEyeScale(static_cast<float>(_eyeScale));
 }
 //-----------------------------------------------------------------------------------------------------
 void DemoScene::eyeRotationUpdate(const double _eyeRotation)
 {
-  makeCurrent();
   m_material->setEyeRotation(static_cast<float>(_eyeRotation));
 }
 //-----------------------------------------------------------------------------------------------------
 void DemoScene::eyeWarpUpdate(const double _eyeWarp)
 {
-  makeCurrent();
   m_material->setEyeWarp(static_cast<float>(_eyeWarp));
 }
 //-----------------------------------------------------------------------------------------------------
 void DemoScene::eyeExponentUpdate(const double _eyeExponent)
 {
-  makeCurrent();
   m_material->setEyeExponent(static_cast<float>(_eyeExponent));
 }
 //-----------------------------------------------------------------------------------------------------
 void DemoScene::eyeThicknessUpdate(const double _eyeThickness)
 {
-  makeCurrent();
   m_material->setEyeThickness(static_cast<float>(_eyeThickness));
 }
 //-----------------------------------------------------------------------------------------------------
 void DemoScene::eyeGapUpdate(const double _eyeGap)
 {
-  makeCurrent();
   m_material->setEyeGap(static_cast<float>(_eyeGap));
 }
 //-----------------------------------------------------------------------------------------------------
 void DemoScene::eyeFuzzUpdate(const double _eyeFuzz)
 {
-  makeCurrent();
   m_material->setEyeFuzz(static_cast<float>(_eyeFuzz));
 }
 //-----------------------------------------------------------------------------------------------------
 void DemoScene::eyeMaskCapUpdate(const double _cap)
 {
-  makeCurrent();
   m_material->setEyeMaskCap(static_cast<float>(_cap));
 }
 //-----------------------------------------------------------------------------------------------------
 void DemoScene::tessMaskCapUpdate(const double _cap)
 {
-  makeCurrent();
   m_material->setTessMaskCap(static_cast<float>(_cap));
 }
 //-----------------------------------------------------------------------------------------------------
+void DemoScene::paletteLayerUpdate(const int _layer)
+{
+  m_paletteLayer = static_cast<size_t>(std::max(_layer, 0));
+}
+//-----------------------------------------------------------------------------------------------------
+void DemoScene::paletteColourUpdate()
+{
+  // The palette is linear, while the dialog works in sRGB
+  constexpr float k_gamma = 2.2f;
+  const auto linear = m_material->getColour(m_paletteLayer);
+  const auto initial = QColor::fromRgbF(
+        std::pow(linear.x, 1.0f / k_gamma), std::pow(linear.y, 1.0f / k_gamma), std::pow(linear.z, 1.0f / k_gamma));
+  const auto colour = QColorDialog::getColor(initial, this, "Layer " + QString::number(m_paletteLayer));
+  if (!colour.isValid()) return;
+  m_material->setColour(m_paletteLayer, glm::vec3(
+                          std::pow(static_cast<float>(colour.redF()), k_gamma),
+                          std::pow(static_cast<float>(colour.greenF()), k_gamma),
+                          std::pow(static_cast<float>(colour.blueF()), k_gamma)));
+}
+//-----------------------------------------------------------------------------------------------------
 void DemoScene::generateNewGeometry()
 {
   makeCurrent();
@@ -239,8 +243,32 @@ void DemoScene::renderScene()
 
   m_material->update();
 
+  // The two timers alternate, so every frame is timed unless the GPU falls more than a frame behind. A
+  // result is only read once it's ready, so we never stall
+  auto& timer = m_drawTimers[m_drawTimerIndex];
+  bool& pending = m_drawTimerPending[m_drawTimerIndex];
+  m_drawTimerIndex ^= 1;
+  if (pending && timer.isResultAvailable())
+  {
+    m_drawTime += static_cast<double>(timer.waitForResult()) * 1e-6;
+    pending = false;
+    // Averaged over a number of frames, so that material modes can be compared
+    if (++m_drawSamples == k_drawSamples)
+    {
+      emit drawTimeMeasured(m_drawTime / k_drawSamples);
+      m_drawTime = 0.0;
+      m_drawSamples = 0;
+    }
+  }
+  const bool timed = !pending;
+  if (timed) timer.begin();
   m_meshVBO.use();
-  glDrawElements(GL_PATCHES, m_owlMesh.getNIndicesData(), GL_UNSIGNED_SHORT, nullptr);
+  glDrawElements(m_material->primitiveType(), m_owlMesh.getNIndicesData(), GL_UNSIGNED_SHORT, nullptr);
+  if (timed)
+  {
+    timer.end();
+    pending = true;
+  }
 }
 //-----------------------------------------------------------------------------------------------------
 
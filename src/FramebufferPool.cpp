@@ -0,0 +1,87 @@
+#include "FramebufferPool.h"
+#include <QOpenGLFunctions_4_3_Core>
+#include <iostream>
+
+//-----------------------------------------------------------------------------------------------------
+void FramebufferPool::init(QOpenGLContext* io_context)
+{
+  m_context = io_context;
+}
+//-----------------------------------------------------------------------------------------------------
+void FramebufferPool::reset()
+{
+  if (!m_context || m_framebuffers.empty()) return;
+  auto funcs = m_context->versionFunctions<QOpenGLFunctions_4_3_Core>();
+  funcs->glDeleteFramebuffers(static_cast<GLsizei>(m_framebuffers.size()), m_framebuffers.data());
+  m_framebuffers.clear();
+  m_free.clear();
+  m_bound.clear();
+}
+//-----------------------------------------------------------------------------------------------------
+void FramebufferPool::bindTarget(
+    const GLuint _texture,
+    const GLint _level,
+    const int _width,
+    const int _height,
+    const GLint _layer
+    )
+{
+  auto funcs = m_context->versionFunctions<QOpenGLFunctions_4_3_Core>();
+  if (m_bound.empty())
+    funcs->glGetIntegerv(GL_VIEWPORT, m_savedViewport);
+
+  GLuint fbo = 0;
+  if (m_free.empty())
+  {
+    funcs->glGenFramebuffers(1, &fbo);
+    m_framebuffers.push_back(fbo);
+  }
+  else
+  {
+    fbo = m_free.back();
+    m_free.pop_back();
+  }
+
+  funcs->glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+  // Layered attachments need glFramebufferTexture, which also works for plain 2D textures
+  if (_layer < 0)
+    funcs->glFramebufferTexture(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, _texture, _level);
+  else
+    funcs->glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, _texture, _level, _layer);
+
+  const auto status = funcs->glCheckFramebufferStatus(GL_FRAMEBUFFER);
+  if (status != GL_FRAMEBUFFER_COMPLETE)
+    std::cerr << "FramebufferPool: incomplete framebuffer, status 0x" << std::hex << status << std::dec << '\n';
+
+  funcs->glViewport(0, 0, _width, _height);
+  m_bound.push_back({fbo, _width, _height});
+}
+//-----------------------------------------------------------------------------------------------------
+void FramebufferPool::releaseTarget()
+{
+  if (m_bound.empty()) return;
+  auto funcs = m_context->versionFunctions<QOpenGLFunctions_4_3_Core>();
+  const auto fbo = m_bound.back().m_fbo;
+  m_bound.pop_back();
+
+  // Detach so the pool doesn't keep textures that are deleted later alive
+  funcs->glFramebufferTexture(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, 0, 0);
+  m_free.push_back(fbo);
+
+  if (m_bound.empty())
+  {
+    funcs->glBindFramebuffer(GL_FRAMEBUFFER, m_context->defaultFramebufferObject());
+    funcs->glViewport(m_savedViewport[0], m_savedViewport[1], m_savedViewport[2], m_savedViewport[3]);
+  }
+  else
+  {
+    const auto& previous = m_bound.back();
+    funcs->glBindFramebuffer(GL_FRAMEBUFFER, previous.m_fbo);
+    funcs->glViewport(0, 0, previous.m_width, previous.m_height);
+  }
+}
+//-----------------------------------------------------------------------------------------------------
+size_t FramebufferPool::size() const noexcept
+{
+  return m_framebuffers.size();
+}
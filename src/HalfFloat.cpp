@@ -0,0 +1,94 @@
+#include "HalfFloat.h"
+
+// F16C is either enabled for the whole build, or we compile just these functions for it and check the
+// CPU at runtime, so the application still runs on processors without it
+#if defined(__F16C__) || defined(__AVX2__)
+#define HALFFLOAT_F16C 1
+#define HALFFLOAT_F16C_TARGET
+#elif (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define HALFFLOAT_F16C 1
+#define HALFFLOAT_F16C_DISPATCH 1
+#define HALFFLOAT_F16C_TARGET __attribute__((target("avx,f16c")))
+#endif
+
+#ifdef HALFFLOAT_F16C
+#include <immintrin.h>
+#endif
+
+namespace
+{
+void fromFloatsScalar(const float* _src, uint16_t* o_dst, const size_t _count) noexcept
+{
+  for (size_t i = 0; i < _count; ++i)
+    o_dst[i] = HalfFloat::fromFloat(_src[i]);
+}
+
+void toFloatsScalar(const uint16_t* _src, float* o_dst, const size_t _count) noexcept
+{
+  for (size_t i = 0; i < _count; ++i)
+    o_dst[i] = HalfFloat::toFloat(_src[i]);
+}
+
+#ifdef HALFFLOAT_F16C
+HALFFLOAT_F16C_TARGET void fromFloatsF16C(const float* _src, uint16_t* o_dst, const size_t _count) noexcept
+{
+  size_t i = 0;
+  for (; i + 8 <= _count; i += 8)
+  {
+    const __m256 values = _mm256_loadu_ps(_src + i);
+    // Round to nearest even, to match the scalar conversion
+    const __m128i halfs = _mm256_cvtps_ph(values, _MM_FROUND_TO_NEAREST_INT);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(o_dst + i), halfs);
+  }
+  fromFloatsScalar(_src + i, o_dst + i, _count - i);
+}
+
+HALFFLOAT_F16C_TARGET void toFloatsF16C(const uint16_t* _src, float* o_dst, const size_t _count) noexcept
+{
+  size_t i = 0;
+  for (; i + 8 <= _count; i += 8)
+  {
+    const __m128i halfs = _mm_loadu_si128(reinterpret_cast<const __m128i*>(_src + i));
+    _mm256_storeu_ps(o_dst + i, _mm256_cvtph_ps(halfs));
+  }
+  toFloatsScalar(_src + i, o_dst + i, _count - i);
+}
+#endif
+
+bool hasF16C() noexcept
+{
+#if defined(HALFFLOAT_F16C_DISPATCH)
+  static const bool supported = __builtin_cpu_supports("f16c") && __builtin_cpu_supports("avx");
+  return supported;
+#elif defined(HALFFLOAT_F16C)
+  return true;
+#else
+  return false;
+#endif
+}
+}
+
+//-----------------------------------------------------------------------------------------------------
+void HalfFloat::fromFloats(const float* _src, uint16_t* o_dst, const size_t _count) noexcept
+{
+#ifdef HALFFLOAT_F16C
+  if (hasF16C())
+  {
+    fromFloatsF16C(_src, o_dst, _count);
+    return;
+  }
+#endif
+  fromFloatsScalar(_src, o_dst, _count);
+}
+//-----------------------------------------------------------------------------------------------------
+void HalfFloat::toFloats(const uint16_t* _src, float* o_dst, const size_t _count) noexcept
+{
+#ifdef HALFFLOAT_F16C
+  if (hasF16C())
+  {
+    toFloatsF16C(_src, o_dst, _count);
+    return;
+  }
+#endif
+  toFloatsScalar(_src, o_dst, _count);
+}
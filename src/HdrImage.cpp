@@ -0,0 +1,201 @@
+#include "HdrImage.h"
+#include "HalfFloat.h"
+#include "ThreadPool.h"
+#include <fstream>
+#include <vector>
+#include <cmath>
+#include <cstdio>
+
+namespace
+{
+//-----------------------------------------------------------------------------------------------------
+/// @brief Parses the text header at the start of a file.
+//-----------------------------------------------------------------------------------------------------
+bool parseHeader(const unsigned char* _data, const size_t _size, HdrImage::Info &o_info)
+{
+  size_t pos = 0;
+  auto readLine = [&](std::string &o_line)
+  {
+    o_line.clear();
+    while (pos < _size && _data[pos] != '\n')
+      o_line += static_cast<char>(_data[pos++]);
+    if (pos >= _size) return false;
+    ++pos;
+    return true;
+  };
+
+  std::string line;
+  if (!readLine(line) || (line != "#?RADIANCE" && line != "#?RGBE")) return false;
+  // Variables end with a blank line, we only need to check the pixel format
+  bool validFormat = true;
+  while (readLine(line) && !line.empty())
+  {
+    if (line.compare(0, 7, "FORMAT=") == 0)
+      validFormat = line == "FORMAT=32-bit_rle_rgbe";
+  }
+  if (!validFormat || !readLine(line)) return false;
+
+  // Only rows of +X are supported, which covers every environment map we have seen
+  char yDir = 0;
+  int height = 0, width = 0;
+  if (std::sscanf(line.c_str(), "%cY %d +X %d", &yDir, &height, &width) != 3) return false;
+  if ((yDir != '-' && yDir != '+') || width <= 0 || height <= 0) return false;
+
+  o_info.m_width = width;
+  o_info.m_height = height;
+  o_info.m_bottomUp = yDir == '+';
+  o_info.m_dataOffset = pos;
+  return true;
+}
+
+//-----------------------------------------------------------------------------------------------------
+/// @brief Whether a scanline at this position uses the adaptive run length encoding.
+//-----------------------------------------------------------------------------------------------------
+bool isRunLength(const unsigned char* _data, const size_t _remaining, const int _width)
+{
+  if (_width < 8 || _width > 0x7fff || _remaining < 4) return false;
+  return _data[0] == 2 && _data[1] == 2 && !(_data[2] & 0x80) && ((_data[2] << 8) | _data[3]) == _width;
+}
+
+//-----------------------------------------------------------------------------------------------------
+/// @brief Finds the end of an encoded scanline without decoding it, returns zero if it's malformed.
+//-----------------------------------------------------------------------------------------------------
+size_t skipScanline(const unsigned char* _data, const size_t _remaining, const int _width)
+{
+  size_t pos = 4;
+  for (int channel = 0; channel < 4; ++channel)
+  {
+    int count = 0;
+    while (count < _width)
+    {
+      if (pos >= _remaining) return 0;
+      int run = _data[pos++];
+      if (run > 128)
+      {
+        run -= 128;
+        pos += 1;
+      }
+      else
+      {
+        pos += static_cast<size_t>(run);
+      }
+      if (!run) return 0;
+      count += run;
+    }
+    if (count != _width || pos > _remaining) return 0;
+  }
+  return pos;
+}
+
+//-----------------------------------------------------------------------------------------------------
+/// @brief Expands an encoded scanline into interleaved RGBE.
+//-----------------------------------------------------------------------------------------------------
+void decodeScanline(const unsigned char* _data, const int _width, unsigned char* o_rgbe)
+{
+  size_t pos = 4;
+  for (int channel = 0; channel < 4; ++channel)
+  {
+    int x = 0;
+    while (x < _width)
+    {
+      int run = _data[pos++];
+      if (run > 128)
+      {
+        run -= 128;
+        const unsigned char value = _data[pos++];
+        for (int i = 0; i < run; ++i, ++x)
+          o_rgbe[x * 4 + channel] = value;
+      }
+      else
+      {
+        for (int i = 0; i < run; ++i, ++x)
+          o_rgbe[x * 4 + channel] = _data[pos++];
+      }
+    }
+  }
+}
+
+//-----------------------------------------------------------------------------------------------------
+/// @brief Converts RGBE to float RGBA, the same way as stb_image, so results don't change.
+//-----------------------------------------------------------------------------------------------------
+void rgbeToFloat(const unsigned char* _rgbe, const int _width, float* o_rgba)
+{
+  for (int x = 0; x < _width; ++x)
+  {
+    const unsigned char* texel = _rgbe + x * 4;
+    const float scale = texel[3] ? std::ldexp(1.0f, texel[3] - (128 + 8)) : 0.0f;
+    o_rgba[x * 4 + 0] = texel[0] * scale;
+    o_rgba[x * 4 + 1] = texel[1] * scale;
+    o_rgba[x * 4 + 2] = texel[2] * scale;
+    o_rgba[x * 4 + 3] = 1.0f;
+  }
+}
+}
+
+//-----------------------------------------------------------------------------------------------------
+bool HdrImage::readInfo(const std::string &_path, Info &o_info)
+{
+  std::ifstream file(_path, std::ios::binary);
+  if (!file) return false;
+  // Headers are short, but may carry comments, so we allow plenty of room
+  std::vector<unsigned char> header(1 << 16);
+  file.read(reinterpret_cast<char*>(header.data()), static_cast<std::streamsize>(header.size()));
+  return parseHeader(header.data(), static_cast<size_t>(file.gcount()), o_info);
+}
+//-----------------------------------------------------------------------------------------------------
+bool HdrImage::loadRGBA16F(const std::string &_path, const Info &_info, uint16_t* o_pixels, ThreadPool &io_pool)
+{
+  std::ifstream file(_path, std::ios::binary | std::ios::ate);
+  if (!file) return false;
+  const auto fileSize = static_cast<size_t>(file.tellg());
+  if (fileSize <= _info.m_dataOffset) return false;
+  std::vector<unsigned char> data(fileSize);
+  file.seekg(0);
+  if (!file.read(reinterpret_cast<char*>(data.data()), static_cast<std::streamsize>(fileSize))) return false;
+
+  const int width = _info.m_width;
+  const size_t height = static_cast<size_t>(_info.m_height);
+  const size_t rowBytes = static_cast<size_t>(width) * 4;
+
+  // Scanlines are variable length, so find them all first, this only reads the run lengths
+  std::vector<size_t> rowOffsets(height);
+  const bool runLength = isRunLength(data.data() + _info.m_dataOffset, fileSize - _info.m_dataOffset, width);
+  size_t pos = _info.m_dataOffset;
+  for (size_t row = 0; row < height; ++row)
+  {
+    rowOffsets[row] = pos;
+    if (runLength)
+    {
+      if (!isRunLength(data.data() + pos, fileSize - pos, width)) return false;
+      const auto size = skipScanline(data.data() + pos, fileSize - pos, width);
+      if (!size) return false;
+      pos += size;
+    }
+    else
+    {
+      // Flat files store every pixel as 4 bytes
+      pos += rowBytes;
+      if (pos > fileSize) return false;
+    }
+  }
+
+  io_pool.parallelFor(height, [&](size_t _begin, size_t _end)
+  {
+    std::vector<unsigned char> rgbe(runLength ? rowBytes : 0);
+    std::vector<float> rgba(rowBytes);
+    for (size_t row = _begin; row < _end; ++row)
+    {
+      const unsigned char* scanline = data.data() + rowOffsets[row];
+      if (runLength)
+      {
+        decodeScanline(scanline, width, rgbe.data());
+        scanline = rgbe.data();
+      }
+      rgbeToFloat(scanline, width, rgba.data());
+      // GL wants the bottom row first
+      const size_t outRow = _info.m_bottomUp ? row : height - 1 - row;
+      HalfFloat::fromFloats(rgba.data(), o_pixels + outRow * rowBytes, rowBytes);
+    }
+  }, 8);
+  return true;
+}
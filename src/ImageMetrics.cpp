@@ -0,0 +1,35 @@
+#include "ImageMetrics.h"
+#include <cmath>
+#include <limits>
+#include <algorithm>
+
+//-----------------------------------------------------------------------------------------------------
+ImageMetrics::Error ImageMetrics::compare(
+    const float* _test,
+    const float* _reference,
+    const size_t _count,
+    const float _peak
+    ) noexcept
+{
+  Error error;
+  if (!_count) return error;
+
+  double squaredError = 0.0;
+  double squaredReference = 0.0;
+  float peak = _peak;
+  for (size_t i = 0; i < _count; ++i)
+  {
+    const double diff = static_cast<double>(_test[i]) - _reference[i];
+    squaredError += diff * diff;
+    squaredReference += static_cast<double>(_reference[i]) * _reference[i];
+    if (_peak <= 0.0f) peak = std::max(peak, _reference[i]);
+  }
+
+  const double mse = squaredError / _count;
+  error.m_rmse = std::sqrt(mse);
+  error.m_relativeRmse = squaredReference > 0.0 ? std::sqrt(squaredError / squaredReference) : 0.0;
+  error.m_psnr = mse > 0.0 ?
+        10.0 * std::log10(static_cast<double>(peak) * peak / mse) :
+        std::numeric_limits<double>::infinity();
+  return error;
+}
@@ -1,4 +1,5 @@
 #include "MainWindow.h"
+#include <QStatusBar>
 
 
 void MainWindow::init(const std::shared_ptr<Scene> &io_scene)
@@ -35,6 +36,17 @@ void MainWindow::init(const std::shared_ptr<Scene> &io_scene)
   connect(m_ui.eyeTranslateXSpinBox, SIGNAL(valueChanged(double)), m_scene.get(), SLOT(eyeTranslateXUpdate(double)));
   connect(m_ui.eyeTranslateYSpinBox, SIGNAL(valueChanged(double)), m_scene.get(), SLOT(eyeTranslateYUpdate(double)));
   connect(m_ui.eyeTranslateZSpinBox, SIGNAL(valueChanged(double)), m_scene.get(), SLOT(eyeTranslateZUpdate(double)));
+
+  connect(m_ui.paletteLayerSpinBox, SIGNAL(valueChanged(int)), m_scene.get(), SLOT(paletteLayerUpdate(int)));
+  connect(m_ui.paletteColourButton, SIGNAL(clicked()), m_scene.get(), SLOT(paletteColourUpdate()));
+  connect(m_scene.get(), SIGNAL(drawTimeMeasured(double)), this, SLOT(drawTimeUpdate(double)));
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void MainWindow::drawTimeUpdate(const double _ms)
+{
+  statusBar()->showMessage("Owl draw: " + QString::number(_ms, 'f', 3) + "ms");
 }
 
 //----------------------------------------------------------------------------------------------------------------------
@@ -5,8 +5,9 @@ Material::~Material() = default;
 //-----------------------------------------------------------------------------------------------------
 void Material::apply()
 {
-  m_shaderLib->useShader(m_shaderName);
+  // Initialise first, so that any work done there overlaps with our shader compiling
   init();
+  m_shaderLib->useShader(m_shaderName);
 }
 //-----------------------------------------------------------------------------------------------------
 void Material::setShaderName(const std::string &_name)
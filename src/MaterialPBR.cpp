@@ -2,57 +2,272 @@
 #include "Scene.h"
 #include "ShaderLib.h"
 #include <QOpenGLFunctions_4_3_Core>
-#include <QOpenGLFramebufferObject>
+#include "HashUtils.h"
+#include "vec4.hpp"
+#include "TextureIO.h"
+#include "SphericalHarmonics.h"
+#include "ThreadPool.h"
+#include "ImageMetrics.h"
+#include "BrdfLut.h"
+#include "HdrImage.h"
+#include "OwlNoise.h"
+#include <iostream>
+#include <sstream>
+#include <cmath>
+#include <algorithm>
 #define STB_IMAGE_IMPLEMENTATION
 #include "stb/stb_image.h"
 
+namespace
+{
+constexpr const char* k_envMapPath = "images/Alexs_Apt_2k.hdr";
+constexpr const char* k_iblCacheDir = "cache/ibl/";
+//-----------------------------------------------------------------------------------------------------
+/// @brief Bump this whenever the bake shaders or settings change, so that stale caches are ignored.
+//-----------------------------------------------------------------------------------------------------
+constexpr unsigned k_iblBakeVersion = 5;
+constexpr int k_cubeMapDim = 512;
+constexpr int k_prefilterDim = 128;
+//-----------------------------------------------------------------------------------------------------
+/// @brief Roughness is mapped across every level, owl_pbr_frag.glsl relies on this being 5.
+//-----------------------------------------------------------------------------------------------------
+constexpr int k_prefilterMips = 5;
+//-----------------------------------------------------------------------------------------------------
+/// @brief The sample count that prefilter bakes are measured against in debug builds.
+//-----------------------------------------------------------------------------------------------------
+constexpr unsigned k_referencePrefilterSamples = 1024;
+constexpr int k_brdfDim = 512;
+constexpr int k_volumeDim = 512;
+//-----------------------------------------------------------------------------------------------------
+/// @brief The coarse volume that is shown while the full volume is baked over several frames.
+//-----------------------------------------------------------------------------------------------------
+constexpr int k_previewVolumeDim = 64;
+constexpr const char* k_volumeCacheDir = "cache/volumes/";
+//-----------------------------------------------------------------------------------------------------
+/// @brief Bump this whenever the volume bake changes in a way that the shader sources don't capture.
+//-----------------------------------------------------------------------------------------------------
+constexpr unsigned k_volumeBakeVersion = 3;
+constexpr const char* k_volumeSurfacePath = "models/owl.obj";
+//-----------------------------------------------------------------------------------------------------
+/// @brief Maps base positions to volume coordinates, this must match owl_pbr_frag.glsl.
+//-----------------------------------------------------------------------------------------------------
+constexpr float k_volumeScale = 0.2f;
+const glm::vec3 k_volumeOffset {0.5f, 0.55f, 0.5f};
+//-----------------------------------------------------------------------------------------------------
+/// @brief The largest height the eyes can reach, before it's scaled by the eye displacement.
+//-----------------------------------------------------------------------------------------------------
+constexpr float k_maxEyeHeight = 1.0f;
+//-----------------------------------------------------------------------------------------------------
+/// @brief The bricks allow for eye displacements in steps of this, so small changes don't rebake.
+//-----------------------------------------------------------------------------------------------------
+constexpr float k_eyeDispStep = 0.25f;
+//-----------------------------------------------------------------------------------------------------
+/// @brief The surface atlases are square, and are dilated by a texel per step.
+//-----------------------------------------------------------------------------------------------------
+constexpr int k_atlasDim = 1024;
+constexpr int k_atlasDilation = 8;
+//-----------------------------------------------------------------------------------------------------
+/// @brief Tiled volumes repeat a tile across the volume, at the same texel density as the brick pools.
+/// The detail tile repeats a coprime number of times, so the two only line up again across the whole
+/// volume, and it's noise is offset so that it has features of it's own.
+//-----------------------------------------------------------------------------------------------------
+constexpr int k_tileDim = 128;
+constexpr int k_tileRepeats = 4;
+constexpr int k_detailTileDim = 72;
+constexpr int k_detailTileRepeats = 7;
+const glm::vec3 k_detailTileOffset {12.0f, 7.0f, 3.0f};
+
+//-----------------------------------------------------------------------------------------------------
+/// @brief One dispatch of a volume bake, over the pool layers that hold a level.
+//-----------------------------------------------------------------------------------------------------
+struct BrickPass
+{
+  const char* m_shaderName;
+  bool m_normals;
+  int m_level;
+  int m_firstLayer;
+  int m_numLayers;
+};
+
+//-----------------------------------------------------------------------------------------------------
+/// @brief Lists the passes of a volume bake in the order they must run. The finest level of both pools
+/// is baked first, then each coarser level is averaged from the level before it.
+//-----------------------------------------------------------------------------------------------------
+std::vector<BrickPass> brickPasses(const BrickLayout &_layout, const bool _normals)
+{
+  std::vector<BrickPass> passes;
+  const int layerBricks = _layout.m_poolBricks.x * _layout.m_poolBricks.y;
+  for (size_t i = 0; i < _layout.m_levels.size(); ++i)
+  {
+    const auto& level = _layout.m_levels[i];
+    const int firstLayer = level.m_firstBrick / layerBricks;
+    const int numLayers = (level.m_firstBrick + level.m_numBricks + layerBricks - 1) / layerBricks - firstLayer;
+    const int index = static_cast<int>(i);
+    passes.push_back({i ? "owl_mip" : "owl_noise", false, index, firstLayer, numLayers});
+    if (_normals)
+      passes.push_back({i ? "owl_mip" : "owl_normal", true, index, firstLayer, numLayers});
+  }
+  return passes;
+}
+
+//-----------------------------------------------------------------------------------------------------
+/// @brief Used to get the size of every level and face of a texture.
+//-----------------------------------------------------------------------------------------------------
+size_t textureBytes(const TextureFile &_texture)
+{
+  size_t bytes = 0;
+  for (uint32_t level = 0; level < _texture.header().m_levels; ++level)
+    bytes += _texture.faceSize(level) * _texture.header().m_faces;
+  return bytes;
+}
+
+#ifdef QT_NO_DEBUG
+constexpr bool k_report = false;
+#else
+constexpr bool k_report = true;
+#endif
+//-----------------------------------------------------------------------------------------------------
+/// @brief Every measurement the material makes is printed through here, as a single line, and only in
+/// debug builds.
+//-----------------------------------------------------------------------------------------------------
+template <typename... Args>
+void report(const Args&... _args)
+{
+  if (!k_report) return;
+  std::ostringstream line;
+  const int expand[] = {0, ((line << _args), 0)...};
+  static_cast<void>(expand);
+  std::cout << line.str() << '\n';
+}
+
+//-----------------------------------------------------------------------------------------------------
+/// @brief Reports the saving and loss of a compressed texture.
+//-----------------------------------------------------------------------------------------------------
+void reportCompression(const char* _name, const size_t _sourceBytes, const size_t _compressedBytes, const ImageMetrics::Error &_error)
+{
+  report("BC6H ", _name, ": ", _sourceBytes / 1024, "KB to ", _compressedBytes / 1024,
+         "KB, PSNR ", _error.m_psnr, " dB, relative RMSE ", _error.m_relativeRmse);
+}
+
+//-----------------------------------------------------------------------------------------------------
+/// @brief Copies the displacement out of an RGBA16F albedo pool, in to an R16F pool of it's own.
+//-----------------------------------------------------------------------------------------------------
+TextureFile extractHeight(const TextureFile &_albedo)
+{
+  using tex = QOpenGLTexture;
+  auto header = _albedo.header();
+  header.m_internalFormat = tex::R16F;
+  header.m_pixelFormat = tex::Red;
+  header.m_pixelType = tex::Float16;
+  header.m_bytesPerPixel = sizeof(uint16_t);
+  TextureFile height(header);
+  const size_t count = height.faceSize(0) / sizeof(uint16_t);
+  const auto albedo = reinterpret_cast<const uint16_t*>(_albedo.data(0));
+  auto heights = reinterpret_cast<uint16_t*>(height.data(0));
+  for (size_t i = 0; i < count; ++i)
+    heights[i] = albedo[i * 4 + 3];
+  return height;
+}
+}
+
+//-----------------------------------------------------------------------------------------------------
+/// @brief The pools read back from a finished bake, and their compressed versions once encoded.
+//-----------------------------------------------------------------------------------------------------
+struct MaterialPBR::VolumeEncode
+{
+  unsigned m_generation;
+  unsigned m_albedoGeneration;
+  std::string m_cacheKey;
+  TextureFile m_albedo;
+  TextureFile m_normal;
+  TextureFile m_height;
+  BlockCompression::Range m_albedoRange;
+  BlockCompression::Range m_normalRange;
+  ImageMetrics::Error m_albedoError;
+  ImageMetrics::Error m_normalError;
+  size_t m_albedoBytes = 0;
+  size_t m_normalBytes = 0;
+  std::future<void> m_done;
+  //---------------------------------------------------------------------------------------------------
+  /// @brief Runs on a worker thread, the albedo and normals are replaced by their compressed versions.
+  //---------------------------------------------------------------------------------------------------
+  void encode()
+  {
+    auto& pool = ThreadPool::instance();
+    m_albedoBytes = textureBytes(m_albedo);
+    m_normalBytes = textureBytes(m_normal);
+    m_height = extractHeight(m_albedo);
+    auto albedo = BlockCompression::encode(m_albedo, m_albedoRange, pool);
+    m_albedoError = BlockCompression::measure(albedo, m_albedo, m_albedoRange, pool);
+    m_albedo = std::move(albedo);
+    if (!m_normal.header().m_levels) return;
+    auto normal = BlockCompression::encode(m_normal, m_normalRange, pool);
+    m_normalError = BlockCompression::measure(normal, m_normal, m_normalRange, pool);
+    m_normal = std::move(normal);
+  }
+};
+
+//-----------------------------------------------------------------------------------------------------
+/// @brief The pools of a finished bake or recolour, while they're read back over the following frames.
+//-----------------------------------------------------------------------------------------------------
+struct MaterialPBR::VolumeReadback
+{
+  std::shared_ptr<VolumeEncode> m_job;
+  TextureIO::Download m_albedo;
+  TextureIO::Download m_normal;
+  std::array<TextureIO::Download, 2> m_layers;
+  bool m_encode = false;
+};
+
 void MaterialPBR::init()
 {
-  auto shaderPtr = m_shaderLib->getShader(m_shaderName);
-  auto funcs = m_context->versionFunctions<QOpenGLFunctions_4_3_Core>();
+  // We can skip every environment bake if the results of a previous run are on disk
+  const bool iblCached = loadIblCache();
+  // The BRDF table doesn't depend on the environment, and ships as a precomputed asset
+  const bool brdfLoaded = loadBrdfLUT();
+  // Start decoding the environment on a loader thread, it isn't needed until the end of init
+  if (!iblCached)
+    beginSphereMapLoad();
+
+  // Submit every bake program up front, so that they compile while we load meshes and images
+  std::vector<const char*> bakePrograms = {
+    "shaderPrograms/owl_noise.json",
+    "shaderPrograms/owl_normal.json",
+    "shaderPrograms/owl_mip.json",
+    "shaderPrograms/owl_recombine.json",
+    "shaderPrograms/owl_tile.json",
+    "shaderPrograms/owl_atlas.json",
+    "shaderPrograms/owl_atlas_dilate.json"
+  };
+  if (!iblCached)
+  {
+    bakePrograms.insert(bakePrograms.end(), {
+                          "shaderPrograms/hdr_cubemap.json",
+                          "shaderPrograms/hdr_cubemap_prefilter.json"
+                        });
+  }
+  if (!brdfLoaded)
+    bakePrograms.push_back("shaderPrograms/hdr_cubemap_brdf.json");
+  for (const auto bakeProgram : bakePrograms)
+  {
+    m_shaderLib->submitShaderProg(bakeProgram);
+  }
+  m_shaderLib->submitVariant("owl_atlas", {"NORMALS"});
+
+  // Every bake below renders through the same few framebuffers
+  m_bakeTargets.init(m_context);
+
   QOpenGLVertexArrayObject vao;
   // Create and bind our Vertex Array Object
   vao.create();
   vao.bind();
 
-  TriMesh cube;
-  cube.load("models/unitCube.obj");
   TriMesh plane;
   plane.load("models/unitPlane.obj");
 
   MeshVBO vbo;
   // Create and bind our Vertex Buffer Object
   vbo.init();
-  vbo.reset(sizeof(GLushort), cube.getNIndicesData(), sizeof(GLfloat), cube.getNVertData(), cube.getNUVData(), cube.getNNormData());
-  {
-    using namespace MeshAttributes;
-    vbo.write(cube.getVertexData(), VERTEX);
-    vbo.setIndices(cube.getIndicesData());
-  }
-
-  initCaptureMatrices();
-  initSphereMap();
-  // Generate cube map from sphere map
-  generateCubeMap(cube, vbo, m_cubeMap, 512, "shaderPrograms/hdr_cubemap.json", [&sphereMap = m_sphereMap, &projection = m_captureProjection](auto shader)
-  {
-    // convert HDR equirectangular environment map to cubemap equivalent
-    shader->bind();
-    shader->setUniformValue("u_sphereMap", 0);
-    // Need to transpose the matrix as they both use different majors
-    shader->setUniformValue("u_P", projection);
-    sphereMap->bind(0);
-  });
-  // Generate irradiance map
-  generateCubeMap(cube, vbo, m_irradianceMap, 32, "shaderPrograms/hdr_cubemap_irradiance.json", [&cubeMap = m_cubeMap, &projection = m_captureProjection](auto shader)
-  {
-    // convert HDR equirectangular environment map to cubemap equivalent
-    shader->bind();
-    shader->setUniformValue("u_envMap", 0);
-    // Need to transpose the matrix as they both use different majors
-    shader->setUniformValue("u_P", projection);
-    cubeMap->bind(0);
-  });
-  initPrefilteredMap(cube, vbo);
 
   vbo.reset(sizeof(GLushort), plane.getNIndicesData(), sizeof(GLfloat), plane.getNVertData(), plane.getNUVData(), plane.getNNormData());
   {
@@ -61,41 +276,55 @@ void MaterialPBR::init()
     vbo.write(plane.getUVsData(), UV);
     vbo.setIndices(plane.getIndicesData());
   }
-  initBrdfLUTMap(plane, vbo);
-
-  // Generate the albedo map
-  generate3DTexture(plane, vbo, m_albedoMap, 512, "shaderPrograms/owl_noise.json", QOpenGLTexture::RGBA16F,
-                    [&cols = m_colours](auto shader)
-  {
-    shader->setUniformValueArray("u_cols", cols.data(), static_cast<int>(cols.size()));
-  });
+  // Only bake the BRDF table on the GPU if the asset is missing
+  if (!brdfLoaded)
+    initBrdfLUTMap(plane, vbo);
 
-  // Generate the normal map
-  generate3DTexture(plane, vbo, m_normalMap, 512, "shaderPrograms/owl_normal.json", QOpenGLTexture::RGB16F,
-                    [&bumpMap = m_albedoMap](auto shader)
-  {
-    shader->setUniformValue("u_bumpMap", 0);
-    bumpMap->bind(0);
-  });
+  // The albedo and normal maps are only stored near the owl's surface
+  m_volumeSurface.load(k_volumeSurfacePath);
+  bakeVolumes();
 
   initTargets("models/morph_targets/owl_pose", 4);
 
-  shaderPtr->bind();
-  shaderPtr->setPatchVertexCount(3);
+  // The environment bakes come last, to give the loader thread as long as possible
+  if (!iblCached)
+  {
+    TriMesh cube;
+    cube.load("models/unitCube.obj");
+    vbo.reset(sizeof(GLushort), cube.getNIndicesData(), sizeof(GLfloat), cube.getNVertData(), cube.getNUVData(), cube.getNNormData());
+    {
+      using namespace MeshAttributes;
+      vbo.write(cube.getVertexData(), VERTEX);
+      vbo.setIndices(cube.getIndicesData());
+    }
 
-  shaderPtr->setUniformValue("u_irradianceMap", 0);
-  shaderPtr->setUniformValue("u_prefilterMap", 1);
-  shaderPtr->setUniformValue("u_brdfMap", 2);
-  shaderPtr->setUniformValue("u_albedoMap", 3);
-  shaderPtr->setUniformValue("u_normalMap", 4);
-  shaderPtr->setUniformValue("u_ao", m_ao);
-  shaderPtr->setUniformValue("u_roughness", m_roughness);
-  shaderPtr->setUniformValue("u_metallic", m_metallic);
-  shaderPtr->setUniformValue("u_baseSpec", m_baseSpec);
-  shaderPtr->setUniformValue("u_normalStrength", m_normalStrength);
-  funcs->glUniformSubroutinesuiv(GL_TESS_EVALUATION_SHADER, 1, &m_tessType);
-  shaderPtr->setUniformValue("u_tessLevelInner", m_tessLevelInner);
-  shaderPtr->setUniformValue("u_tessLevelOuter", m_tessLevelOuter);
+    initCaptureMatrices();
+    initSphereMap();
+    // Generate cube map from sphere map
+    // The prefilter reads lower mips for wide samples, so this needs a full chain
+    generateCubeMap(cube, vbo, m_cubeMap, k_cubeMapDim, "shaderPrograms/hdr_cubemap.json", [&sphereMap = m_sphereMap](auto shader)
+    {
+      // convert HDR equirectangular environment map to cubemap equivalent
+      shader->setUniformValue("u_sphereMap", 0);
+      sphereMap->bind(0);
+    }, true);
+    generatePrefilteredMap(cube, vbo, m_prefilteredMap, m_prefilterSamples);
+#ifndef QT_NO_DEBUG
+    reportPrefilterError(cube, vbo);
+#endif
+    saveIblCache(compressPrefilteredMap());
+    // The source maps are only needed for baking
+    m_sphereMap.reset();
+    m_cubeMap.reset();
+  }
+
+  // All of the material parameters live in one block, shared by every stage. The eyes are tinted by
+  // turbulence at the fragment shader's old u_offsetPos, which was always zero, so it never changes
+  m_params.set(&MaterialParams::eyeAlbedo, glm::vec3(0.4f, 0.34f, 0.38f) * OwlNoise::turb(glm::vec3(0.0f), 10.0f));
+  updateEyeTwist();
+  m_params.init(m_context, UniformBindings::MATERIAL);
+  // Diffuse lighting comes from the SH coefficients that were projected or loaded above
+  m_irradianceSH.init(m_context, UniformBindings::IRRADIANCE);
 
 
   m_last = std::chrono::high_resolution_clock::now();
@@ -105,37 +334,97 @@ void MaterialPBR::init()
 
 void MaterialPBR::update()
 {
-  m_irradianceMap->bind(0);
+  // Only the textures that the current mode reads are kept around
+  const bool useVolumes = m_surfaceTextures != SurfaceTextures::ATLAS;
+  const bool useAtlas = m_surfaceTextures != SurfaceTextures::VOLUMES;
+  const bool useTiles = useVolumes && m_volumeTiling != VolumeTiling::BRICKS;
+  const bool useBricks = useVolumes && !useTiles;
+  if (!useBricks && (m_volumes.m_albedo || m_pendingVolumes.m_albedo))
+  {
+    m_volumes = BrickPools();
+    m_pendingVolumes = BrickPools();
+    m_volumesDirty = true;
+    ++m_volumeGeneration;
+  }
+  // The atlases and tiles are cheap enough to bake again from scratch, the volumes are recoloured below
+  if (!useAtlas || m_coloursDirty)
+  {
+    m_albedoAtlas.reset();
+    m_normalAtlas.reset();
+  }
+  if (!useTiles || m_coloursDirty)
+  {
+    m_tile.reset();
+    m_detailTile.reset();
+  }
+  if (m_volumeTiling != VolumeTiling::DETAIL_TILE)
+    m_detailTile.reset();
+  m_coloursDirty = false;
+  // The eyes have been displaced further than our bricks allow for, or the volumes were released
+  if (useBricks && m_volumesDirty)
+    bakeVolumes();
+  if (useTiles)
+    bakeTiles();
+  if (useBricks)
+  {
+    refineVolumes();
+    finishVolumeReadback();
+    finishVolumeEncode();
+  }
+  // Palette edits wait for any bake in progress, which blends the colours it started with
+  if (m_volumes.m_albedo && !m_pendingVolumes.m_albedo && m_volumes.m_colours != m_colours)
+    recolourVolumes();
+  if (useAtlas && !m_albedoAtlas)
+    bakeAtlas();
+
   m_prefilteredMap->bind(1);
   m_brdfMap->bind(2);
-  m_albedoMap->bind(3);
-  m_normalMap->bind(4);
+  if (m_volumes.m_albedo)
+  {
+    m_volumes.m_albedo->bind(3);
+    if (m_volumes.m_normal) m_volumes.m_normal->bind(4);
+    m_volumes.m_indirection->bind(5);
+    (m_volumes.m_height ? m_volumes.m_height : m_volumes.m_albedo)->bind(8);
+  }
+  if (m_tile)
+  {
+    m_tile->bind(3);
+    if (m_detailTile) m_detailTile->bind(9);
+  }
+  if (m_albedoAtlas)
+  {
+    m_albedoAtlas->bind(6);
+    m_normalAtlas->bind(7);
+  }
   m_context->versionFunctions<QOpenGLFunctions_4_3_Core>()->glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, m_morphTargetBuffer.bufferId());
+  // Send any material changes made since the last frame in one go
+  m_params.upload();
+  m_irradianceSH.upload();
+  // Swap to the program variant that matches our current settings
+  if (m_variantDirty)
+    updateVariant();
+  // The levels and ranges only change when the pools do, so every program we've set up is kept current
+  if (m_volumeUniformsDirty && m_volumes.m_albedo)
+  {
+    for (auto program : m_initialisedVariants)
+      setVolumeUniforms(program);
+    m_volumeUniformsDirty = false;
+  }
 
-
-  auto shaderPtr = m_shaderLib->getShader(m_shaderName);
+  // Binding every frame keeps us on the right variant, whatever else was bound in between
+  if (m_activeUsesPipeline)
+    m_shaderLib->usePipeline(m_variantName);
+  else
+    m_shaderLib->useShader(m_variantName);
   using namespace std::chrono;
   auto now = high_resolution_clock::now();
   m_time += (duration_cast<milliseconds>(now - m_last).count() * !m_paused);
   m_last = now;
   const auto blend = std::fmod(m_time * 0.001f * m_morphTargetFPS, static_cast<float>(m_morphTargetCount - 1));
-  shaderPtr->setUniformValue("u_blend", blend);
-  auto eye = m_cam->getCameraEye();
-  shaderPtr->setUniformValue("u_camPos", QVector3D{eye.x, eye.y, eye.z});
-
-  // Scope the using declaration
-  {
-    using namespace SceneMatrices;
-    static constexpr std::array<const char*, 3> shaderUniforms = {{"M", "MVP", "N"}};
-    // Send all our matrices to the GPU
-    for (const auto matrixId : {MODEL_VIEW, PROJECTION, NORMAL})
-    {
-      // Convert from glm to Qt
-      QMatrix4x4 qmat(glm::value_ptr((*m_matrices)[matrixId]));
-      // Need to transpose the matrix as they both use different majors
-      shaderPtr->setUniformValue(shaderUniforms[matrixId], qmat.transposed());
-    }
-  }
+  // Set through the program directly, as pipeline stages are never bound with glUseProgram
+  auto funcs = m_context->versionFunctions<QOpenGLFunctions_4_3_Core>();
+  for (auto program : m_activePrograms)
+    funcs->glProgramUniform1f(program->programId(), program->uniformLocation("u_blend"), blend);
 }
 
 const char* MaterialPBR::shaderFileName() const
@@ -145,48 +434,39 @@ const char* MaterialPBR::shaderFileName() const
 
 void MaterialPBR::setMetallic(const float _metallic) noexcept
 {
-  auto shaderPtr = m_shaderLib->getShader(m_shaderName);
-  m_metallic = _metallic;
-  shaderPtr->setUniformValue("u_metallic", m_metallic);
+  m_params.set(&MaterialParams::metallic, _metallic);
 }
 
-float MaterialPBR::getMetallic() const noexcept { return m_metallic; }
+float MaterialPBR::getMetallic() const noexcept { return m_params.get().metallic; }
 
 void MaterialPBR::setAO(const float _ao) noexcept
 {
-  auto shaderPtr = m_shaderLib->getShader(m_shaderName);
-  m_ao = _ao;
-  shaderPtr->setUniformValue("u_ao", m_ao);
+  m_params.set(&MaterialParams::ao, _ao);
 }
 
-float MaterialPBR::getAO() const noexcept { return m_ao; }
+float MaterialPBR::getAO() const noexcept { return m_params.get().ao; }
 
 void MaterialPBR::setRoughness(const float _roughness) noexcept
 {
-  auto shaderPtr = m_shaderLib->getShader(m_shaderName);
-  m_roughness = _roughness;
-  shaderPtr->setUniformValue("u_roughness", m_roughness);
+  m_params.set(&MaterialParams::roughness, _roughness);
 }
 
-float MaterialPBR::getRoughness() const noexcept { return m_roughness; }
+float MaterialPBR::getRoughness() const noexcept { return m_params.get().roughness; }
 
 void MaterialPBR::setBaseSpec(const float _baseSpec) noexcept
 {
-  auto shaderPtr = m_shaderLib->getShader(m_shaderName);
-  m_baseSpec = _baseSpec;
-  shaderPtr->setUniformValue("u_baseSpec", m_baseSpec);
+  m_params.set(&MaterialParams::baseSpec, _baseSpec);
 }
 
-float MaterialPBR::getBaseSpec() const noexcept { return m_baseSpec; }
+float MaterialPBR::getBaseSpec() const noexcept { return m_params.get().baseSpec; }
 
 void MaterialPBR::setNormalStrength(const float _normalStrength) noexcept
 {
-  auto shaderPtr = m_shaderLib->getShader(m_shaderName);
-  m_normalStrength = _normalStrength;
-  shaderPtr->setUniformValue("u_normalStrength", m_normalStrength);
+  m_params.set(&MaterialParams::normalStrength, _normalStrength);
+  m_variantDirty = true;
 }
 
-float MaterialPBR::getNormalStrength() const noexcept { return m_normalStrength; }
+float MaterialPBR::getNormalStrength() const noexcept { return m_params.get().normalStrength; }
 
 void MaterialPBR::setPaused(const bool _paused) noexcept { m_paused = _paused; }
 
@@ -195,119 +475,102 @@ bool MaterialPBR::getPaused() const noexcept { return m_paused; }
 void MaterialPBR::setTessType(const int _tessType) noexcept
 {
   m_tessType = static_cast<GLuint>(_tessType);
-  m_context->versionFunctions<QOpenGLFunctions_4_3_Core>()->glUniformSubroutinesuiv(GL_TESS_EVALUATION_SHADER, 1, &m_tessType);
+  m_variantDirty = true;
 }
 
 void MaterialPBR::setTessLevelInner(const int _tessLevel) noexcept
 {
-  auto shaderPtr = m_shaderLib->getShader(m_shaderName);
-  m_tessLevelInner = _tessLevel - 1;
-  shaderPtr->setUniformValue("u_tessLevelInner", m_tessLevelInner);
+  m_params.set(&MaterialParams::tessLevelInner, _tessLevel - 1);
 }
 
-int MaterialPBR::getTessLevelInner() const noexcept { return m_tessLevelInner; }
+int MaterialPBR::getTessLevelInner() const noexcept { return m_params.get().tessLevelInner; }
 
 void MaterialPBR::setTessLevelOuter(const int _tessLevel) noexcept
 {
-  auto shaderPtr = m_shaderLib->getShader(m_shaderName);
-  m_tessLevelOuter = _tessLevel - 1;
-  shaderPtr->setUniformValue("u_tessLevelOuter", m_tessLevelOuter);
+  m_params.set(&MaterialParams::tessLevelOuter, _tessLevel - 1);
 }
 
-int MaterialPBR::getTessLevelOuter() const noexcept { return m_tessLevelOuter; }
+int MaterialPBR::getTessLevelOuter() const noexcept { return m_params.get().tessLevelOuter; }
 
 void  MaterialPBR::setEyeDisp(const float _eyeDisp) noexcept
 {
-  auto shaderPtr = m_shaderLib->getShader(m_shaderName);
-  m_eyeDisp = _eyeDisp;
-  shaderPtr->setUniformValue("u_eyeDisp", m_eyeDisp);
+  m_params.set(&MaterialParams::eyeDisp, _eyeDisp);
+  const float disp = _eyeDisp * k_maxEyeHeight;
+  if (disp < std::min(m_volumeDisp, 0.0f) || disp > std::max(m_volumeDisp, 0.0f))
+    m_volumesDirty = true;
 }
 
-float MaterialPBR::getEyeDisp() const noexcept { return m_eyeDisp; }
+float MaterialPBR::getEyeDisp() const noexcept { return m_params.get().eyeDisp; }
+void  MaterialPBR::setVolumeBakeBudget(const float _milliseconds) noexcept
+{
+  m_volumeBakeBudget = std::max(_milliseconds, 0.0f);
+}
+float MaterialPBR::getVolumeBakeBudget() const noexcept { return m_volumeBakeBudget; }
 void  MaterialPBR::setEyeScale(const float _eyeScale) noexcept
 {
-  auto shaderPtr = m_shaderLib->getShader(m_shaderName);
-  m_eyeScale = _eyeScale;
-  shaderPtr->setUniformValue("u_eyeScale", m_eyeScale);
+  m_params.set(&MaterialParams::eyeScale, _eyeScale);
 }
 
-float MaterialPBR::getEyeScale() const noexcept { return m_eyeScale; }
+float MaterialPBR::getEyeScale() const noexcept { return m_params.get().eyeScale; }
 
 void MaterialPBR::setEyeTranslate(const glm::vec3 _eyeTranslate) noexcept
 {
-  auto shaderPtr = m_shaderLib->getShader(m_shaderName);
-  m_eyeTranslate = _eyeTranslate;
-  shaderPtr->setUniformValue("u_eyeTranslate", QVector3D{m_eyeTranslate.x, m_eyeTranslate.y, m_eyeTranslate.z});
+  m_params.set(&MaterialParams::eyeTranslate, _eyeTranslate);
 }
 
-glm::vec3 MaterialPBR::getEyeTranslate() const noexcept { return m_eyeTranslate; }
+glm::vec3 MaterialPBR::getEyeTranslate() const noexcept { return m_params.get().eyeTranslate; }
 
 void  MaterialPBR::setEyeRotation(const float _eyeRotation) noexcept
 {
-  auto shaderPtr = m_shaderLib->getShader(m_shaderName);
-  m_eyeRotation = _eyeRotation;
-  shaderPtr->setUniformValue("u_eyeRotation", m_eyeRotation);
+  m_params.set(&MaterialParams::eyeRotation, _eyeRotation);
+  updateEyeTwist();
 }
 
-float MaterialPBR::getEyeRotation() const noexcept { return m_eyeRotation; }
+float MaterialPBR::getEyeRotation() const noexcept { return m_params.get().eyeRotation; }
 void  MaterialPBR::setEyeWarp(const float _eyeWarp) noexcept
 {
-  auto shaderPtr = m_shaderLib->getShader(m_shaderName);
-  m_eyeWarp = _eyeWarp;
-  shaderPtr->setUniformValue("u_eyeWarp", m_eyeWarp);
+  m_params.set(&MaterialParams::eyeWarp, _eyeWarp);
 }
 
-float MaterialPBR::getEyeWarp() const noexcept { return m_eyeWarp; }
+float MaterialPBR::getEyeWarp() const noexcept { return m_params.get().eyeWarp; }
 void  MaterialPBR::setEyeExponent(const float _eyeExp) noexcept
 {
-  auto shaderPtr = m_shaderLib->getShader(m_shaderName);
-  m_eyeExponent = _eyeExp;
-  shaderPtr->setUniformValue("u_eyeExponent", m_eyeExponent);
+  m_params.set(&MaterialParams::eyeExponent, _eyeExp);
 }
 
-float MaterialPBR::getEyeExponent() const noexcept { return m_eyeExponent; }
+float MaterialPBR::getEyeExponent() const noexcept { return m_params.get().eyeExponent; }
 void  MaterialPBR::setEyeThickness(const float _eyeThickness) noexcept
 {
-  auto shaderPtr = m_shaderLib->getShader(m_shaderName);
-  m_eyeThickness = _eyeThickness;
-  shaderPtr->setUniformValue("u_eyeThickness", m_eyeThickness);
+  m_params.set(&MaterialParams::eyeThickness, _eyeThickness);
 }
 
-float MaterialPBR::getEyeThickness() const noexcept { return m_eyeThickness; }
+float MaterialPBR::getEyeThickness() const noexcept { return m_params.get().eyeThickness; }
 void  MaterialPBR::setEyeGap(const float _eyeGap) noexcept
 {
-  auto shaderPtr = m_shaderLib->getShader(m_shaderName);
-  m_eyeGap = _eyeGap;
-  shaderPtr->setUniformValue("u_eyeGap", m_eyeGap);
+  m_params.set(&MaterialParams::eyeGap, _eyeGap);
 }
 
-float MaterialPBR::getEyeGap() const noexcept { return m_eyeGap; }
+float MaterialPBR::getEyeGap() const noexcept { return m_params.get().eyeGap; }
 void  MaterialPBR::setEyeFuzz(const float _eyeFuzz) noexcept
 {
-  auto shaderPtr = m_shaderLib->getShader(m_shaderName);
-  m_eyeFuzz = _eyeFuzz;
-  shaderPtr->setUniformValue("u_eyeFuzz", m_eyeFuzz);
+  m_params.set(&MaterialParams::eyeFuzz, _eyeFuzz);
 }
 
-float MaterialPBR::getEyeFuzz() const noexcept { return m_eyeFuzz; }
+float MaterialPBR::getEyeFuzz() const noexcept { return m_params.get().eyeFuzz; }
 
 void  MaterialPBR::setEyeMaskCap(const float _eyeMaskCap) noexcept
 {
-  auto shaderPtr = m_shaderLib->getShader(m_shaderName);
-  m_eyeMaskCap = _eyeMaskCap;
-  shaderPtr->setUniformValue("u_eyeMaskCap", m_eyeMaskCap);
+  m_params.set(&MaterialParams::eyeMaskCap, _eyeMaskCap);
 }
 
-float MaterialPBR::getEyeMaskCap() const noexcept { return m_eyeMaskCap; }
+float MaterialPBR::getEyeMaskCap() const noexcept { return m_params.get().eyeMaskCap; }
 
 void  MaterialPBR::setTessMaskCap(const float _tessMaskCap) noexcept
 {
-  auto shaderPtr = m_shaderLib->getShader(m_shaderName);
-  m_tessMaskCap = _tessMaskCap;
-  shaderPtr->setUniformValue("u_tessMaskCap", m_tessMaskCap);
+  m_params.set(&MaterialParams::tessMaskCap, _tessMaskCap);
 }
 
-float MaterialPBR::getTessMaskCap() const noexcept  { return m_tessMaskCap; }
+float MaterialPBR::getTessMaskCap() const noexcept  { return m_params.get().tessMaskCap; }
 
 int MaterialPBR::getTessType() const noexcept
 {
@@ -316,12 +579,33 @@ int MaterialPBR::getTessType() const noexcept
 
 void  MaterialPBR::setPhongStrength(const float _strength) noexcept
 {
-  auto shaderPtr = m_shaderLib->getShader(m_shaderName);
-  m_phongStrength = _strength;
-  shaderPtr->setUniformValue("u_phong_strength", m_phongStrength);
+  m_params.set(&MaterialParams::phongStrength, _strength);
 }
 
-float MaterialPBR::getPhongStrength() const noexcept { return m_phongStrength; }
+float MaterialPBR::getPhongStrength() const noexcept { return m_params.get().phongStrength; }
+
+void MaterialPBR::setPrefilterSamples(const unsigned _samples) noexcept
+{
+  m_prefilterSamples = std::max(_samples, 1u);
+}
+
+unsigned MaterialPBR::getPrefilterSamples() const noexcept { return m_prefilterSamples; }
+
+void MaterialPBR::setColour(const size_t _index, const glm::vec3 &_colour) noexcept
+{
+  if (_index >= m_colours.size()) return;
+  m_colours[_index] = QVector4D(_colour.x, _colour.y, _colour.z, m_colours[_index].w());
+  m_coloursDirty = true;
+}
+
+glm::vec3 MaterialPBR::getColour(const size_t _index) const noexcept
+{
+  if (_index >= m_colours.size()) return glm::vec3(0.0f);
+  const auto& colour = m_colours[_index];
+  return glm::vec3(colour.x(), colour.y(), colour.z());
+}
+
+size_t MaterialPBR::colourCount() const noexcept { return m_colours.size(); }
 
 void MaterialPBR::initTargets(const std::string &_posePath, const unsigned _framePad)
 {
@@ -372,23 +656,221 @@ void MaterialPBR::initTargets(const std::string &_posePath, const unsigned _fram
   std::memcpy(p, allData.data(), data_size);
   m_morphTargetBuffer.unmap();
 
-  auto shaderPtr = m_shaderLib->getShader(m_shaderName);
-  auto progID = shaderPtr->programId();
+  funcs->glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, m_morphTargetBuffer.bufferId());
+
+  // Stored so that every program variant can be given them
+  m_morphTargetSize = static_cast<int>(targets[0].getNVerts());
+  m_morphTargetNormalOffset = static_cast<int>(normOffset);
+}
+
+void MaterialPBR::initProgram(QOpenGLShaderProgram* io_shader)
+{
+  auto funcs = m_context->versionFunctions<QOpenGLFunctions_4_3_Core>();
+  auto progID = io_shader->programId();
   GLuint block_index = funcs->glGetProgramResourceIndex(progID, GL_SHADER_STORAGE_BLOCK, "morph_targets");
-  GLuint bindingPoint = 0;
-  funcs->glShaderStorageBlockBinding(progID, block_index, bindingPoint);
-  funcs->glBindBufferBase(GL_SHADER_STORAGE_BUFFER, bindingPoint, m_morphTargetBuffer.bufferId());
+  if (block_index != GL_INVALID_INDEX)
+    funcs->glShaderStorageBlockBinding(progID, block_index, 0);
+
+  io_shader->setPatchVertexCount(3);
+
+  // Separable stage programs only contain some of these, missing uniforms have a location of -1 which
+  // GL ignores
+  const std::pair<const char*, int> intUniforms[] = {
+    {"u_prefilterMap", 1},
+    {"u_brdfMap", 2},
+    {"u_albedoMap", 3},
+    {"u_normalMap", 4},
+    {"u_brickIndirection", 5},
+    {"u_albedoAtlas", 6},
+    {"u_normalAtlas", 7},
+    {"u_heightMap", 8},
+    {"u_detailMap", 9},
+    {"u_morph_target_size", m_morphTargetSize},
+    {"u_morph_target_normal_offset", m_morphTargetNormalOffset}
+  };
+  for (const auto& uniform : intUniforms)
+    funcs->glProgramUniform1i(progID, io_shader->uniformLocation(uniform.first), uniform.second);
+  // The tiles never change size, so the normals derived from them are scaled to the full volume once
+  funcs->glProgramUniform2f(
+        progID,
+        io_shader->uniformLocation("u_tileRepeats"),
+        static_cast<float>(k_tileRepeats),
+        static_cast<float>(k_detailTileRepeats)
+        );
+  funcs->glProgramUniform2f(
+        progID,
+        io_shader->uniformLocation("u_tileTexelSizes"),
+        static_cast<float>(k_volumeDim) / (k_tileDim * k_tileRepeats),
+        static_cast<float>(k_volumeDim) / (k_detailTileDim * k_detailTileRepeats)
+        );
+  if (m_volumes.m_albedo)
+    setVolumeUniforms(io_shader);
+  m_initialisedVariants.insert(io_shader);
+}
 
+void MaterialPBR::updateVariant()
+{
+  std::vector<std::string> keys;
+  if (m_tessType == 0) keys.push_back("FLAT_TESS");
+  if (m_params.get().normalStrength == 0.0f) keys.push_back("NO_NORMAL_MAP");
+  if (m_surfaceTextures == SurfaceTextures::ATLAS) keys.push_back("SURFACE_ATLAS");
+  if (m_surfaceTextures == SurfaceTextures::ATLAS_DIFF) keys.push_back("ATLAS_DIFF");
+  // Tiles always derive their normals, so they have no need for the key
+  const bool tiled = m_surfaceTextures != SurfaceTextures::ATLAS && m_volumeTiling != VolumeTiling::BRICKS;
+  if (tiled) keys.push_back(m_volumeTiling == VolumeTiling::TILE ? "TILED_VOLUMES" : "DETAIL_TILE");
+  if (m_deriveNormals && m_surfaceTextures != SurfaceTextures::ATLAS && !tiled) keys.push_back("DERIVED_NORMALS");
+
+  const auto submit = [this, &keys](const bool _pipeline, const unsigned _stages)
+  {
+    return _pipeline ?
+          m_shaderLib->submitPipeline(m_shaderName, keys, _stages) :
+          m_shaderLib->submitVariant(m_shaderName, keys, _stages);
+  };
+  const auto variantName = submit(m_usePipelines, m_stages);
+  // The variants that P and T switch to are compiled in the background, so those toggles rarely stall.
+  // Anything further away falls back on the current variant until it's ready
+  submit(!m_usePipelines, m_stages);
+  submit(m_usePipelines, m_stages ^ ShaderLib::TESSELLATION_STAGES);
+  // Keep drawing with the current variant while the new one compiles, and try again next frame. The
+  // first variant has nothing to fall back on, so that one is waited for
+  if (!m_variantName.empty() && !m_shaderLib->isReady(variantName)) return;
+
+  m_variantName = variantName;
+  m_activeStages = m_stages;
+  m_activeUsesPipeline = m_usePipelines;
+  if (m_activeUsesPipeline)
+    m_activePrograms = m_shaderLib->getPipelineStages(m_variantName);
+  else
+    m_activePrograms = {m_shaderLib->getShader(m_variantName)};
+  for (auto program : m_activePrograms)
+  {
+    if (!m_initialisedVariants.count(program))
+      initProgram(program);
+  }
+  m_variantDirty = false;
+}
 
-  shaderPtr->bind();
-  shaderPtr->setUniformValue("u_morph_target_size", static_cast<int>(targets[0].getNVerts()));
-  shaderPtr->setUniformValue("u_morph_target_normal_offset", static_cast<int>(normOffset));
+void MaterialPBR::updateEyeTwist()
+{
+  // rotationMatrix3d about z, the shaders transpose it for the second eye
+  const float rotation = glm::radians(m_params.get().eyeRotation);
+  const float s = std::sin(rotation);
+  const float c = std::cos(rotation);
+  m_params.set(&MaterialParams::eyeTwist, std::array<glm::vec4, 3> {{
+                 {   c,   -s, 0.0f, 0.0f},
+                 {   s,    c, 0.0f, 0.0f},
+                 {0.0f, 0.0f, 1.0f, 0.0f}
+               }});
+}
+
+void MaterialPBR::handleKey(QKeyEvent* io_event, QOpenGLContext*)
+{
+  // Used to compare program variants, toggling stages with pipelines should never stall on a link
+  switch (io_event->key())
+  {
+    case Qt::Key_P : m_usePipelines = !m_usePipelines; break;
+    case Qt::Key_T : m_stages ^= ShaderLib::TESSELLATION_STAGES; break;
+    case Qt::Key_U :
+      m_surfaceTextures = static_cast<SurfaceTextures>((static_cast<int>(m_surfaceTextures) + 1) % 3);
+      break;
+    case Qt::Key_R :
+      // The pools are released while tiled, and come back from the cache or a fresh bake afterwards
+      m_volumeTiling = static_cast<VolumeTiling>((static_cast<int>(m_volumeTiling) + 1) % 3);
+      break;
+    case Qt::Key_N :
+      // The pools are rebuilt with or without the normals, the albedo will usually come from the cache
+      m_deriveNormals = !m_deriveNormals;
+      m_volumesDirty = true;
+      break;
+    case Qt::Key_C :
+      // Compressed and uncompressed pools are cached under different keys, so both can be compared
+      m_compressVolumes = !m_compressVolumes;
+      m_volumesDirty = true;
+      break;
+    default : return;
+  }
+  m_variantDirty = true;
+}
+
+GLenum MaterialPBR::primitiveType() const noexcept
+{
+  // The stages of the variant being drawn with, which lag behind m_stages while a new one compiles
+  return (m_activeStages & ShaderLib::TESSELLATION_STAGES) ? GL_PATCHES : GL_TRIANGLES;
+}
+
+std::string MaterialPBR::iblCacheKey() const
+{
+  uint64_t hash = 0;
+  if (!HashUtils::fnv1aFile(k_envMapPath, hash)) return "";
+  // Any change to the bake settings must produce a new key
+  const std::string settings = std::to_string(k_iblBakeVersion) + ' ' +
+      std::to_string(k_cubeMapDim) + ' ' +
+      std::to_string(k_prefilterDim) + ' ' +
+      std::to_string(m_prefilterSamples);
+  return HashUtils::toHex(HashUtils::fnv1a(settings, hash));
+}
+
+bool MaterialPBR::loadIblCache()
+{
+  m_iblCacheKey = iblCacheKey();
+  if (m_iblCacheKey.empty()) return false;
+
+  const auto prefix = k_iblCacheDir + m_iblCacheKey;
+  TextureFile prefiltered;
+  IrradianceSH irradiance;
+  if (!SphericalHarmonics::load(prefix + "_sh9.bin", irradiance) ||
+      !prefiltered.load(prefix + "_prefilter.tex"))
+    return false;
+
+  using tex = QOpenGLTexture;
+  m_irradianceSH.reset(irradiance);
+
+  TextureIO::upload(prefiltered, m_prefilteredMap);
+  m_prefilteredMap->setMinMagFilters(tex::LinearMipMapLinear, tex::Linear);
+  m_prefilteredMap->setWrapMode(tex::ClampToEdge);
+  return true;
+}
+
+bool MaterialPBR::loadBrdfLUT()
+{
+  TextureFile lut;
+  if (!lut.load(BrdfLut::k_assetPath)) return false;
+
+  using tex = QOpenGLTexture;
+  TextureIO::upload(lut, m_brdfMap);
+  m_brdfMap->setMinMagFilters(tex::Linear, tex::Linear);
+  m_brdfMap->setWrapMode(tex::ClampToEdge);
+  return true;
+}
+
+void MaterialPBR::saveIblCache(const TextureFile &_prefiltered)
+{
+  if (m_iblCacheKey.empty()) return;
+
+  const auto prefix = k_iblCacheDir + m_iblCacheKey;
+  SphericalHarmonics::save(prefix + "_sh9.bin", m_irradianceSH.get());
+  _prefiltered.save(prefix + "_prefilter.tex");
+}
+
+TextureFile MaterialPBR::compressPrefilteredMap()
+{
+  // Our environment maps are RGB16F, so we read back halfs to avoid any conversion
+  using tex = QOpenGLTexture;
+  auto& pool = ThreadPool::instance();
+  const auto prefiltered = TextureIO::download(m_context, *m_prefilteredMap, tex::RGB, tex::Float16, 6);
+  auto compressed = BlockCompression::encode(prefiltered, pool);
+  const auto error = BlockCompression::measure(compressed, prefiltered, {}, pool);
+  reportCompression("prefilter", textureBytes(prefiltered), textureBytes(compressed), error);
+
+  TextureIO::upload(compressed, m_prefilteredMap);
+  m_prefilteredMap->setMinMagFilters(tex::LinearMipMapLinear, tex::Linear);
+  m_prefilteredMap->setWrapMode(tex::ClampToEdge);
+  return compressed;
 }
 
 void MaterialPBR::initCaptureMatrices()
 {
-  glm::mat4 captureProjectionGLM = glm::perspective(glm::radians(90.0f), 1.0f, 0.1f, 10.0f);
-  m_captureProjection = QMatrix4x4(glm::value_ptr(captureProjectionGLM)).transposed();
+  glm::mat4 captureProjection = glm::perspective(glm::radians(90.0f), 1.0f, 0.1f, 10.0f);
   glm::mat4 captureViews[] =
   {
     glm::lookAt(glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3( 1.0f,  0.0f,  0.0f), glm::vec3(0.0f, -1.0f,  0.0f)),
@@ -400,19 +882,84 @@ void MaterialPBR::initCaptureMatrices()
   };
   for (unsigned int i = 0; i < 6; ++i)
   {
-    // Convert from glm to Qt
-    QMatrix4x4 view(glm::value_ptr(captureViews[i]));
-    m_captureViews[i] = view.transposed();
+    // Convert from glm to Qt, both use different majors so we transpose
+    QMatrix4x4 viewProjection(glm::value_ptr(captureProjection * captureViews[i]));
+    m_captureViewProjections[i] = viewProjection.transposed();
+  }
+}
+
+void MaterialPBR::beginSphereMapLoad()
+{
+  // Files we can't decode ourselves are left for stb_image in initSphereMap
+  if (!HdrImage::readInfo(k_envMapPath, m_sphereMapInfo)) return;
+
+  // Decode straight into a mapped pixel buffer, so the texture upload is a GPU side copy
+  const auto size = static_cast<size_t>(m_sphereMapInfo.m_width) * static_cast<size_t>(m_sphereMapInfo.m_height) * 4 * sizeof(uint16_t);
+  auto funcs = m_context->versionFunctions<QOpenGLFunctions_4_3_Core>();
+  m_sphereMapPBO.create();
+  m_sphereMapPBO.bind();
+  m_sphereMapPBO.setUsagePattern(QOpenGLBuffer::StreamDraw);
+  m_sphereMapPBO.allocate(static_cast<int>(size));
+  auto pixels = static_cast<uint16_t*>(funcs->glMapBufferRange(
+        GL_PIXEL_UNPACK_BUFFER, 0, static_cast<GLsizeiptr>(size), GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT
+        ));
+  m_sphereMapPBO.release();
+  if (!pixels)
+  {
+    m_sphereMapPBO.destroy();
+    return;
   }
+
+  // The buffer stays mapped until initSphereMap, so the loader thread never needs a GL context
+  m_sphereMapDecoded = false;
+  m_sphereMapLoad = ThreadPool::instance().submit([this, pixels]
+  {
+    auto& pool = ThreadPool::instance();
+    if (!HdrImage::loadRGBA16F(k_envMapPath, m_sphereMapInfo, pixels, pool)) return;
+    // Project the diffuse irradiance while the decoded image is still warm in the cache
+    m_loadedIrradiance = SphericalHarmonics::projectEquirect(pixels, m_sphereMapInfo.m_width, m_sphereMapInfo.m_height, 4, pool);
+    SphericalHarmonics::convolveIrradiance(m_loadedIrradiance);
+    m_sphereMapDecoded = true;
+  });
 }
 
 void MaterialPBR::initSphereMap()
 {
+  using tex = QOpenGLTexture;
+  if (m_sphereMapLoad.valid())
+  {
+    m_sphereMapLoad.get();
+    auto funcs = m_context->versionFunctions<QOpenGLFunctions_4_3_Core>();
+    m_sphereMapPBO.bind();
+    funcs->glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+    if (m_sphereMapDecoded)
+    {
+      m_irradianceSH.reset(m_loadedIrradiance);
+      m_sphereMap.reset(new QOpenGLTexture(QOpenGLTexture::Target2D));
+      m_sphereMap->create();
+      m_sphereMap->bind();
+      m_sphereMap->setSize(m_sphereMapInfo.m_width, m_sphereMapInfo.m_height);
+      m_sphereMap->setFormat(tex::RGBA16F);
+      m_sphereMap->allocateStorage(tex::RGBA, tex::Float16);
+      // With the pixel buffer bound, the data pointer is an offset into it
+      funcs->glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, m_sphereMapInfo.m_width, m_sphereMapInfo.m_height, GL_RGBA, GL_HALF_FLOAT, nullptr);
+      m_sphereMap->setWrapMode(tex::ClampToEdge);
+      m_sphereMap->setMinMagFilters(tex::Linear, tex::Linear);
+    }
+    m_sphereMapPBO.release();
+    m_sphereMapPBO.destroy();
+    if (m_sphereMapDecoded) return;
+  }
+
   stbi_set_flip_vertically_on_load(true);
   int width, height, nrComponents;
-  float *data = stbi_loadf("images/Alexs_Apt_2k.hdr", &width, &height, &nrComponents, 0);
+  float *data = stbi_loadf(k_envMapPath, &width, &height, &nrComponents, 0);
   const float* cdata = data;
-  using tex = QOpenGLTexture;
+  // Project the diffuse irradiance on the CPU while we have the decoded image
+  auto irradiance = SphericalHarmonics::projectEquirect(cdata, width, height, nrComponents, ThreadPool::instance());
+  SphericalHarmonics::convolveIrradiance(irradiance);
+  m_irradianceSH.reset(irradiance);
+
   m_sphereMap.reset(new QOpenGLTexture(QOpenGLTexture::Target2D));
   m_sphereMap->create();
   m_sphereMap->bind();
@@ -432,75 +979,76 @@ void MaterialPBR::generateCubeMap(
     std::unique_ptr<QOpenGLTexture> &_texture,
     const int _dim,
     const std::string &_matPath,
-    const std::function<void (QOpenGLShaderProgram* io_prog)> &_prerender
+    const std::function<void (QOpenGLShaderProgram* io_prog)> &_prerender,
+    const bool _mipmapped
     )
 {
   using tex = QOpenGLTexture;
-  auto defaultFBO = m_context->defaultFramebufferObject();
   auto shaderName = m_shaderLib->loadShaderProg(_matPath.c_str());
   auto shader = m_shaderLib->getShader(shaderName);
   auto funcs = m_context->versionFunctions<QOpenGLFunctions_4_3_Core>();
 
-  auto fbo = std::make_unique<QOpenGLFramebufferObject>(_dim, _dim, QOpenGLFramebufferObject::Depth);
-
   _texture.reset(new QOpenGLTexture(QOpenGLTexture::TargetCubeMap));
   _texture->create();
   _texture->bind(0);
   _texture->setSize(_dim, _dim);
   _texture->setFormat(tex::RGB16F);
+  if (_mipmapped)
+    _texture->setMipLevels(_texture->maximumMipLevels());
   _texture->allocateStorage();
-  _texture->setMinMagFilters(tex::Linear, tex::Linear);
+  _texture->setMinMagFilters(_mipmapped ? tex::LinearMipMapLinear : tex::Linear, tex::Linear);
   _texture->setWrapMode(tex::ClampToEdge);
 
+  shader->bind();
+  shader->setUniformValueArray("u_faceVP", m_captureViewProjections.data(), 6);
   _prerender(shader);
 
-  // don't forget to configure the viewport to the capture dimensions.
-  funcs->glViewport(0, 0, _dim, _dim);
-  fbo->bind();
   {
     using namespace MeshAttributes;
     shader->enableAttributeArray(VERTEX);
     shader->setAttributeBuffer(VERTEX, GL_FLOAT, _vbo.offset(VERTEX), 3);
   }
 
-  for (unsigned int i = 0; i < 6; ++i)
-  {
-    // Need to transpose the matrix as they both use different majors
-    shader->setUniformValue("u_MV", m_captureViews[i]);
-    funcs->glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, _texture->textureId(), 0);
-    funcs->glClearColor(0.f, 0.f, 0.f, 1.f);
-    funcs->glClear(GL_COLOR_BUFFER_BIT |GL_DEPTH_BUFFER_BIT);
+  // All six faces are attached as layers, the geometry shader routes each triangle to every face
+  m_bakeTargets.bindTarget(_texture->textureId(), 0, _dim, _dim);
+  funcs->glClearColor(0.f, 0.f, 0.f, 1.f);
+  funcs->glClear(GL_COLOR_BUFFER_BIT);
+  funcs->glDrawElements(GL_TRIANGLES, _cube.getNIndicesData(), GL_UNSIGNED_SHORT, nullptr);
+  m_bakeTargets.releaseTarget();
 
-    funcs->glDrawElements(GL_TRIANGLES, _cube.getNIndicesData(), GL_UNSIGNED_SHORT, nullptr);
-  }
-  funcs->glBindFramebuffer(GL_FRAMEBUFFER, defaultFBO);
-  fbo->release();
+  if (_mipmapped)
+    _texture->generateMipMaps();
 }
 
-void MaterialPBR::initPrefilteredMap(const TriMesh &_cube, const MeshVBO &_vbo)
+void MaterialPBR::generatePrefilteredMap(
+    const TriMesh &_cube,
+    const MeshVBO &_vbo,
+    std::unique_ptr<QOpenGLTexture> &o_texture,
+    const unsigned _samples
+    )
 {
   using tex = QOpenGLTexture;
-  auto defaultFBO = m_context->defaultFramebufferObject();
   auto funcs = m_context->versionFunctions<QOpenGLFunctions_4_3_Core>();
 
-  m_prefilteredMap.reset(new QOpenGLTexture(QOpenGLTexture::TargetCubeMap));
-  m_prefilteredMap->create();
-  m_prefilteredMap->bind(0);
-  m_prefilteredMap->setSize(128, 128);
-  m_prefilteredMap->setFormat(tex::RGB16F);
-  m_prefilteredMap->setMinMagFilters(tex::LinearMipMapLinear, tex::Linear);
-  m_prefilteredMap->setWrapMode(tex::ClampToEdge);
-  m_prefilteredMap->setMipLevels(4);
-  m_prefilteredMap->setMipMaxLevel(4);
-  m_prefilteredMap->allocateStorage();
-  m_prefilteredMap->generateMipMaps();
-  //  m_prefilteredMap->setAutoMipMapGenerationEnabled(true);
+  o_texture.reset(new QOpenGLTexture(QOpenGLTexture::TargetCubeMap));
+  o_texture->create();
+  o_texture->bind(0);
+  o_texture->setSize(k_prefilterDim, k_prefilterDim);
+  o_texture->setFormat(tex::RGB16F);
+  o_texture->setMinMagFilters(tex::LinearMipMapLinear, tex::Linear);
+  o_texture->setWrapMode(tex::ClampToEdge);
+  // Every level is rendered below, so there is no need to generate mipmaps
+  o_texture->setMipLevels(k_prefilterMips);
+  o_texture->setMipMaxLevel(k_prefilterMips - 1);
+  o_texture->allocateStorage();
 
   auto prefilterShaderName = m_shaderLib->loadShaderProg("shaderPrograms/hdr_cubemap_prefilter.json");
   auto prefilterShader = m_shaderLib->getShader(prefilterShaderName);
   prefilterShader->bind();
   prefilterShader->setUniformValue("u_envMap", 0);
-  prefilterShader->setUniformValue("u_P", m_captureProjection);
+  prefilterShader->setUniformValueArray("u_faceVP", m_captureViewProjections.data(), 6);
+  prefilterShader->setUniformValue("u_sampleCount", static_cast<GLuint>(_samples));
+  prefilterShader->setUniformValue("u_envResolution", static_cast<float>(k_cubeMapDim));
 
   m_cubeMap->bind(0);
   {
@@ -508,41 +1056,54 @@ void MaterialPBR::initPrefilteredMap(const TriMesh &_cube, const MeshVBO &_vbo)
     prefilterShader->enableAttributeArray(VERTEX);
     prefilterShader->setAttributeBuffer(VERTEX, GL_FLOAT, _vbo.offset(VERTEX), 3);
   }
-  int maxMipLevels = 5;
-  for (int mip = 0; mip < maxMipLevels; ++mip)
+  for (int mip = 0; mip < k_prefilterMips; ++mip)
   {
-    // reisze framebuffer according to mip-level size.
-    auto mipRes  = static_cast<int>(128 * std::pow(0.5f, mip));
-    auto fbo = std::make_unique<QOpenGLFramebufferObject>(mipRes, mipRes, QOpenGLFramebufferObject::Depth);
-    fbo->bind();
-    //    funcs->glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, mipWidth, mipHeight);
-    funcs->glViewport(0, 0, mipRes, mipRes);
+    // One layered draw per level, reusing the same framebuffer throughout
+    const auto mipRes = std::max(k_prefilterDim >> mip, 1);
+    m_bakeTargets.bindTarget(o_texture->textureId(), mip, mipRes, mipRes);
 
-    float roughness = static_cast<float>(mip) / static_cast<float>(maxMipLevels - 1);
+    float roughness = static_cast<float>(mip) / static_cast<float>(k_prefilterMips - 1);
     prefilterShader->setUniformValue("u_roughness", roughness);
-    for (unsigned int i = 0; i < 6; ++i)
-    {
-      prefilterShader->setUniformValue("u_MV", m_captureViews[i]);
-      funcs->glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, m_prefilteredMap->textureId(), mip);
-      funcs->glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-      funcs->glDrawElements(GL_TRIANGLES, _cube.getNIndicesData(), GL_UNSIGNED_SHORT, nullptr);
-    }
-    funcs->glBindFramebuffer(GL_FRAMEBUFFER, defaultFBO);
-    fbo->release();
+    funcs->glClear(GL_COLOR_BUFFER_BIT);
+    funcs->glDrawElements(GL_TRIANGLES, _cube.getNIndicesData(), GL_UNSIGNED_SHORT, nullptr);
+    m_bakeTargets.releaseTarget();
+  }
+}
+
+void MaterialPBR::reportPrefilterError(const TriMesh &_cube, const MeshVBO &_vbo)
+{
+  std::unique_ptr<QOpenGLTexture> reference;
+  generatePrefilteredMap(_cube, _vbo, reference, k_referencePrefilterSamples);
+
+  // Compare in full float precision, so the readback doesn't hide any error
+  using tex = QOpenGLTexture;
+  const auto test = TextureIO::download(m_context, *m_prefilteredMap, tex::RGB, tex::Float32, 12);
+  const auto truth = TextureIO::download(m_context, *reference, tex::RGB, tex::Float32, 12);
+  for (uint32_t level = 0; level < test.header().m_levels; ++level)
+  {
+    // All faces of a level are stored together
+    const auto count = test.faceSize(level) * test.header().m_faces / sizeof(float);
+    const auto error = ImageMetrics::compare(
+          reinterpret_cast<const float*>(test.data(level)),
+          reinterpret_cast<const float*>(truth.data(level)),
+          count
+          );
+    report("Prefilter level ", level, ", ", m_prefilterSamples, " vs ", k_referencePrefilterSamples,
+           " samples: relative RMSE ", error.m_relativeRmse, ", PSNR ", error.m_psnr, " dB");
   }
 }
 
 void MaterialPBR::initBrdfLUTMap(const TriMesh &_plane, const MeshVBO &_vbo)
 {
   using tex = QOpenGLTexture;
-  auto defaultFBO = m_context->defaultFramebufferObject();
   auto funcs = m_context->versionFunctions<QOpenGLFunctions_4_3_Core>();
 
   m_brdfMap.reset(new QOpenGLTexture(QOpenGLTexture::Target2D));
   m_brdfMap->create();
   m_brdfMap->bind();
-  m_brdfMap->setSize(512, 512);
-  m_brdfMap->setFormat(tex::RGB16F);
+  m_brdfMap->setSize(k_brdfDim, k_brdfDim);
+  // The shader only writes scale and bias
+  m_brdfMap->setFormat(tex::RG16F);
   m_brdfMap->setMinMagFilters(tex::Linear, tex::Linear);
   m_brdfMap->setWrapMode(tex::ClampToEdge);
   m_brdfMap->allocateStorage();
@@ -550,8 +1111,6 @@ void MaterialPBR::initBrdfLUTMap(const TriMesh &_plane, const MeshVBO &_vbo)
   auto brdfLUTShaderName = m_shaderLib->loadShaderProg("shaderPrograms/hdr_cubemap_brdf.json");
   auto brdfLUTShader = m_shaderLib->getShader(brdfLUTShaderName);
 
-  auto fbo = std::make_unique<QOpenGLFramebufferObject>(512, 512, QOpenGLFramebufferObject::Depth);
-  funcs->glViewport(0, 0, 512, 512);
   brdfLUTShader->bind();
   {
     using namespace MeshAttributes;
@@ -561,63 +1120,678 @@ void MaterialPBR::initBrdfLUTMap(const TriMesh &_plane, const MeshVBO &_vbo)
     brdfLUTShader->setAttributeBuffer(UV, GL_FLOAT, _vbo.offset(UV), 2);
   }
 
-  funcs->glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_brdfMap->textureId(), 0);
-  funcs->glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+  m_bakeTargets.bindTarget(m_brdfMap->textureId(), 0, k_brdfDim, k_brdfDim);
+  funcs->glClear(GL_COLOR_BUFFER_BIT);
   funcs->glDrawElements(GL_TRIANGLES, _plane.getNIndicesData(), GL_UNSIGNED_SHORT, nullptr);
+  m_bakeTargets.releaseTarget();
+}
 
-  funcs->glBindFramebuffer(GL_FRAMEBUFFER, defaultFBO);
-  fbo->release();
+void MaterialPBR::bakeVolumes()
+{
+  using tex = QOpenGLTexture;
+  m_volumesDirty = false;
+  // Any encode still running belongs to the pools we're replacing
+  ++m_volumeGeneration;
+
+  // Round the displacement out, so that the eye controls can be moved a little without a rebake
+  const float eyeDisp = m_params.get().eyeDisp * k_maxEyeHeight;
+  m_volumeDisp = std::copysign(std::ceil(std::abs(eyeDisp) / k_eyeDispStep) * k_eyeDispStep, eyeDisp);
+  m_pendingVolumes = BrickPools();
+  if (!buildBrickPools(m_pendingVolumes, k_volumeDim))
+    return;
+  m_pendingVolumes.m_colours = m_colours;
+
+  // The layout is cheap to rebuild, but the pools are only baked if a previous run hasn't stored them
+  m_pendingCacheKey = volumeCacheKey();
+  if (loadVolumeCache(m_pendingCacheKey, m_pendingVolumes))
+  {
+    m_volumes = std::move(m_pendingVolumes);
+    m_pendingVolumes = BrickPools();
+    m_volumeUniformsDirty = true;
+    return;
+  }
+
+  // A coarse volume is baked in one go so there is something to show straight away, the full volume
+  // is then refined over the following frames
+  BrickPools preview;
+  if (buildBrickPools(preview, k_previewVolumeDim))
+  {
+    preview.m_colours = m_colours;
+    allocateBrickPool(preview, preview.m_albedo, tex::RGBA16F);
+    if (!m_deriveNormals)
+      allocateBrickPool(preview, preview.m_normal, tex::RGBA16F);
+    for (auto& layers : preview.m_layers)
+      allocateBrickPool(preview, layers, tex::RGBA8_UNorm);
+    bakeBrickLayers(preview, 0, bakeLayerCount(preview));
+    m_volumes = std::move(preview);
+    m_volumeUniformsDirty = true;
+  }
+  // Image stores can't write three channel formats, so the normals are padded
+  allocateBrickPool(m_pendingVolumes, m_pendingVolumes.m_albedo, tex::RGBA16F);
+  if (!m_deriveNormals)
+    allocateBrickPool(m_pendingVolumes, m_pendingVolumes.m_normal, tex::RGBA16F);
+  for (auto& layers : m_pendingVolumes.m_layers)
+    allocateBrickPool(m_pendingVolumes, layers, tex::RGBA8_UNorm);
+  m_pendingLayer = 0;
 }
 
-void MaterialPBR::generate3DTexture(
-    const TriMesh &_plane,
-    const MeshVBO &_vbo,
-    std::unique_ptr<QOpenGLTexture> &_texture,
-    const int _dim,
-    const std::string &_matPath,
-    const QOpenGLTexture::TextureFormat _format,
-    const std::function<void (QOpenGLShaderProgram* io_prog)> &_prerender
-    )
+void MaterialPBR::refineVolumes()
+{
+  auto funcs = m_context->versionFunctions<QOpenGLFunctions_4_3_Core>();
+  if (!m_bakeTimer)
+    funcs->glGenQueries(1, &m_bakeTimer);
+
+  // The timings arrive a frame or two late, we never wait on them
+  if (m_bakeTimerLayers)
+  {
+    GLint available = GL_FALSE;
+    funcs->glGetQueryObjectiv(m_bakeTimer, GL_QUERY_RESULT_AVAILABLE, &available);
+    if (available)
+    {
+      GLuint64 elapsed = 0;
+      funcs->glGetQueryObjectui64v(m_bakeTimer, GL_QUERY_RESULT, &elapsed);
+      m_bakeLayerMs = static_cast<float>(elapsed) * 1e-6f / static_cast<float>(m_bakeTimerLayers);
+      m_bakeTimerLayers = 0;
+    }
+  }
+  if (!m_pendingVolumes.m_albedo) return;
+
+  // Start with a single layer, then fit as many as the budget allows
+  const int totalLayers = bakeLayerCount(m_pendingVolumes);
+  int layers = 1;
+  if (m_bakeLayerMs > 0.0f)
+    layers = std::max(1, static_cast<int>(m_volumeBakeBudget / m_bakeLayerMs));
+  layers = std::min(layers, totalLayers - m_pendingLayer);
+
+  // Only one query is kept in flight, frames in between reuse the last measurement
+  const bool timed = !m_bakeTimerLayers;
+  if (timed) funcs->glBeginQuery(GL_TIME_ELAPSED, m_bakeTimer);
+  bakeBrickLayers(m_pendingVolumes, m_pendingLayer, layers);
+  if (timed)
+  {
+    funcs->glEndQuery(GL_TIME_ELAPSED);
+    m_bakeTimerLayers = layers;
+  }
+  m_pendingLayer += layers;
+  if (m_pendingLayer < totalLayers) return;
+
+  // Swap the finished volume in, and store it for the next run
+  m_volumes = std::move(m_pendingVolumes);
+  m_pendingVolumes = BrickPools();
+  m_volumeUniformsDirty = true;
+  if (!m_compressVolumes && m_pendingCacheKey.empty()) return;
+  // The pools are RGBA16F, so we read back halfs to avoid any conversion
+  using tex = QOpenGLTexture;
+  auto readback = std::make_shared<VolumeReadback>();
+  readback->m_job = std::make_shared<VolumeEncode>();
+  readback->m_job->m_generation = m_volumeGeneration;
+  readback->m_job->m_albedoGeneration = m_albedoGeneration;
+  readback->m_job->m_cacheKey = m_pendingCacheKey;
+  readback->m_encode = m_compressVolumes;
+  TextureIO::beginDownload(m_context, *m_volumes.m_albedo, tex::RGBA, tex::Float16, 8, readback->m_albedo);
+  if (m_volumes.m_normal)
+    TextureIO::beginDownload(m_context, *m_volumes.m_normal, tex::RGBA, tex::Float16, 8, readback->m_normal);
+  for (size_t i = 0; i < m_volumes.m_layers.size(); ++i)
+    TextureIO::beginDownload(m_context, *m_volumes.m_layers[i], tex::RGBA, tex::UInt8, 4, readback->m_layers[i]);
+  m_volumeReadbacks.push_back(readback);
+}
+
+void MaterialPBR::finishVolumeReadback()
+{
+  if (m_volumeReadbacks.empty()) return;
+  // The pools are copied out on the worker threads as they land, this frame only maps and unmaps them
+  auto& readback = *m_volumeReadbacks.front();
+  std::vector<TextureIO::Download*> downloads = {&readback.m_albedo, &readback.m_normal};
+  for (auto& layers : readback.m_layers)
+    downloads.push_back(&layers);
+  bool finished = true;
+  for (const auto download : downloads)
+    finished &= TextureIO::finishDownload(m_context, *download, ThreadPool::instance());
+  if (!finished) return;
+
+  const auto job = readback.m_job;
+  job->m_albedo = std::move(readback.m_albedo.m_file);
+  job->m_normal = std::move(readback.m_normal.m_file);
+  // The masks are only read when the colours change, so they wait in memory until then. A recolour
+  // since the bake has already moved them back to video memory, where they're kept
+  const bool keepLayers = job->m_generation != m_volumeGeneration || job->m_albedoGeneration != m_albedoGeneration;
+  const auto prefix = k_volumeCacheDir + job->m_cacheKey;
+  for (size_t i = 0; i < readback.m_layers.size(); ++i)
+  {
+    auto& layers = readback.m_layers[i].m_file;
+    if (!layers.header().m_levels) continue;
+    if (!job->m_cacheKey.empty())
+      layers.save(prefix + "_layers" + std::to_string(i) + ".tex");
+    if (keepLayers) continue;
+    m_volumes.m_layerFiles[i] = std::move(layers);
+    m_volumes.m_layers[i].reset();
+  }
+  if (readback.m_encode)
+  {
+    // The encode takes seconds, so it runs on the worker threads and is picked up by finishVolumeEncode
+    job->m_done = ThreadPool::instance().submit([job] { job->encode(); });
+    m_volumeEncodes.push_back(job);
+  }
+  else if (!job->m_cacheKey.empty())
+  {
+    job->m_albedo.save(prefix + "_albedo.tex");
+    if (job->m_normal.header().m_levels)
+      job->m_normal.save(prefix + "_normal.tex");
+  }
+  m_volumeReadbacks.erase(m_volumeReadbacks.begin());
+}
+
+void MaterialPBR::finishVolumeEncode()
+{
+  const auto finished = std::stable_partition(m_volumeEncodes.begin(), m_volumeEncodes.end(), [](const auto& _job)
+  {
+    return _job->m_done.wait_for(std::chrono::seconds(0)) != std::future_status::ready;
+  });
+  for (auto it = finished; it != m_volumeEncodes.end(); ++it)
+  {
+    const auto& job = **it;
+    // A rebake replaces every pool, and a recolour only the albedo. The pools we have are then newer
+    // than the job, but it still holds what it's cache key describes
+    const bool layout = job.m_generation == m_volumeGeneration && m_volumes.m_albedo;
+    const bool albedo = layout && job.m_albedoGeneration == m_albedoGeneration;
+
+    // The displacement is split out at full precision, so it's counted with the albedo
+    const bool normals = job.m_normal.header().m_levels;
+    reportCompression("albedo", job.m_albedoBytes, textureBytes(job.m_albedo) + textureBytes(job.m_height), job.m_albedoError);
+    if (normals)
+      reportCompression("normal", job.m_normalBytes, textureBytes(job.m_normal), job.m_normalError);
+
+    if (albedo)
+    {
+      uploadBrickPool(job.m_albedo, m_volumes.m_albedo);
+      m_volumes.m_albedoRange = job.m_albedoRange;
+      m_volumeUniformsDirty = true;
+    }
+    if (layout)
+      uploadBrickPool(job.m_height, m_volumes.m_height);
+    if (layout && normals)
+    {
+      uploadBrickPool(job.m_normal, m_volumes.m_normal);
+      m_volumes.m_normalRange = job.m_normalRange;
+      m_volumeUniformsDirty = true;
+    }
+
+    if (job.m_cacheKey.empty()) continue;
+    const auto prefix = k_volumeCacheDir + job.m_cacheKey;
+    job.m_albedo.save(prefix + "_albedo.tex");
+    job.m_albedoRange.toFile().save(prefix + "_albedo_range.tex");
+    job.m_height.save(prefix + "_height.tex");
+    if (normals)
+    {
+      job.m_normal.save(prefix + "_normal.tex");
+      job.m_normalRange.toFile().save(prefix + "_normal_range.tex");
+    }
+  }
+  m_volumeEncodes.erase(finished, m_volumeEncodes.end());
+}
+
+void MaterialPBR::recolourVolumes()
+{
+  using tex = QOpenGLTexture;
+  auto& layers = m_volumes.m_layers;
+  auto& layerFiles = m_volumes.m_layerFiles;
+  if (!layers[0] && !layerFiles[0].header().m_levels)
+  {
+    m_volumesDirty = true;
+    return;
+  }
+  // The masks are kept in video memory from the first recolour, as more edits usually follow
+  for (size_t i = 0; i < layers.size(); ++i)
+  {
+    if (layers[i]) continue;
+    uploadBrickPool(layerFiles[i], layers[i]);
+    layerFiles[i] = TextureFile();
+  }
+  m_volumes.m_colours = m_colours;
+  ++m_albedoGeneration;
+
+  // The new pool is filled in the same passes as a bake, with the noise swapped for the masks
+  std::unique_ptr<QOpenGLTexture> albedo;
+  allocateBrickPool(m_volumes, albedo, tex::RGBA16F);
+  for (const auto& pass : brickPasses(m_volumes.m_layout, false))
+  {
+    const char* shaderName = pass.m_level ? pass.m_shaderName : "owl_recombine";
+    dispatchBricks(shaderName, m_volumes, *albedo, pass.m_firstLayer, pass.m_numLayers, [this, &pass, &albedo](auto shader)
+    {
+      if (pass.m_level)
+      {
+        shader->setUniformValue("u_level", pass.m_level);
+        shader->setUniformValue("u_finePool", 0);
+        shader->setUniformValue("u_brickIndirection", 1);
+        albedo->bind(0);
+        m_volumes.m_indirection->bind(1);
+        return;
+      }
+      shader->setUniformValueArray("u_cols", m_colours.data(), static_cast<int>(m_colours.size()));
+      shader->setUniformValue("u_layersLow", 0);
+      shader->setUniformValue("u_layersHigh", 1);
+      shader->setUniformValue("u_heightMap", 2);
+      m_volumes.m_layers[0]->bind(0);
+      m_volumes.m_layers[1]->bind(1);
+      (m_volumes.m_height ? m_volumes.m_height : m_volumes.m_albedo)->bind(2);
+    });
+  }
+  m_volumes.m_albedo = std::move(albedo);
+  m_volumes.m_albedoRange = BlockCompression::Range();
+  m_volumeUniformsDirty = true;
+  if (!m_compressVolumes) return;
+
+  // Recoloured pools aren't cached, as the colours aren't kept between runs
+  auto readback = std::make_shared<VolumeReadback>();
+  readback->m_job = std::make_shared<VolumeEncode>();
+  readback->m_job->m_generation = m_volumeGeneration;
+  readback->m_job->m_albedoGeneration = m_albedoGeneration;
+  readback->m_encode = true;
+  TextureIO::beginDownload(m_context, *m_volumes.m_albedo, tex::RGBA, tex::Float16, 8, readback->m_albedo);
+  m_volumeReadbacks.push_back(readback);
+}
+
+bool MaterialPBR::buildBrickPools(BrickPools &o_pools, const int _dim)
 {
   using tex = QOpenGLTexture;
-  auto defaultFBO = m_context->defaultFramebufferObject();
   auto funcs = m_context->versionFunctions<QOpenGLFunctions_4_3_Core>();
+  GLint maxSize = 0;
+  funcs->glGetIntegerv(GL_MAX_3D_TEXTURE_SIZE, &maxSize);
+  o_pools.m_layout = BrickVolume::build(
+        m_volumeSurface.getVertices(),
+        m_volumeSurface.getNormals(),
+        m_volumeSurface.getIndices(),
+        k_volumeScale,
+        k_volumeOffset,
+        0.0f,
+        m_volumeDisp,
+        _dim,
+        maxSize
+        );
+  const auto& layout = o_pools.m_layout;
+  if (layout.m_bricks.empty())
+  {
+    std::cerr << "MaterialPBR: the volume bricks don't fit in a " << maxSize << " texture\n";
+    return false;
+  }
 
-  _texture.reset(new QOpenGLTexture(QOpenGLTexture::Target3D));
-  _texture->create();
-  _texture->bind();
-  _texture->setSize(_dim, _dim, _dim);
-  _texture->setFormat(_format);
-  _texture->setMinMagFilters(tex::Linear, tex::Linear);
-  _texture->setWrapMode(tex::MirroredRepeat);
-  _texture->allocateStorage();
+  // One texel per brick of every level, read without filtering
+  const auto& indirectionSize = layout.m_indirectionSize;
+  o_pools.m_indirection.reset(new QOpenGLTexture(QOpenGLTexture::Target3D));
+  o_pools.m_indirection->create();
+  o_pools.m_indirection->setSize(indirectionSize.x, indirectionSize.y, indirectionSize.z);
+  o_pools.m_indirection->setFormat(tex::RGBA8U);
+  o_pools.m_indirection->setMinMagFilters(tex::Nearest, tex::Nearest);
+  o_pools.m_indirection->setWrapMode(tex::ClampToEdge);
+  o_pools.m_indirection->allocateStorage(tex::RGBA_Integer, tex::UInt8);
+  o_pools.m_indirection->setData(tex::RGBA_Integer, tex::UInt8, layout.m_indirection.data());
+
+  o_pools.m_brickList.create();
+  o_pools.m_brickList.bind();
+  o_pools.m_brickList.allocate(layout.m_bricks.data(), static_cast<int>(layout.m_bricks.size() * sizeof(uint32_t)));
+  o_pools.m_brickList.release();
+
+  const auto& finest = layout.m_levels.front();
+  report("Volume bricks at ", _dim, ": ", finest.m_numBricks, " of ",
+         finest.m_bricks.x * finest.m_bricks.y * finest.m_bricks.z, " in the fitted box, ",
+         layout.m_bricks.size(), " over ", layout.m_levels.size(), " levels, ",
+         m_deriveNormals ? 1 : 2, " pools of ", BrickVolume::poolBytes(layout, 8) / (1024 * 1024), "MB");
+  return true;
+}
 
-  auto shaderName = m_shaderLib->loadShaderProg(_matPath.c_str());
-  auto shader = m_shaderLib->getShader(shaderName);
+int MaterialPBR::bakeLayerCount(const BrickPools &_pools) const
+{
+  int layers = 0;
+  for (const auto& pass : brickPasses(_pools.m_layout, _pools.m_normal != nullptr))
+    layers += pass.m_numLayers;
+  return layers;
+}
 
-  auto fbo = std::make_unique<QOpenGLFramebufferObject>(_dim, _dim, QOpenGLFramebufferObject::Depth, GL_TEXTURE_3D);
-  funcs->glViewport(0, 0, _dim, _dim);
-  shader->bind();
+void MaterialPBR::bakeBrickLayers(BrickPools &io_pools, const int _firstLayer, const int _numLayers)
+{
+  // Every pass reads what the passes before it wrote, so they always run in order
+  int passStart = 0;
+  for (const auto& pass : brickPasses(io_pools.m_layout, io_pools.m_normal != nullptr))
+  {
+    const int begin = std::max(_firstLayer, passStart);
+    const int end = std::min(_firstLayer + _numLayers, passStart + pass.m_numLayers);
+    const int firstLayer = pass.m_firstLayer + begin - passStart;
+    passStart += pass.m_numLayers;
+    if (begin >= end) continue;
+
+    auto& pool = pass.m_normals ? *io_pools.m_normal : *io_pools.m_albedo;
+    dispatchBricks(pass.m_shaderName, io_pools, pool, firstLayer, end - begin, [this, &pass, &io_pools, &pool](auto shader)
+    {
+      if (pass.m_level)
+      {
+        // Coarser levels are averaged from the level before, in the pool that we're writing
+        shader->setUniformValue("u_level", pass.m_level);
+        shader->setUniformValue("u_finePool", 0);
+        shader->setUniformValue("u_brickIndirection", 1);
+        pool.bind(0);
+        io_pools.m_indirection->bind(1);
+      }
+      else if (pass.m_normals)
+      {
+        // The normals are taken from the albedo's displacement channel
+        shader->setUniformValue("u_bumpMap", 0);
+        shader->setUniformValue("u_brickIndirection", 1);
+        io_pools.m_albedo->bind(0);
+        io_pools.m_indirection->bind(1);
+      }
+      else
+      {
+        // The layer masks are written alongside the albedo
+        auto funcs = m_context->versionFunctions<QOpenGLFunctions_4_3_Core>();
+        shader->setUniformValueArray("u_cols", io_pools.m_colours.data(), static_cast<int>(io_pools.m_colours.size()));
+        for (size_t i = 0; i < io_pools.m_layers.size(); ++i)
+        {
+          const auto unit = static_cast<GLuint>(i + 1);
+          funcs->glBindImageTexture(unit, io_pools.m_layers[i]->textureId(), 0, GL_TRUE, 0, GL_WRITE_ONLY, GL_RGBA8);
+        }
+      }
+    });
+  }
+}
+
+void MaterialPBR::setBrickLevels(const GLuint _program, const BrickLayout &_layout)
+{
+  std::array<glm::ivec4, BrickVolume::k_maxLevels> origins, sizes;
+  origins.fill(glm::ivec4(0));
+  sizes.fill(glm::ivec4(0));
+  for (size_t i = 0; i < _layout.m_levels.size(); ++i)
+  {
+    const auto& level = _layout.m_levels[i];
+    origins[i] = glm::ivec4(level.m_origin, level.m_indirectionSlice);
+    sizes[i] = glm::ivec4(level.m_bricks, level.m_dim);
+  }
+  auto funcs = m_context->versionFunctions<QOpenGLFunctions_4_3_Core>();
+  funcs->glProgramUniform4iv(
+        _program, funcs->glGetUniformLocation(_program, "u_brickLevelOrigins"), BrickVolume::k_maxLevels, &origins[0].x);
+  funcs->glProgramUniform4iv(
+        _program, funcs->glGetUniformLocation(_program, "u_brickLevelSizes"), BrickVolume::k_maxLevels, &sizes[0].x);
+  funcs->glProgramUniform1i(
+        _program, funcs->glGetUniformLocation(_program, "u_brickLevels"), static_cast<GLint>(_layout.m_levels.size()));
+}
+
+void MaterialPBR::setVolumeUniforms(QOpenGLShaderProgram* io_program)
+{
+  auto funcs = m_context->versionFunctions<QOpenGLFunctions_4_3_Core>();
+  const auto id = io_program->programId();
+  setBrickLevels(id, m_volumes.m_layout);
+  funcs->glProgramUniform3fv(id, io_program->uniformLocation("u_albedoScale"), 1, m_volumes.m_albedoRange.m_scale);
+  funcs->glProgramUniform3fv(id, io_program->uniformLocation("u_albedoBias"), 1, m_volumes.m_albedoRange.m_bias);
+  funcs->glProgramUniform3fv(id, io_program->uniformLocation("u_normalScale"), 1, m_volumes.m_normalRange.m_scale);
+  funcs->glProgramUniform3fv(id, io_program->uniformLocation("u_normalBias"), 1, m_volumes.m_normalRange.m_bias);
+}
+
+std::string MaterialPBR::volumeCacheKey() const
+{
+  // The bricks depend on the surface and the displacement it allows for
+  uint64_t hash = 0;
+  if (!HashUtils::fnv1aFile(k_volumeSurfacePath, hash)) return "";
+  const std::string settings = std::to_string(k_volumeBakeVersion) + ' ' +
+      std::to_string(k_volumeDim) + ' ' +
+      std::to_string(BrickVolume::k_brickDim) + ' ' +
+      std::to_string(m_volumeDisp) + ' ' +
+      std::to_string(m_compressVolumes);
+  hash = HashUtils::fnv1a(settings, hash);
+  hash = HashUtils::fnv1a(m_colours.data(), sizeof(m_colours), hash);
+  // Edits to the noise, or any file it includes, must miss the cache
+  for (const auto program : {"owl_noise", "owl_normal", "owl_mip"})
+  {
+    const auto sourceHash = m_shaderLib->sourceHash(program);
+    hash = HashUtils::fnv1a(&sourceHash, sizeof(sourceHash), hash);
+  }
+  return HashUtils::toHex(hash);
+}
+
+bool MaterialPBR::loadVolumeCache(const std::string &_key, BrickPools &io_pools)
+{
+  if (_key.empty()) return false;
+
+  // The normals are only stored when they're baked, deriving them needs the albedo alone. Compressed
+  // pools come with their ranges, and the displacement split out
+  const auto prefix = k_volumeCacheDir + _key;
+  TextureFile albedo, normal, height, range;
+  if (!albedo.load(prefix + "_albedo.tex") || (!m_deriveNormals && !normal.load(prefix + "_normal.tex")))
+    return false;
+  // The layer masks stay in memory until the colours change
+  auto& layers = io_pools.m_layerFiles;
+  for (size_t i = 0; i < layers.size(); ++i)
+  {
+    if (!layers[i].load(prefix + "_layers" + std::to_string(i) + ".tex"))
+      return false;
+  }
+  if (albedo.isCompressed())
+  {
+    if (!height.load(prefix + "_height.tex") ||
+        !range.load(prefix + "_albedo_range.tex") || !io_pools.m_albedoRange.fromFile(range))
+      return false;
+    if (!m_deriveNormals &&
+        (!range.load(prefix + "_normal_range.tex") || !io_pools.m_normalRange.fromFile(range)))
+      return false;
+  }
+  std::vector<std::pair<TextureFile*, std::unique_ptr<QOpenGLTexture>*>> pools = {{&albedo, &io_pools.m_albedo}};
+  if (!m_deriveNormals)
+    pools.emplace_back(&normal, &io_pools.m_normal);
+  if (albedo.isCompressed())
+    pools.emplace_back(&height, &io_pools.m_height);
+  // Guard against a pool that doesn't match the layout we just built
+  const auto size = io_pools.m_layout.m_poolBricks * BrickVolume::k_paddedDim;
+  std::vector<const TextureFile*> files = {&layers[0], &layers[1]};
+  for (const auto& pool : pools)
+    files.push_back(pool.first);
+  for (const auto file : files)
+  {
+    const auto& header = file->header();
+    if (header.m_width != static_cast<uint32_t>(size.x) ||
+        header.m_height != static_cast<uint32_t>(size.y) ||
+        header.m_depth != static_cast<uint32_t>(size.z))
+      return false;
+  }
+
+  for (const auto& pool : pools)
+    uploadBrickPool(*pool.first, *pool.second);
+  return true;
+}
+
+void MaterialPBR::uploadBrickPool(const TextureFile &_file, std::unique_ptr<QOpenGLTexture> &o_texture)
+{
+  using tex = QOpenGLTexture;
+  TextureIO::upload(_file, o_texture);
+  o_texture->setMinMagFilters(tex::Linear, tex::Linear);
+  o_texture->setWrapMode(tex::ClampToEdge);
+  // A lone displacement is read from w, as it is when it shares the albedo pool
+  if (_file.header().m_pixelFormat == tex::Red)
+    o_texture->setSwizzleMask(tex::ZeroValue, tex::ZeroValue, tex::ZeroValue, tex::RedValue);
+}
+
+void MaterialPBR::bakeAtlas()
+{
+  using tex = QOpenGLTexture;
+  auto funcs = m_context->versionFunctions<QOpenGLFunctions_4_3_Core>();
+  const auto allocateAtlas = [](std::unique_ptr<QOpenGLTexture> &o_texture)
+  {
+    o_texture.reset(new QOpenGLTexture(QOpenGLTexture::Target2D));
+    o_texture->create();
+    o_texture->bind();
+    o_texture->setSize(k_atlasDim, k_atlasDim);
+    o_texture->setFormat(tex::RGBA16F);
+    o_texture->setMinMagFilters(tex::Linear, tex::Linear);
+    o_texture->setWrapMode(tex::ClampToEdge);
+    o_texture->allocateStorage();
+  };
+  allocateAtlas(m_albedoAtlas);
+  allocateAtlas(m_normalAtlas);
+
+  // This can run in the middle of a frame, so the scene's vertex array is put back afterwards
+  GLint sceneVAO = 0;
+  funcs->glGetIntegerv(GL_VERTEX_ARRAY_BINDING, &sceneVAO);
+  QOpenGLVertexArrayObject vao;
+  vao.create();
+  vao.bind();
+
+  MeshVBO vbo;
+  vbo.init();
+  vbo.reset(
+        sizeof(GLushort),
+        m_volumeSurface.getNIndicesData(),
+        sizeof(GLfloat),
+        m_volumeSurface.getNVertData(),
+        m_volumeSurface.getNUVData(),
+        m_volumeSurface.getNNormData()
+        );
   {
     using namespace MeshAttributes;
-    shader->enableAttributeArray(VERTEX);
-    shader->setAttributeBuffer(VERTEX, GL_FLOAT, _vbo.offset(VERTEX), 3);
-    shader->enableAttributeArray(UV);
-    shader->setAttributeBuffer(UV, GL_FLOAT, _vbo.offset(UV), 2);
+    vbo.write(m_volumeSurface.getVertexData(), VERTEX);
+    vbo.write(m_volumeSurface.getUVsData(), UV);
+    vbo.setIndices(m_volumeSurface.getIndicesData());
   }
 
-  _prerender(shader);
+  const std::pair<std::string, QOpenGLTexture*> passes[] = {
+    {"owl_atlas", m_albedoAtlas.get()},
+    {m_shaderLib->submitVariant("owl_atlas", {"NORMALS"}), m_normalAtlas.get()}
+  };
+  for (const auto& pass : passes)
+  {
+    m_shaderLib->useShader(pass.first);
+    auto shader = m_shaderLib->getCurrentShader();
+    shader->setUniformValueArray("u_cols", m_colours.data(), static_cast<int>(m_colours.size()));
+    shader->setUniformValue("u_volumeDim", k_volumeDim);
+    {
+      using namespace MeshAttributes;
+      shader->enableAttributeArray(VERTEX);
+      shader->setAttributeBuffer(VERTEX, GL_FLOAT, vbo.offset(VERTEX), 3);
+      shader->enableAttributeArray(UV);
+      shader->setAttributeBuffer(UV, GL_FLOAT, vbo.offset(UV), 2);
+    }
 
-  const auto denom = 1.f / static_cast<float>(_dim);
-  for (int i = 0; i < _dim; ++i)
+    // Texels that no triangle covers are left with a w of zero, which the dilation relies on
+    m_bakeTargets.bindTarget(pass.second->textureId(), 0, k_atlasDim, k_atlasDim);
+    const GLfloat clear[] = {0.0f, 0.0f, 0.0f, 0.0f};
+    funcs->glClearBufferfv(GL_COLOR, 0, clear);
+    funcs->glDrawElements(GL_TRIANGLES, m_volumeSurface.getNIndicesData(), GL_UNSIGNED_SHORT, nullptr);
+    m_bakeTargets.releaseTarget();
+  }
+  funcs->glBindVertexArray(static_cast<GLuint>(sceneVAO));
+
+  // Each step grows the covered texels out by one, ping-ponging with a pair of scratch atlases
+  std::unique_ptr<QOpenGLTexture> albedoScratch;
+  std::unique_ptr<QOpenGLTexture> normalScratch;
+  allocateAtlas(albedoScratch);
+  allocateAtlas(normalScratch);
+  m_shaderLib->useShader("owl_atlas_dilate");
+  auto shader = m_shaderLib->getCurrentShader();
+  shader->setUniformValue("u_albedoAtlas", 0);
+  shader->setUniformValue("u_normalAtlas", 1);
+  const auto groups = static_cast<GLuint>((k_atlasDim + 15) / 16);
+  for (int i = 0; i < k_atlasDilation; ++i)
   {
-    shader->setUniformValue("u_zDepth", i * denom);
-    funcs->glFramebufferTexture3D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_3D, _texture->textureId(), 0, i);
-    funcs->glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-    funcs->glDrawElements(GL_TRIANGLES, _plane.getNIndicesData(), GL_UNSIGNED_SHORT, nullptr);
+    m_albedoAtlas->bind(0);
+    m_normalAtlas->bind(1);
+    funcs->glBindImageTexture(0, albedoScratch->textureId(), 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RGBA16F);
+    funcs->glBindImageTexture(1, normalScratch->textureId(), 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RGBA16F);
+    funcs->glDispatchCompute(groups, groups, 1);
+    funcs->glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+    std::swap(m_albedoAtlas, albedoScratch);
+    std::swap(m_normalAtlas, normalScratch);
   }
+  funcs->glBindImageTexture(0, 0, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RGBA16F);
+  funcs->glBindImageTexture(1, 0, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RGBA16F);
+}
+
+void MaterialPBR::bakeTiles()
+{
+  const bool detail = m_volumeTiling == VolumeTiling::DETAIL_TILE;
+  if (m_tile && (m_detailTile || !detail)) return;
+  if (!m_tile)
+    bakeTile(m_tile, k_tileDim, k_tileRepeats, glm::vec3(0.0f));
+  if (detail && !m_detailTile)
+    bakeTile(m_detailTile, k_detailTileDim, k_detailTileRepeats, k_detailTileOffset);
+}
+
+void MaterialPBR::bakeTile(
+    std::unique_ptr<QOpenGLTexture> &o_texture,
+    const int _dim,
+    const int _repeats,
+    const glm::vec3 &_offset
+    )
+{
+  using tex = QOpenGLTexture;
+  auto funcs = m_context->versionFunctions<QOpenGLFunctions_4_3_Core>();
+  o_texture.reset(new QOpenGLTexture(QOpenGLTexture::Target3D));
+  o_texture->create();
+  o_texture->bind();
+  o_texture->setSize(_dim, _dim, _dim);
+  o_texture->setFormat(tex::RGBA16F);
+  o_texture->setMipLevels(o_texture->maximumMipLevels());
+  o_texture->allocateStorage();
+  o_texture->setMinMagFilters(tex::LinearMipMapLinear, tex::Linear);
+  // The noise repeats over the tile, so wrapping is seamless
+  o_texture->setWrapMode(tex::Repeat);
+
+  m_shaderLib->useShader("owl_tile");
+  auto shader = m_shaderLib->getCurrentShader();
+  shader->setUniformValueArray("u_cols", m_colours.data(), static_cast<int>(m_colours.size()));
+  shader->setUniformValue("u_tileRepeats", _repeats);
+  shader->setUniformValue("u_offsetPos", QVector3D(1.0f + _offset.x, 1.0f + _offset.y, 1.0f + _offset.z));
+  funcs->glBindImageTexture(0, o_texture->textureId(), 0, GL_TRUE, 0, GL_WRITE_ONLY, o_texture->format());
+  // Matches the work group size of owl_tile_comp.glsl
+  const auto groups = static_cast<GLuint>((_dim + 7) / 8);
+  funcs->glDispatchCompute(groups, groups, groups);
+  // The coarser levels are filtered from the finest, before the material samples them
+  funcs->glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT | GL_TEXTURE_UPDATE_BARRIER_BIT);
+  funcs->glBindImageTexture(0, 0, 0, GL_FALSE, 0, GL_WRITE_ONLY, o_texture->format());
+  o_texture->generateMipMaps();
+}
+
+void MaterialPBR::allocateBrickPool(
+    const BrickPools &_pools,
+    std::unique_ptr<QOpenGLTexture> &o_texture,
+    const QOpenGLTexture::TextureFormat _format
+    )
+{
+  using tex = QOpenGLTexture;
+  const auto size = _pools.m_layout.m_poolBricks * BrickVolume::k_paddedDim;
+  o_texture.reset(new QOpenGLTexture(QOpenGLTexture::Target3D));
+  o_texture->create();
+  o_texture->bind();
+  o_texture->setSize(size.x, size.y, size.z);
+  o_texture->setFormat(_format);
+  o_texture->setMinMagFilters(tex::Linear, tex::Linear);
+  // Every brick carries it's own apron, so filtering never needs to wrap
+  o_texture->setWrapMode(tex::ClampToEdge);
+  o_texture->allocateStorage();
+}
 
-  funcs->glBindFramebuffer(GL_FRAMEBUFFER, defaultFBO);
-  fbo->release();
+void MaterialPBR::dispatchBricks(
+    const std::string &_shaderName,
+    const BrickPools &_pools,
+    QOpenGLTexture &_texture,
+    const int _firstLayer,
+    const int _numLayers,
+    const std::function<void (QOpenGLShaderProgram* io_prog)> &_prebake
+    )
+{
+  auto funcs = m_context->versionFunctions<QOpenGLFunctions_4_3_Core>();
+  m_shaderLib->useShader(_shaderName);
+  auto shader = m_shaderLib->getCurrentShader();
+  _prebake(shader);
+  shader->setUniformValue("u_layerOffset", static_cast<GLuint>(_firstLayer));
+  setBrickLevels(shader->programId(), _pools.m_layout);
+
+  // Every brick is written straight to the pool, so there are no framebuffers or draws involved
+  funcs->glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, _pools.m_brickList.bufferId());
+  funcs->glBindImageTexture(0, _texture.textureId(), 0, GL_TRUE, 0, GL_WRITE_ONLY, _texture.format());
+  const auto& poolBricks = _pools.m_layout.m_poolBricks;
+  funcs->glDispatchCompute(
+        static_cast<GLuint>(poolBricks.x),
+        static_cast<GLuint>(poolBricks.y),
+        static_cast<GLuint>(std::min(_numLayers, poolBricks.z - _firstLayer))
+        );
+  // Later bakes and the material both read the pool through samplers
+  funcs->glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+  funcs->glBindImageTexture(0, 0, 0, GL_FALSE, 0, GL_WRITE_ONLY, _texture.format());
 }
 
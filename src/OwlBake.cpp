@@ -0,0 +1,116 @@
+#include "OwlBake.h"
+#include "ThreadPool.h"
+#include "HalfFloat.h"
+#include <cmath>
+#include <algorithm>
+
+namespace
+{
+// TextureFile is independent of GL, so we store the enums it needs by value
+constexpr uint32_t k_glTexture3D = 0x806F;
+constexpr uint32_t k_glRGBA16F = 0x881A;
+constexpr uint32_t k_glRGBA = 0x1908;
+constexpr uint32_t k_glHalfFloat = 0x140B;
+
+TextureFile allocateVolume(const int _dim)
+{
+  TextureFile::Header header;
+  header.m_target = k_glTexture3D;
+  header.m_internalFormat = k_glRGBA16F;
+  header.m_pixelFormat = k_glRGBA;
+  header.m_pixelType = k_glHalfFloat;
+  header.m_width = header.m_height = header.m_depth = static_cast<uint32_t>(_dim);
+  header.m_levels = 1;
+  header.m_bytesPerPixel = 4 * sizeof(uint16_t);
+  return TextureFile(header);
+}
+
+//-----------------------------------------------------------------------------------------------------
+/// @brief Maps a texel index in to the volume, in the same way as mirrorTexel in brick_volume.h.
+//-----------------------------------------------------------------------------------------------------
+int mirrorTexel(int _texel, const int _dim) noexcept
+{
+  const int period = 2 * _dim;
+  _texel %= period;
+  if (_texel < 0) _texel += period;
+  return _texel < _dim ? _texel : period - _texel - 1;
+}
+}
+
+//-----------------------------------------------------------------------------------------------------
+TextureFile OwlBake::albedo(const int _dim, const OwlNoise::Palette &_palette, ThreadPool &io_pool)
+{
+  using OwlNoise::k_lanes;
+  auto volume = allocateVolume(_dim);
+  auto texels = reinterpret_cast<uint16_t*>(volume.data(0));
+  const auto dim = static_cast<size_t>(_dim);
+  const float invDim = 1.0f / static_cast<float>(_dim);
+
+  io_pool.parallelFor(dim * dim, [&](size_t _begin, size_t _end)
+  {
+    OwlNoise::Points uvw;
+    alignas(32) float albedoDisp[k_lanes * 4];
+    for (size_t row = _begin; row < _end; ++row)
+    {
+      // Texel centres across each slice and the slice index in depth, as owl_noise_comp.glsl
+      const float v = (static_cast<float>(row % dim) + 0.5f) * invDim;
+      const float w = static_cast<float>(row / dim) * invDim;
+      std::fill(std::begin(uvw.m_y), std::end(uvw.m_y), v);
+      std::fill(std::begin(uvw.m_z), std::end(uvw.m_z), w);
+      for (size_t x = 0; x < dim; x += k_lanes)
+      {
+        // The last batch of a row repeats it's final texel, if the width isn't a multiple of the lanes
+        const size_t count = std::min(k_lanes, dim - x);
+        for (size_t lane = 0; lane < k_lanes; ++lane)
+          uvw.m_x[lane] = (static_cast<float>(x + std::min(lane, count - 1)) + 0.5f) * invDim;
+        OwlNoise::albedoDisp(uvw, _palette, albedoDisp);
+
+        auto texel = texels + (row * dim + x) * 4;
+        for (size_t i = 0; i < count * 4; ++i)
+          texel[i] = HalfFloat::fromFloat(albedoDisp[i]);
+      }
+    }
+  });
+  return volume;
+}
+//-----------------------------------------------------------------------------------------------------
+TextureFile OwlBake::normals(const TextureFile &_albedo, ThreadPool &io_pool)
+{
+  const int dim = static_cast<int>(_albedo.header().m_width);
+  auto volume = allocateVolume(dim);
+  auto texels = reinterpret_cast<uint16_t*>(volume.data(0));
+  const auto heights = reinterpret_cast<const uint16_t*>(_albedo.data(0));
+  const auto size = static_cast<size_t>(dim);
+
+  io_pool.parallelFor(size * size, [&](size_t _begin, size_t _end)
+  {
+    for (size_t row = _begin; row < _end; ++row)
+    {
+      const int y = static_cast<int>(row % size);
+      const size_t slice = (row / size) * size * size;
+      // The gradient reads the displacement as stored, after it was rounded to a half
+      const auto height = [&](const int _x, const int _y)
+      {
+        const auto index = slice + static_cast<size_t>(mirrorTexel(_y, dim)) * size + static_cast<size_t>(mirrorTexel(_x, dim));
+        return HalfFloat::toFloat(heights[index * 4 + 3]);
+      };
+      for (int x = 0; x < dim; ++x)
+      {
+        // Central differences across two texels, as owl_normal_comp.glsl
+        const float dx = height(x + 1, y) - height(x - 1, y);
+        const float dy = height(x, y + 1) - height(x, y - 1);
+        const float aLength = std::sqrt(4.0f + dx * dx);
+        const float bLength = std::sqrt(4.0f + dy * dy);
+        // cross((2, 0, dx) / |a|, (0, 2, dy) / |b|)
+        const float normal[] = {-2.0f * dx, -2.0f * dy, 4.0f};
+        const float scale = 1.0f / (aLength * bLength);
+
+        auto texel = texels + (row * size + static_cast<size_t>(x)) * 4;
+        for (size_t i = 0; i < 3; ++i)
+          texel[i] = HalfFloat::fromFloat(normal[i] * scale);
+        texel[3] = HalfFloat::fromFloat(0.0f);
+      }
+    }
+  });
+  return volume;
+}
@@ -0,0 +1,458 @@
+#include "OwlNoise.h"
+#include <cmath>
+#include <algorithm>
+#include <functional>
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#if defined(__SSE4_1__)
+#include <smmintrin.h>
+#endif
+#endif
+
+namespace
+{
+//-----------------------------------------------------------------------------------------------------
+/// @brief Eight floats, one per point of a batch. Only the primitives differ between instruction sets,
+/// the noise below is written once in terms of them.
+//-----------------------------------------------------------------------------------------------------
+struct Lanes
+{
+#if defined(__AVX2__)
+  __m256 m_v;
+
+  static Lanes load(const float* _values) noexcept { return {_mm256_load_ps(_values)}; }
+  static Lanes broadcast(const float _value) noexcept { return {_mm256_set1_ps(_value)}; }
+  void store(float* o_values) const noexcept { _mm256_store_ps(o_values, m_v); }
+
+  friend Lanes operator+(const Lanes &_a, const Lanes &_b) noexcept { return {_mm256_add_ps(_a.m_v, _b.m_v)}; }
+  friend Lanes operator-(const Lanes &_a, const Lanes &_b) noexcept { return {_mm256_sub_ps(_a.m_v, _b.m_v)}; }
+  friend Lanes operator*(const Lanes &_a, const Lanes &_b) noexcept { return {_mm256_mul_ps(_a.m_v, _b.m_v)}; }
+  friend Lanes operator/(const Lanes &_a, const Lanes &_b) noexcept { return {_mm256_div_ps(_a.m_v, _b.m_v)}; }
+  friend Lanes floor(const Lanes &_a) noexcept { return {_mm256_floor_ps(_a.m_v)}; }
+  friend Lanes min(const Lanes &_a, const Lanes &_b) noexcept { return {_mm256_min_ps(_a.m_v, _b.m_v)}; }
+  friend Lanes max(const Lanes &_a, const Lanes &_b) noexcept { return {_mm256_max_ps(_a.m_v, _b.m_v)}; }
+  friend Lanes abs(const Lanes &_a) noexcept { return {_mm256_andnot_ps(_mm256_set1_ps(-0.0f), _a.m_v)}; }
+  //-----------------------------------------------------------------------------------------------------
+  /// @brief 1 where _a <= _b and 0 elsewhere, which is GLSL's step(_a, _b).
+  //-----------------------------------------------------------------------------------------------------
+  friend Lanes lessEqualOne(const Lanes &_a, const Lanes &_b) noexcept
+  {
+    return {_mm256_and_ps(_mm256_cmp_ps(_a.m_v, _b.m_v, _CMP_LE_OQ), _mm256_set1_ps(1.0f))};
+  }
+#elif defined(__SSE2__)
+  __m128 m_v[2];
+
+  static Lanes load(const float* _values) noexcept { return {{_mm_load_ps(_values), _mm_load_ps(_values + 4)}}; }
+  static Lanes broadcast(const float _value) noexcept { return {{_mm_set1_ps(_value), _mm_set1_ps(_value)}}; }
+  void store(float* o_values) const noexcept
+  {
+    _mm_store_ps(o_values, m_v[0]);
+    _mm_store_ps(o_values + 4, m_v[1]);
+  }
+
+  template <typename Op>
+  static Lanes apply(const Lanes &_a, const Lanes &_b, Op _op) noexcept
+  {
+    return {{_op(_a.m_v[0], _b.m_v[0]), _op(_a.m_v[1], _b.m_v[1])}};
+  }
+  friend Lanes operator+(const Lanes &_a, const Lanes &_b) noexcept { return apply(_a, _b, _mm_add_ps); }
+  friend Lanes operator-(const Lanes &_a, const Lanes &_b) noexcept { return apply(_a, _b, _mm_sub_ps); }
+  friend Lanes operator*(const Lanes &_a, const Lanes &_b) noexcept { return apply(_a, _b, _mm_mul_ps); }
+  friend Lanes operator/(const Lanes &_a, const Lanes &_b) noexcept { return apply(_a, _b, _mm_div_ps); }
+  friend Lanes min(const Lanes &_a, const Lanes &_b) noexcept { return apply(_a, _b, _mm_min_ps); }
+  friend Lanes max(const Lanes &_a, const Lanes &_b) noexcept { return apply(_a, _b, _mm_max_ps); }
+  friend Lanes abs(const Lanes &_a) noexcept { return apply(broadcast(-0.0f), _a, _mm_andnot_ps); }
+  friend Lanes floor(const Lanes &_a) noexcept
+  {
+#if defined(__SSE4_1__)
+    return {{_mm_floor_ps(_a.m_v[0]), _mm_floor_ps(_a.m_v[1])}};
+#else
+    // Truncate, then step down where that rounded up, the noise never sees values near 2^31
+    return apply(_a, _a, [](const __m128 _x, const __m128)
+    {
+      const __m128 truncated = _mm_cvtepi32_ps(_mm_cvttps_epi32(_x));
+      return _mm_sub_ps(truncated, _mm_and_ps(_mm_cmpgt_ps(truncated, _x), _mm_set1_ps(1.0f)));
+    });
+#endif
+  }
+  friend Lanes lessEqualOne(const Lanes &_a, const Lanes &_b) noexcept
+  {
+    return apply(_a, _b, [](const __m128 _x, const __m128 _y)
+    {
+      return _mm_and_ps(_mm_cmple_ps(_x, _y), _mm_set1_ps(1.0f));
+    });
+  }
+#else
+  float m_v[OwlNoise::k_lanes];
+
+  static Lanes load(const float* _values) noexcept
+  {
+    Lanes result;
+    std::copy(_values, _values + OwlNoise::k_lanes, result.m_v);
+    return result;
+  }
+  static Lanes broadcast(const float _value) noexcept
+  {
+    Lanes result;
+    std::fill(result.m_v, result.m_v + OwlNoise::k_lanes, _value);
+    return result;
+  }
+  void store(float* o_values) const noexcept { std::copy(m_v, m_v + OwlNoise::k_lanes, o_values); }
+
+  template <typename Op>
+  static Lanes apply(const Lanes &_a, const Lanes &_b, Op _op) noexcept
+  {
+    Lanes result;
+    for (size_t i = 0; i < OwlNoise::k_lanes; ++i)
+      result.m_v[i] = _op(_a.m_v[i], _b.m_v[i]);
+    return result;
+  }
+  friend Lanes operator+(const Lanes &_a, const Lanes &_b) noexcept { return apply(_a, _b, std::plus<float>()); }
+  friend Lanes operator-(const Lanes &_a, const Lanes &_b) noexcept { return apply(_a, _b, std::minus<float>()); }
+  friend Lanes operator*(const Lanes &_a, const Lanes &_b) noexcept { return apply(_a, _b, std::multiplies<float>()); }
+  friend Lanes operator/(const Lanes &_a, const Lanes &_b) noexcept { return apply(_a, _b, std::divides<float>()); }
+  friend Lanes min(const Lanes &_a, const Lanes &_b) noexcept
+  {
+    return apply(_a, _b, [](const float _x, const float _y) { return std::min(_x, _y); });
+  }
+  friend Lanes max(const Lanes &_a, const Lanes &_b) noexcept
+  {
+    return apply(_a, _b, [](const float _x, const float _y) { return std::max(_x, _y); });
+  }
+  friend Lanes abs(const Lanes &_a) noexcept
+  {
+    return apply(_a, _a, [](const float _x, const float) { return std::abs(_x); });
+  }
+  friend Lanes floor(const Lanes &_a) noexcept
+  {
+    return apply(_a, _a, [](const float _x, const float) { return std::floor(_x); });
+  }
+  friend Lanes lessEqualOne(const Lanes &_a, const Lanes &_b) noexcept
+  {
+    return apply(_a, _b, [](const float _x, const float _y) { return _x <= _y ? 1.0f : 0.0f; });
+  }
+#endif
+
+  friend Lanes operator+(const Lanes &_a, const float _b) noexcept { return _a + broadcast(_b); }
+  friend Lanes operator-(const Lanes &_a, const float _b) noexcept { return _a - broadcast(_b); }
+  friend Lanes operator-(const float _a, const Lanes &_b) noexcept { return broadcast(_a) - _b; }
+  friend Lanes operator*(const Lanes &_a, const float _b) noexcept { return _a * broadcast(_b); }
+  friend Lanes operator/(const Lanes &_a, const float _b) noexcept { return _a / broadcast(_b); }
+};
+
+// The GLSL built ins that the noise uses, in terms of the primitives above
+inline Lanes fract(const Lanes &_x) noexcept { return _x - floor(_x); }
+inline Lanes step(const Lanes &_edge, const Lanes &_x) noexcept { return lessEqualOne(_edge, _x); }
+inline Lanes mix(const Lanes &_x, const Lanes &_y, const Lanes &_a) noexcept { return _x + (_y - _x) * _a; }
+inline Lanes clamp(const Lanes &_x, const float _lo, const float _hi) noexcept
+{
+  return min(max(_x, Lanes::broadcast(_lo)), Lanes::broadcast(_hi));
+}
+inline Lanes smoothstep(const float _edge0, const float _edge1, const Lanes &_x) noexcept
+{
+  const Lanes t = clamp((_x - _edge0) / (_edge1 - _edge0), 0.0f, 1.0f);
+  return t * t * (3.0f - t * 2.0f);
+}
+
+//-----------------------------------------------------------------------------------------------------
+/// @brief A batch of vectors, only the operations the noise needs are provided.
+//-----------------------------------------------------------------------------------------------------
+struct Lanes3
+{
+  Lanes x;
+  Lanes y;
+  Lanes z;
+
+  friend Lanes3 operator+(const Lanes3 &_a, const Lanes3 &_b) noexcept { return {_a.x + _b.x, _a.y + _b.y, _a.z + _b.z}; }
+  friend Lanes3 operator+(const Lanes3 &_a, const Lanes &_b) noexcept { return {_a.x + _b, _a.y + _b, _a.z + _b}; }
+  friend Lanes3 operator+(const Lanes3 &_a, const float _b) noexcept { return {_a.x + _b, _a.y + _b, _a.z + _b}; }
+  friend Lanes3 operator+(const Lanes3 &_a, const glm::vec3 &_b) noexcept
+  {
+    return {_a.x + _b.x, _a.y + _b.y, _a.z + _b.z};
+  }
+  friend Lanes3 operator*(const Lanes3 &_a, const float _b) noexcept { return {_a.x * _b, _a.y * _b, _a.z * _b}; }
+  friend Lanes3 operator*(const Lanes3 &_a, const glm::vec3 &_b) noexcept
+  {
+    return {_a.x * _b.x, _a.y * _b.y, _a.z * _b.z};
+  }
+};
+
+inline Lanes mod289(const Lanes &_x) noexcept
+{
+  return _x - floor(_x * (1.0f / 289.0f)) * 289.0f;
+}
+
+inline Lanes permute(const Lanes &_x) noexcept
+{
+  return mod289((_x * 34.0f + 1.0f) * _x);
+}
+
+inline Lanes taylorInvSqrt(const Lanes &_r) noexcept
+{
+  return 1.79284291400159f - _r * 0.85373472095314f;
+}
+
+inline Lanes fade(const Lanes &_t) noexcept
+{
+  return _t * _t * _t * (_t * (_t * 6.0f - 15.0f) + 10.0f);
+}
+
+//-----------------------------------------------------------------------------------------------------
+/// @brief The gradient of one lattice corner, chosen from the permuted hash as cnoise does.
+//-----------------------------------------------------------------------------------------------------
+inline Lanes3 gradient(const Lanes &_hash) noexcept
+{
+  Lanes gx = _hash * (1.0f / 7.0f);
+  Lanes gy = fract(floor(gx) * (1.0f / 7.0f)) - 0.5f;
+  gx = fract(gx);
+  const Lanes gz = 0.5f - abs(gx) - abs(gy);
+  const Lanes sz = step(gz, Lanes::broadcast(0.0f));
+  const Lanes zero = Lanes::broadcast(0.0f);
+  gx = gx - sz * (step(zero, gx) - 0.5f);
+  gy = gy - sz * (step(zero, gy) - 0.5f);
+  // The GLSL normalises the gradients four at a time, each lane is the same thing done separately
+  const Lanes norm = taylorInvSqrt(gx * gx + gy * gy + gz * gz);
+  return {gx * norm, gy * norm, gz * norm};
+}
+
+inline Lanes dot(const Lanes3 &_g, const Lanes &_x, const Lanes &_y, const Lanes &_z) noexcept
+{
+  return _g.x * _x + _g.y * _y + _g.z * _z;
+}
+
+//-----------------------------------------------------------------------------------------------------
+/// @brief Classic Perlin noise, a lane by lane port of cnoise in perlin_noise.h.
+//-----------------------------------------------------------------------------------------------------
+Lanes cnoise(const Lanes3 &_p) noexcept
+{
+  const Lanes3 pi0Raw {floor(_p.x), floor(_p.y), floor(_p.z)};
+  const Lanes3 pi0 {mod289(pi0Raw.x), mod289(pi0Raw.y), mod289(pi0Raw.z)};
+  const Lanes3 pi1 {mod289(pi0Raw.x + 1.0f), mod289(pi0Raw.y + 1.0f), mod289(pi0Raw.z + 1.0f)};
+  const Lanes3 pf0 {fract(_p.x), fract(_p.y), fract(_p.z)};
+  const Lanes3 pf1 {pf0.x - 1.0f, pf0.y - 1.0f, pf0.z - 1.0f};
+
+  // The four corners of ixy are (x0,y0), (x1,y0), (x0,y1) and (x1,y1)
+  const Lanes px0 = permute(pi0.x);
+  const Lanes px1 = permute(pi1.x);
+  const Lanes ixy00 = permute(px0 + pi0.y);
+  const Lanes ixy10 = permute(px1 + pi0.y);
+  const Lanes ixy01 = permute(px0 + pi1.y);
+  const Lanes ixy11 = permute(px1 + pi1.y);
+
+  const Lanes n000 = dot(gradient(permute(ixy00 + pi0.z)), pf0.x, pf0.y, pf0.z);
+  const Lanes n100 = dot(gradient(permute(ixy10 + pi0.z)), pf1.x, pf0.y, pf0.z);
+  const Lanes n010 = dot(gradient(permute(ixy01 + pi0.z)), pf0.x, pf1.y, pf0.z);
+  const Lanes n110 = dot(gradient(permute(ixy11 + pi0.z)), pf1.x, pf1.y, pf0.z);
+  const Lanes n001 = dot(gradient(permute(ixy00 + pi1.z)), pf0.x, pf0.y, pf1.z);
+  const Lanes n101 = dot(gradient(permute(ixy10 + pi1.z)), pf1.x, pf0.y, pf1.z);
+  const Lanes n011 = dot(gradient(permute(ixy01 + pi1.z)), pf0.x, pf1.y, pf1.z);
+  const Lanes n111 = dot(gradient(permute(ixy11 + pi1.z)), pf1.x, pf1.y, pf1.z);
+
+  const Lanes fadeX = fade(pf0.x);
+  const Lanes fadeY = fade(pf0.y);
+  const Lanes fadeZ = fade(pf0.z);
+  const Lanes nz00 = mix(n000, n001, fadeZ);
+  const Lanes nz10 = mix(n100, n101, fadeZ);
+  const Lanes nz01 = mix(n010, n011, fadeZ);
+  const Lanes nz11 = mix(n110, n111, fadeZ);
+  const Lanes ny0 = mix(nz00, nz01, fadeY);
+  const Lanes ny1 = mix(nz10, nz11, fadeY);
+  return mix(ny0, ny1, fadeX) * 2.2f;
+}
+
+// The layers of owl_noise_funcs.h, with the same names and arguments
+Lanes turb(const Lanes3 &_pos, const float _frequency) noexcept
+{
+  Lanes ret = Lanes::broadcast(0.0f);
+  float frequency = _frequency;
+  for (int i = 0; i < 8; ++i)
+  {
+    ret = ret + abs(cnoise(_pos * frequency)) / frequency;
+    frequency *= 2.1f;
+  }
+  return ret;
+}
+
+Lanes slicednoise(const Lanes3 &_pos, const float _frequency, const float _fuzz, const float _slice) noexcept
+{
+  return smoothstep(_slice, _slice + _fuzz, turb(_pos, _frequency));
+}
+
+Lanes brushed(const Lanes3 &_pos, const float _frequency, const glm::vec3 &_stretch) noexcept
+{
+  const Lanes3 pos = (_pos + cnoise(_pos * _frequency) / _frequency) * _stretch;
+  return turb(pos, _frequency * 2.0f);
+}
+
+Lanes veins(const Lanes3 &_pos, const float _frequency, const float _stretch) noexcept
+{
+  return 1.0f - slicednoise({_pos.x * _stretch, _pos.y, _pos.z}, _frequency, 0.05f, 0.01f);
+}
+
+Lanes3 randPos(const Lanes3 &_pos, const float _rand, const float _scale = 1.0f) noexcept
+{
+  return _pos + cnoise(_pos + _rand) * _scale;
+}
+
+Lanes blendNoise(const Lanes3 &_pos, const float _freq) noexcept
+{
+  return cnoise(randPos(_pos, 0.0f, 1.0f) * _freq) / _freq;
+}
+
+Lanes3 loadPoints(const OwlNoise::Points &_points) noexcept
+{
+  return {Lanes::load(_points.m_x), Lanes::load(_points.m_y), Lanes::load(_points.m_z)};
+}
+
+OwlNoise::Points broadcastPoint(const glm::vec3 &_point) noexcept
+{
+  OwlNoise::Points points;
+  std::fill(std::begin(points.m_x), std::end(points.m_x), _point.x);
+  std::fill(std::begin(points.m_y), std::end(points.m_y), _point.y);
+  std::fill(std::begin(points.m_z), std::end(points.m_z), _point.z);
+  return points;
+}
+
+//-----------------------------------------------------------------------------------------------------
+/// @brief The noise layers of calcLayers, in the same order.
+//-----------------------------------------------------------------------------------------------------
+void layers(const OwlNoise::Points &_uvw, const OwlNoise::Palette &_palette, Lanes* o_layers) noexcept
+{
+  const float k_scale = 5.0f;
+  const Lanes3 pos = loadPoints(_uvw) * k_scale;
+  const Lanes3 randP = pos + _palette.m_offsetPos;
+  // large darken, GLSL's clamp(1.0, 0.0, x) is min(1.0, x) as the bounds are swapped
+  o_layers[0] = 1.0f - min(Lanes::broadcast(1.0f), blendNoise(randPos(randP + glm::vec3(1.0f, 0.0f, 0.0f), 4.0f, 5.0f), 0.005f));
+  // thin darkening noise
+  o_layers[1] = turb(randP, 4.0f) * blendNoise(randPos(pos, 2.0f, 15.0f), 0.01f) * 0.5f;
+  // small variance
+  o_layers[2] = turb(randP, 4.0f) * blendNoise(randP, 2.0f) * 2.0f;
+  // light brushed
+  o_layers[3] = brushed(randP, 0.25f, glm::vec3(20.0f, 1.0f, 1.0f)) * slicednoise(randPos(randP, 2.0f), 0.5f, 5.0f, 0.2f);
+  // dark brushed
+  o_layers[4] = brushed(randP, 0.5f, glm::vec3(5.0f, 25.0f, 1.0f)) * slicednoise(randPos(randP, 3.0f), 0.6f, 3.0f, 0.5f);
+  // rough wood
+  o_layers[5] = veins(randP, 6.0f, 10.0f) * slicednoise(randPos(randP, 1.0f), 0.3f, 3.0f, 1.5f);
+  // veins
+  o_layers[6] = veins(randP, 4.0f, 2.0f) * slicednoise(randPos(randP, 4.0f), 1.0f, 1.25f, 0.15f) * 2.0f;
+  // wood chips
+  o_layers[7] = slicednoise(randP, 2.0f, 0.04f, 0.4f);
+}
+}
+
+//-----------------------------------------------------------------------------------------------------
+OwlNoise::Palette OwlNoise::defaultPalette()
+{
+  Palette palette;
+  palette.m_cols = {{
+    {0.093f,  0.02f, 0.003f, 0.0f},
+    {0.036f, 0.008f, 0.001f, 0.0f},
+    { 0.03f, 0.009f,   0.0f, 0.0f},
+    { 0.08f, 0.002f,   0.0f, 0.0f},
+    {0.703f, 0.188f, 0.108f, 0.0f},
+    {0.707f, 0.090f, 0.021f, 0.0f},
+    {0.960f, 0.436f, 0.149f, 0.0f},
+    {0.843f, 0.326f, 0.176f, 0.0f},
+    {  1.0f,  0.31f, 0.171f, 0.0f}
+  }};
+  return palette;
+}
+//-----------------------------------------------------------------------------------------------------
+void OwlNoise::cnoise(const Points &_points, float* o_noise) noexcept
+{
+  alignas(32) float noise[k_lanes];
+  ::cnoise(loadPoints(_points)).store(noise);
+  std::copy(noise, noise + k_lanes, o_noise);
+}
+//-----------------------------------------------------------------------------------------------------
+void OwlNoise::layers(const Points &_uvw, const Palette &_palette, float* o_layers) noexcept
+{
+  Lanes layers[k_layers];
+  ::layers(_uvw, _palette, layers);
+  alignas(32) float values[k_layers][k_lanes];
+  for (size_t i = 0; i < k_layers; ++i)
+    layers[i].store(values[i]);
+  for (size_t lane = 0; lane < k_lanes; ++lane)
+  {
+    for (size_t i = 0; i < k_layers; ++i)
+      o_layers[lane * k_layers + i] = values[i][lane];
+  }
+}
+//-----------------------------------------------------------------------------------------------------
+glm::vec4 OwlNoise::combineLayers(const float* _layers, const Palette &_palette) noexcept
+{
+  glm::vec4 result = _palette.m_cols[0];
+  for (size_t i = 0; i < k_layers; ++i)
+  {
+    const glm::vec3 colour(_palette.m_cols[i + 1]);
+    const glm::vec3 albedo(result);
+    result = glm::vec4(albedo + (colour - albedo) * _layers[i], result.w + _layers[i]);
+  }
+  return result;
+}
+//-----------------------------------------------------------------------------------------------------
+void OwlNoise::albedoDisp(const Points &_uvw, const Palette &_palette, float* o_albedoDisp) noexcept
+{
+  Lanes layers[k_layers];
+  ::layers(_uvw, _palette, layers);
+
+  const auto& cols = _palette.m_cols;
+  Lanes r = Lanes::broadcast(cols[0].x);
+  Lanes g = Lanes::broadcast(cols[0].y);
+  Lanes b = Lanes::broadcast(cols[0].z);
+  Lanes w = Lanes::broadcast(cols[0].w);
+  for (size_t i = 0; i < k_layers; ++i)
+  {
+    r = mix(r, Lanes::broadcast(cols[i + 1].x), layers[i]);
+    g = mix(g, Lanes::broadcast(cols[i + 1].y), layers[i]);
+    b = mix(b, Lanes::broadcast(cols[i + 1].z), layers[i]);
+    w = w + layers[i];
+  }
+
+  alignas(32) float channels[4][k_lanes];
+  r.store(channels[0]);
+  g.store(channels[1]);
+  b.store(channels[2]);
+  w.store(channels[3]);
+  for (size_t lane = 0; lane < k_lanes; ++lane)
+  {
+    for (size_t channel = 0; channel < 4; ++channel)
+      o_albedoDisp[lane * 4 + channel] = channels[channel][lane];
+  }
+}
+//-----------------------------------------------------------------------------------------------------
+float OwlNoise::cnoise(const glm::vec3 &_point) noexcept
+{
+  float noise[k_lanes];
+  cnoise(broadcastPoint(_point), noise);
+  return noise[0];
+}
+//-----------------------------------------------------------------------------------------------------
+float OwlNoise::turb(const glm::vec3 &_point, const float _frequency) noexcept
+{
+  alignas(32) float turbulence[k_lanes];
+  ::turb(loadPoints(broadcastPoint(_point)), _frequency).store(turbulence);
+  return turbulence[0];
+}
+//-----------------------------------------------------------------------------------------------------
+glm::vec4 OwlNoise::albedoDisp(const glm::vec3 &_uvw, const Palette &_palette) noexcept
+{
+  float albedoDisp[k_lanes * 4];
+  OwlNoise::albedoDisp(broadcastPoint(_uvw), _palette, albedoDisp);
+  return glm::vec4(albedoDisp[0], albedoDisp[1], albedoDisp[2], albedoDisp[3]);
+}
+//-----------------------------------------------------------------------------------------------------
+const char* OwlNoise::instructionSet() noexcept
+{
+#if defined(__AVX2__)
+  return "AVX2";
+#elif defined(__SSE4_1__)
+  return "SSE4.1";
+#elif defined(__SSE2__)
+  return "SSE2";
+#else
+  return "scalar";
+#endif
+}
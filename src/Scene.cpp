@@ -54,6 +54,7 @@ void Scene::init()
 {
   makeCurrent();
   m_camera->setMousePos(0,0);
+  m_frameConstants.init(context(), UniformBindings::FRAME);
 }
 //------------------------------------------------------------------------------------------------------------------------------
 void Scene::paintGL()
@@ -77,9 +78,23 @@ void Scene::renderScene()
   // Scope the using declaration
   {
     using namespace SceneMatrices;
-    m_matrices[PROJECTION] = m_camera->projMatrix() * m_camera->viewMatrix() * m_matrices[MODEL_VIEW];
-    m_matrices[NORMAL] = glm::inverse(glm::transpose(m_matrices[MODEL_VIEW]));
+    const auto& view = m_camera->viewMatrix();
+    const auto& proj = m_camera->projMatrix();
+    m_matrices[PROJECTION] = proj * view * m_matrices[MODEL_VIEW];
+    // The normal matrix only needs to change when the model matrix does
+    if (m_matrices[MODEL_VIEW] != m_frameConstants.get().M)
+    {
+      m_matrices[NORMAL] = glm::inverse(glm::transpose(m_matrices[MODEL_VIEW]));
+      m_frameConstants.set(&FrameConstants::M, m_matrices[MODEL_VIEW]);
+      m_frameConstants.set(&FrameConstants::N, m_matrices[NORMAL]);
+    }
+    m_frameConstants.set(&FrameConstants::V, view);
+    m_frameConstants.set(&FrameConstants::P, proj);
+    m_frameConstants.set(&FrameConstants::MVP, m_matrices[PROJECTION]);
+    m_frameConstants.set(&FrameConstants::camPos, m_camera->getCameraEye());
   }
+  // Send the frame constants to the GPU, only the members that changed are written
+  m_frameConstants.upload();
 }
 //------------------------------------------------------------------------------------------------------------------------------
 
@@ -1,13 +1,28 @@
 #include "ShaderLib.h"
+#include "HashUtils.h"
 #include <QFile>
 #include <QJsonObject>
 #include <QJsonDocument>
+#include <QJsonArray>
+#include <QOpenGLContext>
+#include <QOpenGLFunctions>
+#include <QOpenGLExtraFunctions>
 #include <string>
-#include <fstream>
-#include <streambuf>
-#include <regex>
+#include <iostream>
+#include <algorithm>
+
+#ifndef GL_COMPLETION_STATUS_KHR
+#define GL_COMPLETION_STATUS_KHR 0x91B1
+#endif
 
 std::string ShaderLib::loadShaderProg(const QString &_jsonFileName)
+{
+  auto shaderName = submitShaderProg(_jsonFileName);
+  finalize(shaderName);
+  return shaderName;
+}
+
+std::string ShaderLib::submitShaderProg(const QString &_jsonFileName)
 {
   auto toStr = [](const auto& val){ return val.toString(); };
   // Read in raw file
@@ -22,12 +37,12 @@ std::string ShaderLib::loadShaderProg(const QString &_jsonFileName)
   // Get a string out from the json
   std::string shaderName = shaderParts["Name"].toString().toStdString();
 
-  static constexpr std::array<const char*, 5> shaderNames = {
-    {"Vertex", "Fragment", "Geometry", "TessellationControl", "TessellationEvaluation"}
+  static constexpr std::array<const char*, 6> shaderNames = {
+    {"Vertex", "Fragment", "Geometry", "TessellationControl", "TessellationEvaluation", "Compute"}
   };
-  std::array<QString, 5> shaderPaths;
+  std::array<QString, 6> shaderPaths;
 
-  for (auto shader : {VERTEX, FRAGMENT, GEOMETRY, TESSCONTROL, TESSEVAL})
+  for (auto shader : {VERTEX, FRAGMENT, GEOMETRY, TESSCONTROL, TESSEVAL, COMPUTE})
   {
     auto& name = shaderNames[shader];
     shaderPaths[shader] = shaderParts.contains(name) ? toStr(shaderParts[name]) : "";
@@ -35,118 +50,360 @@ std::string ShaderLib::loadShaderProg(const QString &_jsonFileName)
 
   // Load the shader if we haven't already
   if (!m_shaderPrograms.count(shaderName))
+  {
+    // Store the permutations so that we can build variants later on
+    auto& desc = m_programDescs[shaderName];
+    desc.m_shaderPaths = shaderPaths;
+    const auto permutations = shaderParts["Permutations"].toObject();
+    for (auto key = permutations.begin(); key != permutations.end(); ++key)
+    {
+      auto& defines = desc.m_permutations[key.key().toStdString()];
+      for (const auto& define : key.value().toArray())
+        defines.push_back(define.toString().toStdString());
+    }
     createShader(shaderName, shaderPaths);
+  }
 
   return shaderName;
 }
 
-void ShaderLib::createShader(const std::string &_name, const std::array<QString, 5> &_shaderPaths)
+std::string ShaderLib::submitVariant(
+    const std::string &_name,
+    std::vector<std::string> _keys,
+    const unsigned _stages
+    )
 {
-  QOpenGLShaderProgram *program = new QOpenGLShaderProgram();
+  const auto defines = permutationDefines(_name, _keys);
+  auto variantName = _name + variantSuffix(_keys, _stages);
+  if (m_shaderPrograms.count(variantName)) return variantName;
 
-  using shdr = QOpenGLShader;
-  static constexpr shdr::ShaderType qShaders[] = {
-    shdr::Vertex, shdr::Fragment, shdr::Geometry, shdr::TessellationControl, shdr::TessellationEvaluation
-  };
-  for (auto shader : {VERTEX, FRAGMENT, GEOMETRY, TESSCONTROL, TESSEVAL})
+  // Strip any stages that weren't requested
+  auto shaderPaths = m_programDescs.at(_name).m_shaderPaths;
+  for (auto shader : {VERTEX, FRAGMENT, GEOMETRY, TESSCONTROL, TESSEVAL, COMPUTE})
   {
-    auto path = _shaderPaths[shader];
-    if (path == "") continue;
-    auto stdPath = path.toStdString();
-    if (!m_shaderParts.count(stdPath))
+    if (!(_stages & (1u << shader))) shaderPaths[shader] = "";
+  }
+  createShader(variantName, shaderPaths, defines);
+  return variantName;
+}
+
+std::string ShaderLib::submitPipeline(
+    const std::string &_name,
+    std::vector<std::string> _keys,
+    const unsigned _stages
+    )
+{
+  auto defines = permutationDefines(_name, _keys);
+  auto pipelineName = _name + variantSuffix(_keys, _stages) + "<pipeline>";
+  if (m_pipelines.count(pipelineName)) return pipelineName;
+
+  initParallelCompile();
+  auto funcs = QOpenGLContext::currentContext()->extraFunctions();
+  const auto& shaderPaths = m_programDescs.at(_name).m_shaderPaths;
+  addStageDefines(shaderPaths, _stages, defines);
+
+  auto& pipeline = m_pipelines[pipelineName];
+  for (auto shader : {VERTEX, FRAGMENT, GEOMETRY, TESSCONTROL, TESSEVAL, COMPUTE})
+  {
+    const auto path = shaderPaths[shader].toStdString();
+    if (path.empty() || !(_stages & (1u << shader))) continue;
+
+    // Each stage is linked into it's own separable program, shared by every pipeline that uses it
+    const auto partKey = submitPart(path, shader, defines);
+    const auto stageName = "separable:" + partKey;
+    if (!m_shaderPrograms.count(stageName))
     {
-      QOpenGLShader* shad = new QOpenGLShader(qShaders[shader]);
-      std::string shaderString = loadFileToString(stdPath);
-      parseIncludes(shaderString);
+      QOpenGLShaderProgram *program = new QOpenGLShaderProgram();
+      program->create();
+      funcs->glProgramParameteri(program->programId(), GL_PROGRAM_SEPARABLE, GL_TRUE);
+      funcs->glAttachShader(program->programId(), m_shaderParts[partKey].m_shader->shaderId());
+      funcs->glLinkProgram(program->programId());
+      m_shaderPrograms[stageName].reset(program);
+      m_pendingPrograms[stageName].push_back(partKey);
+    }
+    // The GL stage bits follow the same order as our shader types
+    pipeline.m_stages.emplace_back(1u << shader, stageName);
+  }
+  return pipelineName;
+}
 
-      shad->compileSourceCode(shaderString.c_str());
-      m_shaderParts[stdPath].reset(shad);
+std::vector<std::string> ShaderLib::permutationDefines(const std::string &_name, std::vector<std::string> &io_keys)
+{
+  // Sort the keys so that the order they were given in doesn't create duplicate variants
+  std::sort(io_keys.begin(), io_keys.end());
+  io_keys.erase(std::unique(io_keys.begin(), io_keys.end()), io_keys.end());
+
+  const auto& desc = m_programDescs.at(_name);
+  std::vector<std::string> defines;
+  for (const auto& key : io_keys)
+  {
+    auto permutation = desc.m_permutations.find(key);
+    if (permutation == desc.m_permutations.end())
+    {
+      std::cerr << "Unknown permutation " << key << " for " << _name << '\n';
+      continue;
     }
-    program->addShader(m_shaderParts[stdPath].get());
+    defines.insert(defines.end(), permutation->second.begin(), permutation->second.end());
   }
-  program->link();
-  m_shaderPrograms[_name].reset(program);
+  return defines;
 }
 
-namespace std
+std::string ShaderLib::variantSuffix(const std::vector<std::string> &_keys, const unsigned _stages)
 {
+  std::string suffix;
+  if (!_keys.empty())
+  {
+    suffix += "[";
+    for (const auto& key : _keys)
+      suffix += key + (&key == &_keys.back() ? "]" : ",");
+  }
+  if ((_stages & ALL_STAGES) != ALL_STAGES)
+  {
+    static constexpr char stageLetters[] = {'V', 'F', 'G', 'C', 'E', 'X'};
+    suffix += "{";
+    for (auto shader : {VERTEX, FRAGMENT, GEOMETRY, TESSCONTROL, TESSEVAL, COMPUTE})
+    {
+      if (_stages & (1u << shader)) suffix += stageLetters[shader];
+    }
+    suffix += "}";
+  }
+  return suffix;
+}
 
-template<class BidirIt, class Traits, class CharT, class UnaryFunction>
-std::basic_string<CharT> regex_replace(BidirIt _first, BidirIt _last, const std::basic_regex<CharT,Traits>& _re, UnaryFunction _f)
+void ShaderLib::addStageDefines(
+    const std::array<QString, 6> &_shaderPaths,
+    const unsigned _stages,
+    std::vector<std::string> &io_defines
+    )
 {
-  std::basic_string<CharT> s;
+  auto hasStage = [&](const SHADER_TYPES _shader)
+  {
+    return (_stages & (1u << _shader)) && _shaderPaths[_shader] != "";
+  };
+  // Stages read these to adapt their interfaces when a neighbouring stage is missing
+  if (hasStage(GEOMETRY)) io_defines.push_back("HAS_GEOMETRY");
+  if (hasStage(TESSCONTROL) && hasStage(TESSEVAL)) io_defines.push_back("HAS_TESSELLATION");
+}
 
-  typename std::match_results<BidirIt>::difference_type positionOfLastMatch = 0;
-  auto endOfLastMatch = _first;
+std::string ShaderLib::injectDefines(const std::string &_source, const std::vector<std::string> &_defines)
+{
+  if (_defines.empty()) return _source;
 
-  auto callback = [&](const std::match_results<BidirIt>& match)
+  // Defines must follow the version directive, which can only be preceded by comments and whitespace
+  size_t insertPos = 0;
+  size_t lineNumber = 1;
+  const auto versionPos = _source.find("#version");
+  if (versionPos != std::string::npos)
   {
-    auto positionOfThisMatch = match.position(0);
-    auto diff = positionOfThisMatch - positionOfLastMatch;
+    insertPos = _source.find('\n', versionPos);
+    insertPos = insertPos == std::string::npos ? _source.size() : insertPos + 1;
+    lineNumber += static_cast<size_t>(std::count(_source.begin(), _source.begin() + static_cast<long>(insertPos), '\n'));
+  }
 
-    auto startOfThisMatch = endOfLastMatch;
-    std::advance(startOfThisMatch, diff);
+  std::string defineBlock;
+  for (const auto& define : _defines)
+    defineBlock += "#define " + define + '\n';
+  // The preprocessor numbers the root file as source string 0
+  defineBlock += "#line " + std::to_string(lineNumber) + " 0\n";
 
-    s.append(endOfLastMatch, startOfThisMatch);
-    s.append(_f(match));
+  auto source = _source;
+  if (insertPos == _source.size() && !source.empty() && source.back() != '\n')
+    source += '\n';
+  return source.insert(insertPos, defineBlock);
+}
 
-    auto lengthOfMatch = match.length(0);
+std::string ShaderLib::submitPart(
+    const std::string &_path,
+    const SHADER_TYPES _shader,
+    const std::vector<std::string> &_defines
+    )
+{
+  using shdr = QOpenGLShader;
+  static constexpr shdr::ShaderType qShaders[] = {
+    shdr::Vertex, shdr::Fragment, shdr::Geometry, shdr::TessellationControl, shdr::TessellationEvaluation,
+    shdr::Compute
+  };
+  const auto& processed = m_preprocessor.process(_path);
 
-    positionOfLastMatch = positionOfThisMatch + lengthOfMatch;
+  // Only keep the defines that this stage refers to, so that a stage is shared by every variant it
+  // doesn't care about
+  std::vector<std::string> defines;
+  auto partKey = _path;
+  for (const auto& define : _defines)
+  {
+    if (processed.find(define.substr(0, define.find(' '))) == std::string::npos) continue;
+    defines.push_back(define);
+    partKey += "|" + define;
+  }
+  if (m_shaderParts.count(partKey)) return partKey;
 
-    endOfLastMatch = startOfThisMatch;
-    std::advance(endOfLastMatch, lengthOfMatch);
-  };
+  auto funcs = QOpenGLContext::currentContext()->functions();
+  QOpenGLShader* shad = new QOpenGLShader(qShaders[_shader]);
+  const auto shaderString = injectDefines(processed, defines);
+  // Compile through GL directly, Qt's compileSourceCode reads back the status straight away, which
+  // would wait for the compiler
+  const char* source = shaderString.c_str();
+  funcs->glShaderSource(shad->shaderId(), 1, &source, nullptr);
+  funcs->glCompileShader(shad->shaderId());
+  auto& part = m_shaderParts[partKey];
+  part.m_shader.reset(shad);
+  part.m_path = _path;
+  return partKey;
+}
 
-  std::regex_iterator<BidirIt> begin(_first, _last, _re), end;
-  std::for_each(begin, end, callback);
+void ShaderLib::createShader(
+    const std::string &_name,
+    const std::array<QString, 6> &_shaderPaths,
+    const std::vector<std::string> &_defines
+    )
+{
+  initParallelCompile();
+  auto funcs = QOpenGLContext::currentContext()->functions();
+  QOpenGLShaderProgram *program = new QOpenGLShaderProgram();
+  program->create();
 
-  s.append(endOfLastMatch, _last);
+  auto defines = _defines;
+  addStageDefines(_shaderPaths, ALL_STAGES, defines);
+  auto& stages = m_pendingPrograms[_name];
+  for (auto shader : {VERTEX, FRAGMENT, GEOMETRY, TESSCONTROL, TESSEVAL, COMPUTE})
+  {
+    auto path = _shaderPaths[shader];
+    if (path == "") continue;
+    auto partKey = submitPart(path.toStdString(), shader, defines);
+    funcs->glAttachShader(program->programId(), m_shaderParts[partKey].m_shader->shaderId());
+    stages.push_back(std::move(partKey));
+  }
+  // Linking can be queued straight after the compiles, the driver resolves the dependency
+  funcs->glLinkProgram(program->programId());
+  m_shaderPrograms[_name].reset(program);
+}
 
-  return s;
+bool ShaderLib::isReady(const std::string& _name)
+{
+  // A pipeline is ready once every one of it's stage programs is
+  auto pipeline = m_pipelines.find(_name);
+  if (pipeline != m_pipelines.end())
+  {
+    return std::all_of(pipeline->second.m_stages.begin(), pipeline->second.m_stages.end(), [this](const auto& _stage)
+    {
+      return isReady(_stage.second);
+    });
+  }
+  if (!m_pendingPrograms.count(_name)) return true;
+  // Without the extension we have no way of asking, so assume that the driver is done
+  if (!m_parallelCompile) return true;
+  GLint complete = GL_FALSE;
+  QOpenGLContext::currentContext()->functions()->glGetProgramiv(
+        m_shaderPrograms[_name]->programId(), GL_COMPLETION_STATUS_KHR, &complete);
+  return complete == GL_TRUE;
 }
 
-template<class Traits, class CharT, class UnaryFunction>
-std::string regex_replace(const std::string& s, const std::basic_regex<CharT,Traits>& re, UnaryFunction f)
+uint64_t ShaderLib::sourceHash(const std::string& _name)
 {
-  return regex_replace(s.cbegin(), s.cend(), re, f);
+  uint64_t hash = HashUtils::k_fnvOffset;
+  for (const auto& path : m_programDescs.at(_name).m_shaderPaths)
+  {
+    if (path.isEmpty()) continue;
+    // This is already cached if the program has been submitted
+    const auto stdPath = path.toStdString();
+    m_preprocessor.process(stdPath);
+    const auto stageHash = m_preprocessor.hash(stdPath);
+    hash = HashUtils::fnv1a(&stageHash, sizeof(stageHash), hash);
+  }
+  return hash;
 }
 
-} // namespace std
+void ShaderLib::finalize(const std::string& _name)
+{
+  auto pending = m_pendingPrograms.find(_name);
+  if (pending == m_pendingPrograms.end()) return;
+
+  auto funcs = QOpenGLContext::currentContext()->functions();
+  // Each stage only needs to be checked once, even when it's shared
+  for (const auto& partKey : pending->second)
+  {
+    auto& part = m_shaderParts[partKey];
+    if (part.m_checked) continue;
+    part.m_checked = true;
+
+    const auto id = part.m_shader->shaderId();
+    GLint compiled = GL_FALSE;
+    funcs->glGetShaderiv(id, GL_COMPILE_STATUS, &compiled);
+    if (compiled) continue;
+    GLint logLength = 0;
+    funcs->glGetShaderiv(id, GL_INFO_LOG_LENGTH, &logLength);
+    std::string log(static_cast<size_t>(std::max(logLength, 1)), '\0');
+    funcs->glGetShaderInfoLog(id, logLength, nullptr, &log[0]);
+    std::cerr << "Failed to compile " << partKey << ":\n" << log.c_str() << m_preprocessor.sourceLegend(part.m_path);
+  }
+  m_pendingPrograms.erase(pending);
+
+  // As no QOpenGLShaders were added, Qt reads back our link status rather than linking again
+  auto& program = m_shaderPrograms[_name];
+  if (!program->link())
+    std::cerr << "Failed to link " << _name << ":\n" << program->log().toStdString();
+}
 
-std::string ShaderLib::loadFileToString(const std::string &_path)
+void ShaderLib::initParallelCompile()
 {
-  std::string ret;
-  std::ifstream shaderFileStream(_path);
-  shaderFileStream.seekg(0, std::ios::end);
-  ret.reserve(shaderFileStream.tellg());
-  shaderFileStream.seekg(0, std::ios::beg);
+  if (m_parallelCompileChecked) return;
+  m_parallelCompileChecked = true;
+
+  auto context = QOpenGLContext::currentContext();
+  using MaxThreadsFunc = void (QOPENGLF_APIENTRYP)(GLuint);
+  MaxThreadsFunc maxThreads = nullptr;
+  if (context->hasExtension("GL_KHR_parallel_shader_compile"))
+    maxThreads = reinterpret_cast<MaxThreadsFunc>(context->getProcAddress("glMaxShaderCompilerThreadsKHR"));
+  else if (context->hasExtension("GL_ARB_parallel_shader_compile"))
+    maxThreads = reinterpret_cast<MaxThreadsFunc>(context->getProcAddress("glMaxShaderCompilerThreadsARB"));
 
-  ret.assign((std::istreambuf_iterator<char>(shaderFileStream)), std::istreambuf_iterator<char>());
-  return ret;
+  m_parallelCompile = maxThreads != nullptr;
+  // Let the implementation decide how many threads it should use
+  if (m_parallelCompile)
+    maxThreads(0xFFFFFFFF);
+}
+
+void ShaderLib::usePipeline(const std::string& _name)
+{
+  auto funcs = QOpenGLContext::currentContext()->extraFunctions();
+  auto& pipeline = m_pipelines.at(_name);
+  if (!pipeline.m_id)
+  {
+    // Stages can only be attached once their programs have linked
+    funcs->glGenProgramPipelines(1, &pipeline.m_id);
+    for (const auto& stage : pipeline.m_stages)
+    {
+      finalize(stage.second);
+      funcs->glUseProgramStages(pipeline.m_id, stage.first, m_shaderPrograms[stage.second]->programId());
+    }
+  }
+  // A program bound with glUseProgram takes priority over the pipeline
+  funcs->glUseProgram(0);
+  funcs->glBindProgramPipeline(pipeline.m_id);
+  m_currentShader = m_shaderPrograms[pipeline.m_stages.front().second].get();
 }
 
-void ShaderLib::parseIncludes(std::string &io_shaderString)
+std::vector<QOpenGLShaderProgram*> ShaderLib::getPipelineStages(const std::string& _name)
 {
-  std::regex matcher(R"(#{1}include\ +(\"|\<)[a-zA-Z][a-zA-Z0-9_\/]+\.(h|glsl)(\"|\>))");
-  io_shaderString = std::regex_replace(io_shaderString, matcher, [this](const std::smatch& _m)
+  std::vector<QOpenGLShaderProgram*> programs;
+  for (const auto& stage : m_pipelines.at(_name).m_stages)
   {
-    auto str = _m.str();
-    auto begin = str.find('"') + 1;
-    auto end = str.find_last_of('"');
-    return loadFileToString(std::string(str.begin() + begin, str.begin() + end));
+    finalize(stage.second);
+    programs.push_back(m_shaderPrograms[stage.second].get());
   }
-  );
+  return programs;
 }
 
 void ShaderLib::useShader(const std::string& _name)
 {
+  finalize(_name);
   m_currentShader = m_shaderPrograms[_name].get();
   m_currentShader->bind();
 }
 
 QOpenGLShaderProgram *ShaderLib::getShader(const std::string& _name)
 {
+  finalize(_name);
   return m_shaderPrograms[_name].get();
 }
 
@@ -154,4 +411,3 @@ QOpenGLShaderProgram* ShaderLib::getCurrentShader()
 {
   return m_currentShader;
 }
-
@@ -0,0 +1,247 @@
+#include "ShaderPreprocessor.h"
+#include "HashUtils.h"
+#include <QDir>
+#include <QFileInfo>
+#include <QDateTime>
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <cstdlib>
+
+namespace
+{
+constexpr const char* k_cacheMagic = "CRIMINOWL_GLSL 2";
+
+size_t skipSpaces(const std::string &_str, size_t _pos, const size_t _end)
+{
+  while (_pos < _end && (_str[_pos] == ' ' || _str[_pos] == '\t'))
+    ++_pos;
+  return _pos;
+}
+}
+
+//-----------------------------------------------------------------------------------------------------
+ShaderPreprocessor::ShaderPreprocessor(const std::string &_cacheDir) :
+  m_cacheDir(_cacheDir)
+{}
+//-----------------------------------------------------------------------------------------------------
+const std::string& ShaderPreprocessor::process(const std::string &_path)
+{
+  auto processed = m_processed.find(_path);
+  if (processed != m_processed.end())
+    return processed->second.m_source;
+
+  ProcessedShader shader;
+  if (!loadCached(_path, shader))
+  {
+    std::unordered_set<std::string> included;
+    expand(_path, shader.m_source, shader.m_files, included);
+    // The expanded source changes if, and only if, one of it's files does
+    shader.m_hash = HashUtils::k_fnvOffset;
+    for (const auto& file : shader.m_files)
+    {
+      const auto fileHash = loadFile(file).m_hash;
+      shader.m_hash = HashUtils::fnv1a(&fileHash, sizeof(fileHash), shader.m_hash);
+    }
+    saveCached(_path, shader);
+  }
+  return (m_processed[_path] = std::move(shader)).m_source;
+}
+//-----------------------------------------------------------------------------------------------------
+const std::vector<std::string>& ShaderPreprocessor::sourceFiles(const std::string &_path) const
+{
+  return m_processed.at(_path).m_files;
+}
+//-----------------------------------------------------------------------------------------------------
+std::string ShaderPreprocessor::sourceLegend(const std::string &_path) const
+{
+  std::string legend;
+  const auto& files = sourceFiles(_path);
+  for (size_t i = 0; i < files.size(); ++i)
+    legend += "  source string " + std::to_string(i) + " = " + files[i] + "\n";
+  return legend;
+}
+//-----------------------------------------------------------------------------------------------------
+uint64_t ShaderPreprocessor::hash(const std::string &_path) const
+{
+  return m_processed.at(_path).m_hash;
+}
+//-----------------------------------------------------------------------------------------------------
+void ShaderPreprocessor::clear()
+{
+  m_files.clear();
+  m_processed.clear();
+}
+//-----------------------------------------------------------------------------------------------------
+const ShaderPreprocessor::SourceFile& ShaderPreprocessor::loadFile(const std::string &_path)
+{
+  auto cached = m_files.find(_path);
+  if (cached != m_files.end())
+    return cached->second;
+
+  SourceFile file;
+  std::ifstream fileStream(_path, std::ios::binary);
+  if (!fileStream)
+    std::cerr << "ShaderPreprocessor: could not open " << _path << '\n';
+  std::ostringstream contents;
+  contents << fileStream.rdbuf();
+  file.m_source = contents.str();
+  file.m_hash = HashUtils::fnv1a(file.m_source);
+  return m_files[_path] = std::move(file);
+}
+//-----------------------------------------------------------------------------------------------------
+void ShaderPreprocessor::expand(
+    const std::string &_path,
+    std::string &o_out,
+    std::vector<std::string> &io_files,
+    std::unordered_set<std::string> &io_included
+    )
+{
+  // Node based map, so this reference survives any files loaded by nested includes
+  const auto& source = loadFile(_path).m_source;
+  const auto fileId = std::to_string(io_files.size());
+  io_files.push_back(_path);
+  io_included.insert(_path);
+
+  o_out.reserve(o_out.size() + source.size());
+  bool inBlockComment = false;
+  size_t lineNumber = 1;
+  size_t lineStart = 0;
+  while (lineStart < source.size())
+  {
+    auto lineEnd = source.find('\n', lineStart);
+    if (lineEnd == std::string::npos) lineEnd = source.size();
+
+    // Directives must be the first thing on a line, and can't be inside a block comment
+    bool isInclude = false;
+    std::string includePath;
+    if (!inBlockComment)
+    {
+      auto pos = skipSpaces(source, lineStart, lineEnd);
+      if (pos < lineEnd && source[pos] == '#')
+      {
+        pos = skipSpaces(source, pos + 1, lineEnd);
+        // The keyword must end there, so directives such as #include_foo or #includes aren't matched
+        const auto keywordEnd = pos + 7;
+        const bool isKeyword = source.compare(pos, 7, "include") == 0 && keywordEnd < lineEnd &&
+            (source[keywordEnd] == ' ' || source[keywordEnd] == '\t' || source[keywordEnd] == '"' || source[keywordEnd] == '<');
+        if (isKeyword)
+        {
+          pos = skipSpaces(source, pos + 7, lineEnd);
+          const char close = pos < lineEnd ? (source[pos] == '"' ? '"' : (source[pos] == '<' ? '>' : 0)) : 0;
+          const auto closePos = close ? source.find(close, pos + 1) : std::string::npos;
+          if (closePos < lineEnd)
+          {
+            isInclude = true;
+            includePath = source.substr(pos + 1, closePos - pos - 1);
+          }
+        }
+      }
+    }
+
+    if (isInclude)
+    {
+      // Every file is only included once per shader, which also stops include cycles
+      if (!io_included.count(includePath))
+      {
+        o_out += "#line 1 " + std::to_string(io_files.size()) + '\n';
+        expand(includePath, o_out, io_files, io_included);
+        if (!o_out.empty() && o_out.back() != '\n')
+          o_out += '\n';
+        o_out += "#line " + std::to_string(lineNumber + 1) + ' ' + fileId + '\n';
+      }
+      else
+      {
+        // Keep the line count intact
+        o_out += '\n';
+      }
+    }
+    else
+    {
+      // Track block comments so that commented out includes are ignored
+      for (auto i = lineStart; i < lineEnd; ++i)
+      {
+        const char next = i + 1 < lineEnd ? source[i + 1] : '\0';
+        if (inBlockComment)
+        {
+          if (source[i] == '*' && next == '/') { inBlockComment = false; ++i; }
+        }
+        else if (source[i] == '/')
+        {
+          if (next == '/') break;
+          if (next == '*') { inBlockComment = true; ++i; }
+        }
+      }
+      o_out.append(source, lineStart, lineEnd - lineStart);
+      o_out += '\n';
+    }
+
+    lineStart = lineEnd + 1;
+    ++lineNumber;
+  }
+}
+//-----------------------------------------------------------------------------------------------------
+std::string ShaderPreprocessor::cachePath(const std::string &_path) const
+{
+  return m_cacheDir + "/" + HashUtils::toHex(HashUtils::fnv1a(_path)) + ".glsl";
+}
+//-----------------------------------------------------------------------------------------------------
+bool ShaderPreprocessor::loadCached(const std::string &_path, ProcessedShader &o_shader)
+{
+  if (m_cacheDir.empty()) return false;
+  std::ifstream cacheStream(cachePath(_path), std::ios::binary);
+  if (!cacheStream) return false;
+
+  std::string line;
+  if (!std::getline(cacheStream, line) || line != k_cacheMagic) return false;
+  size_t numFiles = 0;
+  if (!std::getline(cacheStream, line)) return false;
+  numFiles = std::strtoul(line.c_str(), nullptr, 10);
+
+  // Every file that went into the cached source must still have the size and modification time it had
+  // when the cache was written, so a hit reads nothing but the cache. Any change expands the shader
+  // again, which rehashes and restamps it's files
+  std::vector<std::string> files;
+  files.reserve(numFiles);
+  uint64_t combined = HashUtils::k_fnvOffset;
+  for (size_t i = 0; i < numFiles; ++i)
+  {
+    if (!std::getline(cacheStream, line)) return false;
+    std::istringstream entry(line);
+    std::string hashHex, file;
+    long long size = 0, modified = 0;
+    if (!(entry >> hashHex >> size >> modified) || !std::getline(entry >> std::ws, file)) return false;
+    const QFileInfo info(QString::fromStdString(file));
+    if (!info.exists() || info.size() != size || info.lastModified().toMSecsSinceEpoch() != modified) return false;
+    const uint64_t fileHash = std::strtoull(hashHex.c_str(), nullptr, 16);
+    combined = HashUtils::fnv1a(&fileHash, sizeof(fileHash), combined);
+    files.push_back(file);
+  }
+  if (files.empty() || files[0] != _path) return false;
+
+  if (!std::getline(cacheStream, line)) return false;
+  std::string source(std::strtoul(line.c_str(), nullptr, 10), '\0');
+  if (!cacheStream.read(&source[0], static_cast<std::streamsize>(source.size()))) return false;
+
+  o_shader.m_source = std::move(source);
+  o_shader.m_files = std::move(files);
+  o_shader.m_hash = combined;
+  return true;
+}
+//-----------------------------------------------------------------------------------------------------
+void ShaderPreprocessor::saveCached(const std::string &_path, const ProcessedShader &_shader) const
+{
+  if (m_cacheDir.empty() || !QDir().mkpath(QString::fromStdString(m_cacheDir))) return;
+  std::ofstream cacheStream(cachePath(_path), std::ios::binary | std::ios::trunc);
+  if (!cacheStream) return;
+
+  cacheStream << k_cacheMagic << '\n' << _shader.m_files.size() << '\n';
+  for (const auto& file : _shader.m_files)
+  {
+    const QFileInfo info(QString::fromStdString(file));
+    cacheStream << HashUtils::toHex(m_files.at(file).m_hash) << ' ' << info.size() << ' '
+                << info.lastModified().toMSecsSinceEpoch() << ' ' << file << '\n';
+  }
+  cacheStream << _shader.m_source.size() << '\n';
+  cacheStream.write(_shader.m_source.data(), static_cast<std::streamsize>(_shader.m_source.size()));
+}
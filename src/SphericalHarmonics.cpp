@@ -0,0 +1,181 @@
+#include "SphericalHarmonics.h"
+#include "ThreadPool.h"
+#include "HalfFloat.h"
+#include <QDir>
+#include <QFileInfo>
+#include <vector>
+#include <fstream>
+#include <cstring>
+#include <cmath>
+
+namespace
+{
+constexpr float k_pi = 3.14159265359f;
+constexpr char k_magic[8] = {'C', 'W', 'S', 'H', '9', '0', '0', '1'};
+
+//-----------------------------------------------------------------------------------------------------
+/// @brief Writes the 9 real SH basis values for a normalized direction.
+//-----------------------------------------------------------------------------------------------------
+inline void basis(const float _x, const float _y, const float _z, float* o_basis) noexcept
+{
+  o_basis[0] = 0.282095f;
+  o_basis[1] = 0.488603f * _y;
+  o_basis[2] = 0.488603f * _z;
+  o_basis[3] = 0.488603f * _x;
+  o_basis[4] = 1.092548f * _x * _y;
+  o_basis[5] = 1.092548f * _y * _z;
+  o_basis[6] = 0.315392f * (3.0f * _z * _z - 1.0f);
+  o_basis[7] = 1.092548f * _x * _z;
+  o_basis[8] = 0.546274f * (_x * _x - _y * _y);
+}
+
+//-----------------------------------------------------------------------------------------------------
+/// @brief Shared projection, _loadRow returns a row of float pixels and may convert into the scratch.
+//-----------------------------------------------------------------------------------------------------
+template <typename LoadRow>
+IrradianceSH project(
+    const int _width,
+    const int _height,
+    const int _components,
+    ThreadPool &io_pool,
+    const LoadRow &_loadRow
+    )
+{
+  const auto width = static_cast<size_t>(_width);
+  const auto height = static_cast<size_t>(_height);
+  const auto components = static_cast<size_t>(_components);
+
+  // Every row shares the same longitudes, so the trig is only done once per column
+  std::vector<float> cosPhi(width), sinPhi(width);
+  for (size_t c = 0; c < width; ++c)
+  {
+    // Matches sampleSphericalMap, u = atan(z, x) / 2pi + 0.5
+    const float phi = ((static_cast<float>(c) + 0.5f) / _width - 0.5f) * 2.0f * k_pi;
+    cosPhi[c] = std::cos(phi);
+    sinPhi[c] = std::sin(phi);
+  }
+
+  // One partial sum per row, so the reduction is deterministic whatever the thread count
+  std::vector<std::array<float, 27>> rowSums(height);
+  const float pixelArea = (2.0f * k_pi / _width) * (k_pi / _height);
+  io_pool.parallelFor(height, [&](size_t _begin, size_t _end)
+  {
+    float shBasis[9];
+    std::vector<float> scratch;
+    for (size_t r = _begin; r < _end; ++r)
+    {
+      // v = asin(y) / pi + 0.5, with row 0 at the bottom
+      const float latitude = ((static_cast<float>(r) + 0.5f) / _height - 0.5f) * k_pi;
+      const float y = std::sin(latitude);
+      const float cosLat = std::cos(latitude);
+      // The solid angle of a pixel shrinks towards the poles
+      const float weight = pixelArea * cosLat;
+
+      // Flat accumulators, which the compiler is free to keep in vector registers
+      float acc[27] = {};
+      const float* row = _loadRow(r, scratch);
+      for (size_t c = 0; c < width; ++c)
+      {
+        basis(cosPhi[c] * cosLat, y, sinPhi[c] * cosLat, shBasis);
+        const float* pixel = row + c * components;
+        for (int i = 0; i < 9; ++i)
+        {
+          acc[i * 3 + 0] += pixel[0] * shBasis[i];
+          acc[i * 3 + 1] += pixel[1] * shBasis[i];
+          acc[i * 3 + 2] += pixel[2] * shBasis[i];
+        }
+      }
+      for (int i = 0; i < 27; ++i)
+        rowSums[r][static_cast<size_t>(i)] = acc[i] * weight;
+    }
+  }, 16);
+
+  double total[27] = {};
+  for (const auto& rowSum : rowSums)
+  {
+    for (size_t i = 0; i < 27; ++i)
+      total[i] += rowSum[i];
+  }
+
+  IrradianceSH sh;
+  for (size_t i = 0; i < 9; ++i)
+    sh.coeffs[i] = glm::vec4(total[i * 3], total[i * 3 + 1], total[i * 3 + 2], 0.0f);
+  return sh;
+}
+}
+
+//-----------------------------------------------------------------------------------------------------
+IrradianceSH SphericalHarmonics::projectEquirect(
+    const float* _pixels,
+    const int _width,
+    const int _height,
+    const int _components,
+    ThreadPool &io_pool
+    )
+{
+  const auto rowSize = static_cast<size_t>(_width) * static_cast<size_t>(_components);
+  return project(_width, _height, _components, io_pool, [_pixels, rowSize](size_t _row, std::vector<float>&)
+  {
+    return _pixels + _row * rowSize;
+  });
+}
+//-----------------------------------------------------------------------------------------------------
+IrradianceSH SphericalHarmonics::projectEquirect(
+    const uint16_t* _halfPixels,
+    const int _width,
+    const int _height,
+    const int _components,
+    ThreadPool &io_pool
+    )
+{
+  const auto rowSize = static_cast<size_t>(_width) * static_cast<size_t>(_components);
+  return project(_width, _height, _components, io_pool, [_halfPixels, rowSize](size_t _row, std::vector<float> &io_scratch)
+  {
+    // Widen one row at a time, so we never hold a float copy of the whole image
+    io_scratch.resize(rowSize);
+    HalfFloat::toFloats(_halfPixels + _row * rowSize, io_scratch.data(), rowSize);
+    return static_cast<const float*>(io_scratch.data());
+  });
+}
+//-----------------------------------------------------------------------------------------------------
+void SphericalHarmonics::convolveIrradiance(IrradianceSH &io_sh) noexcept
+{
+  // Cosine lobe band factors (pi, 2pi/3, pi/4), divided through by pi
+  static constexpr float bandScale[9] = {
+    1.0f,
+    2.0f / 3.0f, 2.0f / 3.0f, 2.0f / 3.0f,
+    0.25f, 0.25f, 0.25f, 0.25f, 0.25f
+  };
+  for (size_t i = 0; i < 9; ++i)
+    io_sh.coeffs[i] *= bandScale[i];
+}
+//-----------------------------------------------------------------------------------------------------
+glm::vec3 SphericalHarmonics::evaluate(const IrradianceSH &_sh, const glm::vec3 &_dir) noexcept
+{
+  float shBasis[9];
+  basis(_dir.x, _dir.y, _dir.z, shBasis);
+  glm::vec3 result(0.0f);
+  for (size_t i = 0; i < 9; ++i)
+    result += glm::vec3(_sh.coeffs[i]) * shBasis[i];
+  return result;
+}
+//-----------------------------------------------------------------------------------------------------
+bool SphericalHarmonics::load(const std::string &_path, IrradianceSH &o_sh)
+{
+  std::ifstream file(_path, std::ios::binary);
+  if (!file) return false;
+  char magic[sizeof(k_magic)];
+  if (!file.read(magic, sizeof(magic)) || std::memcmp(magic, k_magic, sizeof(k_magic)) != 0) return false;
+  return static_cast<bool>(file.read(reinterpret_cast<char*>(&o_sh), sizeof(o_sh)));
+}
+//-----------------------------------------------------------------------------------------------------
+bool SphericalHarmonics::save(const std::string &_path, const IrradianceSH &_sh)
+{
+  const auto dir = QFileInfo(QString::fromStdString(_path)).absolutePath();
+  if (!QDir().mkpath(dir)) return false;
+  std::ofstream file(_path, std::ios::binary | std::ios::trunc);
+  if (!file) return false;
+  file.write(k_magic, sizeof(k_magic));
+  file.write(reinterpret_cast<const char*>(&_sh), sizeof(_sh));
+  return static_cast<bool>(file);
+}
@@ -0,0 +1,119 @@
+#include "TextureFile.h"
+#include <QDir>
+#include <QFileInfo>
+#include <fstream>
+#include <algorithm>
+
+namespace
+{
+constexpr char k_magic[8] = {'C', 'W', 'T', 'E', 'X', '0', '0', '1'};
+
+//-----------------------------------------------------------------------------------------------------
+/// @brief The level index entry, offsets are from the start of the file.
+//-----------------------------------------------------------------------------------------------------
+struct LevelIndex
+{
+  uint64_t m_offset;
+  uint64_t m_size;
+};
+}
+
+//-----------------------------------------------------------------------------------------------------
+TextureFile::TextureFile(const Header &_header) :
+  m_header(_header)
+{
+  m_levels.resize(m_header.m_levels);
+  for (uint32_t level = 0; level < m_header.m_levels; ++level)
+    m_levels[level].resize(faceSize(level) * m_header.m_faces);
+}
+//-----------------------------------------------------------------------------------------------------
+bool TextureFile::load(const std::string &_path)
+{
+  std::ifstream file(_path, std::ios::binary);
+  if (!file) return false;
+
+  char magic[sizeof(k_magic)];
+  Header header;
+  if (!file.read(magic, sizeof(magic)) || !std::equal(magic, magic + sizeof(magic), k_magic)) return false;
+  if (!file.read(reinterpret_cast<char*>(&header), sizeof(header))) return false;
+
+  // Guard against allocating something absurd from a corrupt header
+  if (header.m_levels > 32 || header.m_faces > 2048 || header.m_bytesPerPixel > 16) return false;
+
+  std::vector<LevelIndex> index(header.m_levels);
+  if (!file.read(reinterpret_cast<char*>(index.data()), static_cast<std::streamsize>(index.size() * sizeof(LevelIndex))))
+    return false;
+
+  TextureFile texture(header);
+  for (uint32_t level = 0; level < header.m_levels; ++level)
+  {
+    auto& pixels = texture.m_levels[level];
+    // Reject anything that doesn't match the header, rather than reading garbage
+    if (index[level].m_size != pixels.size()) return false;
+    file.seekg(static_cast<std::streamoff>(index[level].m_offset));
+    if (!file.read(reinterpret_cast<char*>(pixels.data()), static_cast<std::streamsize>(pixels.size()))) return false;
+  }
+  *this = std::move(texture);
+  return true;
+}
+//-----------------------------------------------------------------------------------------------------
+bool TextureFile::save(const std::string &_path) const
+{
+  QDir().mkpath(QFileInfo(QString::fromStdString(_path)).absolutePath());
+  std::ofstream file(_path, std::ios::binary | std::ios::trunc);
+  if (!file) return false;
+
+  std::vector<LevelIndex> index(m_header.m_levels);
+  uint64_t offset = sizeof(k_magic) + sizeof(Header) + index.size() * sizeof(LevelIndex);
+  for (uint32_t level = 0; level < m_header.m_levels; ++level)
+  {
+    index[level] = {offset, m_levels[level].size()};
+    offset += m_levels[level].size();
+  }
+
+  file.write(k_magic, sizeof(k_magic));
+  file.write(reinterpret_cast<const char*>(&m_header), sizeof(m_header));
+  file.write(reinterpret_cast<const char*>(index.data()), static_cast<std::streamsize>(index.size() * sizeof(LevelIndex)));
+  for (const auto& pixels : m_levels)
+    file.write(reinterpret_cast<const char*>(pixels.data()), static_cast<std::streamsize>(pixels.size()));
+  return static_cast<bool>(file);
+}
+//-----------------------------------------------------------------------------------------------------
+const TextureFile::Header& TextureFile::header() const noexcept
+{
+  return m_header;
+}
+//-----------------------------------------------------------------------------------------------------
+bool TextureFile::isCompressed() const noexcept
+{
+  return !m_header.m_pixelFormat;
+}
+//-----------------------------------------------------------------------------------------------------
+uint32_t TextureFile::levelDim(const uint32_t _dim, const uint32_t _level) noexcept
+{
+  return std::max(_dim >> _level, 1u);
+}
+//-----------------------------------------------------------------------------------------------------
+size_t TextureFile::faceSize(const uint32_t _level) const noexcept
+{
+  // Blocks cover 4x4 texels of each slice, partial blocks at the edges are stored whole
+  if (isCompressed())
+    return static_cast<size_t>((levelDim(m_header.m_width, _level) + 3) / 4) *
+        ((levelDim(m_header.m_height, _level) + 3) / 4) *
+        levelDim(m_header.m_depth, _level) *
+        m_header.m_bytesPerPixel;
+  return static_cast<size_t>(levelDim(m_header.m_width, _level)) *
+      levelDim(m_header.m_height, _level) *
+      levelDim(m_header.m_depth, _level) *
+      m_header.m_bytesPerPixel;
+}
+//-----------------------------------------------------------------------------------------------------
+unsigned char* TextureFile::data(const uint32_t _level, const uint32_t _face) noexcept
+{
+  return m_levels[_level].data() + faceSize(_level) * _face;
+}
+//-----------------------------------------------------------------------------------------------------
+const unsigned char* TextureFile::data(const uint32_t _level, const uint32_t _face) const noexcept
+{
+  return m_levels[_level].data() + faceSize(_level) * _face;
+}
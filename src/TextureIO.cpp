@@ -0,0 +1,189 @@
+#include "TextureIO.h"
+#include <QOpenGLFunctions_4_3_Core>
+#include <QOpenGLPixelTransferOptions>
+#include <algorithm>
+#include <chrono>
+
+namespace
+{
+//-----------------------------------------------------------------------------------------------------
+/// @brief Copies the pixels of a mapped read back buffer in to a file, this needs no GL context.
+//-----------------------------------------------------------------------------------------------------
+void copyPixels(const unsigned char* _pixels, TextureFile &io_file)
+{
+  // The faces were packed one after another, in the same order as the file
+  const auto& header = io_file.header();
+  size_t offset = 0;
+  for (uint32_t level = 0; level < header.m_levels; ++level)
+  {
+    for (uint32_t face = 0; face < header.m_faces; ++face)
+    {
+      std::copy_n(_pixels + offset, io_file.faceSize(level), io_file.data(level, face));
+      offset += io_file.faceSize(level);
+    }
+  }
+}
+//-----------------------------------------------------------------------------------------------------
+/// @brief Maps a read back's buffer, which waits for the GPU if the pixels haven't landed yet.
+//-----------------------------------------------------------------------------------------------------
+const unsigned char* mapDownload(TextureIO::Download &io_download)
+{
+  auto& buffer = io_download.m_buffer;
+  buffer.bind();
+  const auto pixels = static_cast<const unsigned char*>(buffer.mapRange(0, buffer.size(), QOpenGLBuffer::RangeRead));
+  buffer.release();
+  if (!pixels)
+    buffer.destroy();
+  return pixels;
+}
+//-----------------------------------------------------------------------------------------------------
+/// @brief Unmaps and frees a read back's buffer, once it's pixels have been copied out.
+//-----------------------------------------------------------------------------------------------------
+void releaseDownload(TextureIO::Download &io_download)
+{
+  auto& buffer = io_download.m_buffer;
+  buffer.bind();
+  buffer.unmap();
+  buffer.release();
+  buffer.destroy();
+}
+}
+//-----------------------------------------------------------------------------------------------------
+TextureFile TextureIO::download(
+    QOpenGLContext* io_context,
+    QOpenGLTexture &_texture,
+    const QOpenGLTexture::PixelFormat _pixelFormat,
+    const QOpenGLTexture::PixelType _pixelType,
+    const uint32_t _bytesPerPixel
+    )
+{
+  // Mapping the buffer waits for the copy, so we have no need for the fence
+  Download download;
+  beginDownload(io_context, _texture, _pixelFormat, _pixelType, _bytesPerPixel, download);
+  io_context->versionFunctions<QOpenGLFunctions_4_3_Core>()->glDeleteSync(download.m_fence);
+  if (const auto pixels = mapDownload(download))
+  {
+    copyPixels(pixels, download.m_file);
+    releaseDownload(download);
+  }
+  return std::move(download.m_file);
+}
+//-----------------------------------------------------------------------------------------------------
+void TextureIO::beginDownload(
+    QOpenGLContext* io_context,
+    QOpenGLTexture &_texture,
+    const QOpenGLTexture::PixelFormat _pixelFormat,
+    const QOpenGLTexture::PixelType _pixelType,
+    const uint32_t _bytesPerPixel,
+    Download &o_download
+    )
+{
+  auto funcs = io_context->versionFunctions<QOpenGLFunctions_4_3_Core>();
+  const bool isCube = _texture.target() == QOpenGLTexture::TargetCubeMap;
+
+  TextureFile::Header header;
+  header.m_target = _texture.target();
+  header.m_internalFormat = _texture.format();
+  header.m_pixelFormat = _pixelFormat;
+  header.m_pixelType = _pixelType;
+  header.m_width = static_cast<uint32_t>(_texture.width());
+  header.m_height = static_cast<uint32_t>(_texture.height());
+  header.m_depth = static_cast<uint32_t>(std::max(_texture.depth(), 1));
+  header.m_faces = isCube ? 6 : 1;
+  header.m_levels = static_cast<uint32_t>(_texture.mipLevels());
+  header.m_bytesPerPixel = _bytesPerPixel;
+  o_download.m_file = TextureFile(header);
+  const auto& file = o_download.m_file;
+  size_t size = 0;
+  for (uint32_t level = 0; level < header.m_levels; ++level)
+    size += file.faceSize(level) * header.m_faces;
+
+  auto& buffer = o_download.m_buffer;
+  buffer = QOpenGLBuffer(QOpenGLBuffer::PixelPackBuffer);
+  buffer.create();
+  buffer.bind();
+  buffer.setUsagePattern(QOpenGLBuffer::StreamRead);
+  buffer.allocate(static_cast<int>(size));
+
+  _texture.bind();
+  // Our rows are tightly packed, with a pack buffer bound the pointers are offsets in to it
+  funcs->glPixelStorei(GL_PACK_ALIGNMENT, 1);
+  size_t offset = 0;
+  for (uint32_t level = 0; level < header.m_levels; ++level)
+  {
+    for (uint32_t face = 0; face < header.m_faces; ++face)
+    {
+      const GLenum target = isCube ? GL_TEXTURE_CUBE_MAP_POSITIVE_X + face : header.m_target;
+      funcs->glGetTexImage(target, static_cast<GLint>(level), _pixelFormat, _pixelType, reinterpret_cast<GLvoid*>(offset));
+      offset += file.faceSize(level);
+    }
+  }
+  funcs->glPixelStorei(GL_PACK_ALIGNMENT, 4);
+  buffer.release();
+  // Flushing makes sure the fence is signalled eventually, as we only ever poll it
+  o_download.m_fence = funcs->glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+  funcs->glFlush();
+}
+//-----------------------------------------------------------------------------------------------------
+bool TextureIO::finishDownload(QOpenGLContext* io_context, Download &io_download, ThreadPool &io_pool)
+{
+  if (io_download.m_copy.valid())
+  {
+    if (io_download.m_copy.wait_for(std::chrono::seconds(0)) != std::future_status::ready) return false;
+    io_download.m_copy.get();
+    releaseDownload(io_download);
+    return true;
+  }
+  if (!io_download.m_fence) return true;
+  auto funcs = io_context->versionFunctions<QOpenGLFunctions_4_3_Core>();
+  // A timeout of zero only checks the fence
+  if (funcs->glClientWaitSync(io_download.m_fence, 0, 0) == GL_TIMEOUT_EXPIRED) return false;
+  funcs->glDeleteSync(io_download.m_fence);
+  io_download.m_fence = nullptr;
+  const auto pixels = mapDownload(io_download);
+  if (!pixels) return true;
+  // A pool can be hundreds of MB, so the copy runs on a worker while the buffer stays mapped
+  auto& file = io_download.m_file;
+  io_download.m_copy = io_pool.submit([pixels, &file] { copyPixels(pixels, file); });
+  return false;
+}
+//-----------------------------------------------------------------------------------------------------
+void TextureIO::upload(const TextureFile &_file, std::unique_ptr<QOpenGLTexture> &o_texture)
+{
+  using tex = QOpenGLTexture;
+  const auto& header = _file.header();
+  const bool isCube = header.m_target == tex::TargetCubeMap;
+  const auto pixelFormat = static_cast<tex::PixelFormat>(header.m_pixelFormat);
+  const auto pixelType = static_cast<tex::PixelType>(header.m_pixelType);
+
+  o_texture.reset(new QOpenGLTexture(static_cast<tex::Target>(header.m_target)));
+  o_texture->create();
+  o_texture->bind();
+  o_texture->setSize(static_cast<int>(header.m_width), static_cast<int>(header.m_height), static_cast<int>(header.m_depth));
+  o_texture->setFormat(static_cast<tex::TextureFormat>(header.m_internalFormat));
+  o_texture->setMipLevels(static_cast<int>(header.m_levels));
+  // Compressed formats have no pixel format or type to allocate with
+  if (_file.isCompressed())
+    o_texture->allocateStorage();
+  else
+    o_texture->allocateStorage(pixelFormat, pixelType);
+
+  QOpenGLPixelTransferOptions options;
+  options.setAlignment(1);
+  for (uint32_t level = 0; level < header.m_levels; ++level)
+  {
+    for (uint32_t face = 0; face < header.m_faces; ++face)
+    {
+      const auto cubeFace = static_cast<tex::CubeMapFace>(tex::CubeMapPositiveX + face);
+      const auto faceSize = static_cast<int>(_file.faceSize(level));
+      if (_file.isCompressed() && isCube)
+        o_texture->setCompressedData(static_cast<int>(level), 0, cubeFace, faceSize, _file.data(level, face), &options);
+      else if (_file.isCompressed())
+        o_texture->setCompressedData(static_cast<int>(level), faceSize, _file.data(level, face), &options);
+      else if (isCube)
+        o_texture->setData(static_cast<int>(level), 0, cubeFace, pixelFormat, pixelType, _file.data(level, face), &options);
+      else
+        o_texture->setData(static_cast<int>(level), pixelFormat, pixelType, _file.data(level, face), &options);
+    }
+  }
+}
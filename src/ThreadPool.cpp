@@ -0,0 +1,107 @@
+#include "ThreadPool.h"
+#include <atomic>
+#include <algorithm>
+
+//-----------------------------------------------------------------------------------------------------
+ThreadPool::ThreadPool(const unsigned _numThreads)
+{
+  const auto numThreads = _numThreads ? _numThreads : std::max(std::thread::hardware_concurrency(), 1u);
+  m_workers.reserve(numThreads);
+  for (unsigned i = 0; i < numThreads; ++i)
+    m_workers.emplace_back([this]{ workerLoop(); });
+}
+//-----------------------------------------------------------------------------------------------------
+ThreadPool::~ThreadPool()
+{
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_stop = true;
+  }
+  m_condition.notify_all();
+  for (auto& worker : m_workers)
+    worker.join();
+}
+//-----------------------------------------------------------------------------------------------------
+ThreadPool& ThreadPool::instance()
+{
+  static ThreadPool pool;
+  return pool;
+}
+//-----------------------------------------------------------------------------------------------------
+std::future<void> ThreadPool::submit(std::function<void()> _task)
+{
+  std::packaged_task<void()> task(std::move(_task));
+  auto future = task.get_future();
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_tasks.push_back(std::move(task));
+  }
+  m_condition.notify_one();
+  return future;
+}
+//-----------------------------------------------------------------------------------------------------
+void ThreadPool::parallelFor(
+    const size_t _count,
+    const std::function<void(size_t _begin, size_t _end)> &_func,
+    const size_t _grain
+    )
+{
+  if (!_count) return;
+  // A few chunks per thread evens out any imbalance in the work
+  const size_t numChunks = std::max<size_t>(std::min<size_t>(m_workers.size() * 4, _count / std::max<size_t>(_grain, 1)), 1);
+  const size_t chunkSize = (_count + numChunks - 1) / numChunks;
+
+  // Shared, so that helpers which start after we've returned never touch our stack
+  struct State
+  {
+    std::atomic<size_t> m_next {0};
+    std::atomic<size_t> m_done {0};
+    std::mutex m_mutex;
+    std::condition_variable m_finished;
+  };
+  auto state = std::make_shared<State>();
+  auto func = std::make_shared<std::function<void(size_t, size_t)>>(_func);
+  auto work = [state, func, numChunks, chunkSize, _count]
+  {
+    for (size_t chunk = state->m_next++; chunk < numChunks; chunk = state->m_next++)
+    {
+      const size_t begin = chunk * chunkSize;
+      (*func)(begin, std::min(begin + chunkSize, _count));
+      if (++state->m_done == numChunks)
+      {
+        std::lock_guard<std::mutex> lock(state->m_mutex);
+        state->m_finished.notify_all();
+      }
+    }
+  };
+
+  const auto numHelpers = std::min<size_t>(m_workers.size(), numChunks - 1);
+  for (size_t i = 0; i < numHelpers; ++i)
+    submit(work);
+  // The calling thread works too, which also means nested calls can't deadlock
+  work();
+
+  std::unique_lock<std::mutex> lock(state->m_mutex);
+  state->m_finished.wait(lock, [&state, numChunks]{ return state->m_done == numChunks; });
+}
+//-----------------------------------------------------------------------------------------------------
+unsigned ThreadPool::size() const noexcept
+{
+  return static_cast<unsigned>(m_workers.size());
+}
+//-----------------------------------------------------------------------------------------------------
+void ThreadPool::workerLoop()
+{
+  for (;;)
+  {
+    std::packaged_task<void()> task;
+    {
+      std::unique_lock<std::mutex> lock(m_mutex);
+      m_condition.wait(lock, [this]{ return m_stop || !m_tasks.empty(); });
+      if (m_stop && m_tasks.empty()) return;
+      task = std::move(m_tasks.front());
+      m_tasks.pop_front();
+    }
+    task();
+  }
+}
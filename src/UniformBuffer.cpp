@@ -0,0 +1,61 @@
+#include "UniformBuffer.h"
+#include <QOpenGLFunctions_4_3_Core>
+
+//-----------------------------------------------------------------------------------------------------
+void UniformBuffer::init(QOpenGLContext* io_context, const GLuint _binding, const int _size, const void* _data)
+{
+  m_context = io_context;
+  m_binding = _binding;
+  m_size = _size;
+
+  m_buffer.create();
+  m_buffer.bind();
+  m_buffer.setUsagePattern(QOpenGLBuffer::DynamicDraw);
+  m_buffer.allocate(_data, m_size);
+  m_buffer.release();
+  // Everything has just been sent
+  m_dirtyBegin = m_dirtyEnd = 0;
+  bind();
+}
+//-----------------------------------------------------------------------------------------------------
+void UniformBuffer::markDirty(const int _offset, const int _size) noexcept
+{
+  if (!isDirty())
+  {
+    m_dirtyBegin = _offset;
+    m_dirtyEnd = _offset + _size;
+    return;
+  }
+  // Grow the range to cover the new change, a single write is cheaper than many small ones
+  m_dirtyBegin = std::min(m_dirtyBegin, _offset);
+  m_dirtyEnd = std::max(m_dirtyEnd, _offset + _size);
+}
+//-----------------------------------------------------------------------------------------------------
+void UniformBuffer::markAllDirty() noexcept
+{
+  m_dirtyBegin = 0;
+  m_dirtyEnd = m_size;
+}
+//-----------------------------------------------------------------------------------------------------
+void UniformBuffer::upload(const void* _data)
+{
+  if (isDirty())
+  {
+    m_buffer.bind();
+    m_buffer.write(m_dirtyBegin, static_cast<const char*>(_data) + m_dirtyBegin, m_dirtyEnd - m_dirtyBegin);
+    m_buffer.release();
+    m_dirtyBegin = m_dirtyEnd = 0;
+  }
+  bind();
+}
+//-----------------------------------------------------------------------------------------------------
+void UniformBuffer::bind()
+{
+  auto funcs = m_context->versionFunctions<QOpenGLFunctions_4_3_Core>();
+  funcs->glBindBufferBase(GL_UNIFORM_BUFFER, m_binding, m_buffer.bufferId());
+}
+//-----------------------------------------------------------------------------------------------------
+bool UniformBuffer::isDirty() const noexcept
+{
+  return m_dirtyEnd > m_dirtyBegin;
+}
@@ -0,0 +1,24 @@
+TEMPLATE = app
+TARGET = brdflut
+
+OBJECTS_DIR = obj
+
+# Only QtCore is needed, for the directory helpers used by TextureFile
+QT = core
+CONFIG += console c++14 thread
+CONFIG -= app_bundle
+
+INCLUDEPATH += \
+    $$PWD/../../include
+
+HEADERS += \
+    ../../include/BrdfLut.h \
+    ../../include/HalfFloat.h \
+    ../../include/TextureFile.h \
+    ../../include/ThreadPool.h
+
+SOURCES += \
+    main.cpp \
+    ../../src/BrdfLut.cpp \
+    ../../src/TextureFile.cpp \
+    ../../src/ThreadPool.cpp
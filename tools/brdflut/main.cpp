@@ -0,0 +1,37 @@
+#include "BrdfLut.h"
+#include "ThreadPool.h"
+#include <iostream>
+#include <chrono>
+#include <string>
+#include <cstdlib>
+
+//-------------------------------------------------------------------------------------------------------
+/// @brief Writes the BRDF lookup table that ships in images/, run from the repository root.
+/// Usage: brdflut [output path] [dimension] [samples]
+//-------------------------------------------------------------------------------------------------------
+int main(int argc, char *argv[])
+{
+  const std::string path = argc > 1 ? argv[1] : BrdfLut::k_assetPath;
+  const int dim = argc > 2 ? std::atoi(argv[2]) : 512;
+  const unsigned samples = argc > 3 ? static_cast<unsigned>(std::atoi(argv[3])) : 1024u;
+  if (dim <= 0 || !samples)
+  {
+    std::cerr << "Usage: " << argv[0] << " [output path] [dimension] [samples]\n";
+    return EXIT_FAILURE;
+  }
+
+  using namespace std::chrono;
+  const auto start = high_resolution_clock::now();
+  ThreadPool pool;
+  const auto lut = BrdfLut::generate(dim, samples, pool);
+  const auto elapsed = duration_cast<milliseconds>(high_resolution_clock::now() - start).count();
+
+  if (!lut.save(path))
+  {
+    std::cerr << "Could not write " << path << '\n';
+    return EXIT_FAILURE;
+  }
+  std::cout << "Wrote " << dim << 'x' << dim << " RG16F table with " << samples << " samples to " << path
+            << " in " << elapsed << "ms on " << pool.size() << " threads\n";
+  return EXIT_SUCCESS;
+}
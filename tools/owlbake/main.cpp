@@ -0,0 +1,96 @@
+#include "OwlBake.h"
+#include "ImageMetrics.h"
+#include "HalfFloat.h"
+#include "ThreadPool.h"
+#include <iostream>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <cstdlib>
+
+namespace
+{
+//-----------------------------------------------------------------------------------------------------
+/// @brief Widens a half float texture, so it can be measured.
+//-----------------------------------------------------------------------------------------------------
+std::vector<float> toFloats(const TextureFile &_texture)
+{
+  const auto size = _texture.faceSize(0) / sizeof(uint16_t);
+  const auto halfs = reinterpret_cast<const uint16_t*>(_texture.data(0));
+  std::vector<float> floats(size);
+  for (size_t i = 0; i < size; ++i)
+    floats[i] = HalfFloat::toFloat(halfs[i]);
+  return floats;
+}
+
+//-----------------------------------------------------------------------------------------------------
+/// @brief Measures one bake against another, and fails if the PSNR is below the threshold. This lets CI
+/// catch changes to the noise, by comparing a fresh bake against a checked in reference.
+//-----------------------------------------------------------------------------------------------------
+int compare(const std::string &_testPath, const std::string &_referencePath, const double _minPsnr)
+{
+  TextureFile test, reference;
+  if (!test.load(_testPath) || !reference.load(_referencePath))
+  {
+    std::cerr << "Could not read " << _testPath << " or " << _referencePath << '\n';
+    return EXIT_FAILURE;
+  }
+  if (test.faceSize(0) != reference.faceSize(0) || test.header().m_pixelType != reference.header().m_pixelType)
+  {
+    std::cerr << "The textures have different sizes or formats\n";
+    return EXIT_FAILURE;
+  }
+  const auto testValues = toFloats(test);
+  const auto referenceValues = toFloats(reference);
+  const auto error = ImageMetrics::compare(testValues.data(), referenceValues.data(), testValues.size());
+  std::cout << "RMSE " << error.m_rmse << ", relative RMSE " << error.m_relativeRmse
+            << ", PSNR " << error.m_psnr << " dB\n";
+  return error.m_psnr >= _minPsnr ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+}
+
+//-------------------------------------------------------------------------------------------------------
+/// @brief Bakes the owl's dense albedo and normal volumes on the CPU, or compares two bakes.
+/// Usage: owlbake [albedo path] [normal path] [dimension]
+///        owlbake --compare <test path> <reference path> [minimum PSNR]
+//-------------------------------------------------------------------------------------------------------
+int main(int argc, char *argv[])
+{
+  if (argc > 1 && std::string(argv[1]) == "--compare")
+  {
+    if (argc < 4)
+    {
+      std::cerr << "Usage: " << argv[0] << " --compare <test path> <reference path> [minimum PSNR]\n";
+      return EXIT_FAILURE;
+    }
+    return compare(argv[2], argv[3], argc > 4 ? std::atof(argv[4]) : 40.0);
+  }
+
+  const std::string albedoPath = argc > 1 ? argv[1] : "cache/owl/albedo.tex";
+  const std::string normalPath = argc > 2 ? argv[2] : "cache/owl/normal.tex";
+  const int dim = argc > 3 ? std::atoi(argv[3]) : 512;
+  if (dim <= 0)
+  {
+    std::cerr << "Usage: " << argv[0] << " [albedo path] [normal path] [dimension]\n";
+    return EXIT_FAILURE;
+  }
+
+  using namespace std::chrono;
+  const auto start = high_resolution_clock::now();
+  ThreadPool pool;
+  const auto albedo = OwlBake::albedo(dim, OwlNoise::defaultPalette(), pool);
+  const auto albedoTime = high_resolution_clock::now();
+  const auto normals = OwlBake::normals(albedo, pool);
+  const auto end = high_resolution_clock::now();
+
+  if (!albedo.save(albedoPath) || !normals.save(normalPath))
+  {
+    std::cerr << "Could not write " << albedoPath << " or " << normalPath << '\n';
+    return EXIT_FAILURE;
+  }
+  std::cout << "Wrote " << dim << "^3 RGBA16F albedo and normal volumes in "
+            << duration_cast<milliseconds>(albedoTime - start).count() << "ms and "
+            << duration_cast<milliseconds>(end - albedoTime).count() << "ms, on " << pool.size()
+            << " threads with " << OwlNoise::instructionSet() << " lanes\n";
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,34 @@
+TEMPLATE = app
+TARGET = owlbake
+
+OBJECTS_DIR = obj
+
+# Only QtCore is needed, for the directory helpers used by TextureFile
+QT = core
+CONFIG += console c++14 thread
+CONFIG -= app_bundle
+
+# The noise runs in AVX2 or SSE lanes depending on what the compiler targets, build on the machine that
+# will run the bake, or pass a lower -march for a mixed farm
+QMAKE_CXXFLAGS_RELEASE += -march=native
+
+INCLUDEPATH += \
+    /usr/local/include/glm/glm \
+    /usr/local/include/glm \
+    $$PWD/../../include
+
+HEADERS += \
+    ../../include/OwlNoise.h \
+    ../../include/OwlBake.h \
+    ../../include/ImageMetrics.h \
+    ../../include/HalfFloat.h \
+    ../../include/TextureFile.h \
+    ../../include/ThreadPool.h
+
+SOURCES += \
+    main.cpp \
+    ../../src/OwlNoise.cpp \
+    ../../src/OwlBake.cpp \
+    ../../src/ImageMetrics.cpp \
+    ../../src/TextureFile.cpp \
+    ../../src/ThreadPool.cpp